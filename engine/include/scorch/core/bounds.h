@@ -0,0 +1,67 @@
+#pragma once
+
+namespace SC
+{
+	//Axis aligned bounding box, a default constructed box is empty and grows as points or boxes are added to it
+	struct AABB
+	{
+		glm::vec3 min{ std::numeric_limits<float>::max() };
+		glm::vec3 max{ std::numeric_limits<float>::lowest() };
+
+		AABB() = default;
+		AABB(const glm::vec3& min, const glm::vec3& max) : min(min), max(max) {}
+
+		bool IsEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+		glm::vec3 Center() const { return (min + max) * 0.5f; }
+		glm::vec3 Extents() const { return (max - min) * 0.5f; } //Half the size on each axis
+
+		float SurfaceArea() const
+		{
+			if (IsEmpty()) return 0.0f;
+			const glm::vec3 size = max - min;
+			return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+		}
+
+		//Touching boxes overlap, empty boxes never do
+		bool Overlaps(const AABB& other) const
+		{
+			return min.x <= other.max.x && max.x >= other.min.x &&
+				min.y <= other.max.y && max.y >= other.min.y &&
+				min.z <= other.max.z && max.z >= other.min.z &&
+				!IsEmpty() && !other.IsEmpty();
+		}
+
+		void Expand(const glm::vec3& point)
+		{
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		void Expand(const AABB& other)
+		{
+			min = glm::min(min, other.min);
+			max = glm::max(max, other.max);
+		}
+
+		//Smallest box enclosing this box after it has been transformed
+		AABB Transformed(const glm::mat4& transform) const;
+	};
+
+	struct BoundingSphere
+	{
+		glm::vec3 center{ 0.0f };
+		float radius{ 0.0f };
+	};
+
+	//Boxes stored as one array per component so several boxes can be tested at once with SIMD
+	struct AABBArray
+	{
+		std::vector<float> minX, minY, minZ;
+		std::vector<float> maxX, maxY, maxZ;
+
+		void Add(const AABB& bounds);
+		void Set(uint32_t index, const AABB& bounds);
+		void Clear();
+		uint32_t Size() const { return static_cast<uint32_t>(minX.size()); }
+	};
+}
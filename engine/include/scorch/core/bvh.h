@@ -0,0 +1,90 @@
+#pragma once
+#include "scorch/core/bounds.h"
+#include "scorch/core/frustum.h"
+#include "scorch/core/ray.h"
+#include "scorch/core/utils.h"
+#include <atomic>
+
+namespace SC
+{
+	class ThreadPool;
+
+	//Bounding volume hierarchy over a set of boxes, each box is a primitive identified by its index in the array given to Build.
+	//The tree is built top down with a binned surface area heuristic and stored in a flat array, the two children of a node are
+	//next to each other and always stored after their parent. Moving primitives can be refit without rebuilding, this keeps
+	//queries correct but the tree gets less efficient the further primitives move from where they were at build time
+	class BVH
+	{
+	public:
+		static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+		struct Node
+		{
+			AABB bounds;
+			uint32_t first; //Internal nodes: left child, the right child is first + 1. Leaves: first primitive slot
+			uint32_t count; //Primitive count for leaves, 0 for internal nodes
+
+			bool IsLeaf() const { return count > 0; }
+		};
+
+		BVH();
+
+		BVH(const BVH&) = delete;
+		BVH& operator=(const BVH&) = delete;
+
+		//When a thread pool is given large builds are split into subtrees that are built in parallel
+		void Build(const AABB* bounds, uint32_t count, ThreadPool* threadPool = nullptr);
+		void Clear();
+
+		//Updates the given primitives from bounds and the nodes above them
+		void Refit(const AABB* bounds, const uint32_t* primitives, uint32_t primitiveCount);
+		//Updates every primitive and node from bounds, cheaper than the above when most primitives have moved
+		void Refit(const AABB* bounds);
+
+		//Appends the primitives whose box intersects the frustum, subtrees outside it are skipped and subtrees inside it are
+		//accepted without testing their children. Returns the number of boxes tested
+		uint32_t Query(const Frustum& frustum, std::vector<uint32_t>& primitives) const;
+		//Appends the primitives whose box overlaps bounds, returns the number of boxes tested
+		uint32_t Query(const AABB& bounds, std::vector<uint32_t>& primitives) const;
+		//Visits the primitives whose box the ray hits within maxDistance, nearer subtrees first. visit is given the primitive and the
+		//current max distance and returns the new one, returning the distance of a hit skips everything behind it so closest hit
+		//queries only test a few primitives. Returns the number of boxes tested
+		uint32_t Raycast(const Ray& ray, float maxDistance, FunctionRef<float(uint32_t primitive, float maxDistance)> visit) const;
+
+		//Primitives of a leaf are stored in the slots [first, first + count)
+		uint32_t PrimitiveAt(uint32_t slot) const;
+		const AABB& PrimitiveBounds(uint32_t slot) const;
+
+		const std::vector<Node>& Nodes() const;
+		uint32_t PrimitiveCount() const;
+	private:
+		struct BuildTask
+		{
+			uint32_t node;
+			uint32_t depth;
+		};
+
+		bool Split(uint32_t nodeIndex, uint32_t depth, const AABB* bounds);
+		void BuildSubtree(uint32_t nodeIndex, uint32_t depth, const AABB* bounds);
+		void UpdateNodeBounds(uint32_t nodeIndex);
+	private:
+		std::vector<Node> m_nodes;
+		std::vector<uint32_t> m_parents; //Indexed by node
+
+		//Indexed by slot, primitives are sorted so each leaf's primitives are contiguous
+		std::vector<uint32_t> m_primitives;
+		std::vector<AABB> m_primitiveBounds;
+
+		//Indexed by primitive
+		std::vector<uint32_t> m_primitiveSlots;
+		std::vector<uint32_t> m_primitiveLeaves;
+
+		//Scratch for building and refitting
+		std::vector<glm::vec3> m_centroids;
+		std::atomic<uint32_t> m_nodeCount;
+		std::vector<BuildTask> m_buildTasks;
+		std::vector<BuildTask> m_buildStack;
+		std::vector<uint32_t> m_refitNodes;
+		std::vector<uint8_t> m_refitVisited;
+	};
+}
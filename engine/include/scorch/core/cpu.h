@@ -0,0 +1,38 @@
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SCORCH_SIMD_X86 1
+#endif
+
+//Functions using instructions above the build's baseline need to be tagged on gcc/clang, msvc allows them anywhere
+#if defined(SCORCH_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SCORCH_TARGET_SSE __attribute__((target("sse2")))
+#define SCORCH_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SCORCH_TARGET_SSE
+#define SCORCH_TARGET_AVX2
+#endif
+
+namespace SC
+{
+	enum class SimdLevel : uint8_t
+	{
+		SCALAR,
+		SSE,
+		AVX2,
+	};
+
+	const char* SimdLevelToString(SimdLevel level);
+
+	class Cpu
+	{
+	public:
+		//Highest instruction set supported by both the CPU and the build
+		static SimdLevel SupportedSimdLevel();
+
+		//Level the engine's SIMD kernels dispatch to, defaults to the supported level
+		static SimdLevel ActiveSimdLevel();
+		//Clamped to the supported level, mainly used to compare kernels
+		static void SetActiveSimdLevel(SimdLevel level);
+	};
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <map>
+
+namespace SC
+{
+	//Hands out ranges of [0, capacity) in whatever unit the caller uses, e.g. vertices of a buffer. It only tracks offsets,
+	//the memory itself belongs to the caller. Free ranges are kept sorted by offset and merged with their neighbours when
+	//freed, allocations take the first free range they fit in
+	class FreeListAllocator
+	{
+	public:
+		static constexpr uint32_t INVALID_OFFSET = std::numeric_limits<uint32_t>::max();
+
+		FreeListAllocator(uint32_t capacity = 0);
+
+		//Returns INVALID_OFFSET when no free range is large enough
+		uint32_t Allocate(uint32_t size);
+		//offset and size have to be a range returned by Allocate
+		void Free(uint32_t offset, uint32_t size);
+		//Frees everything
+		void Reset();
+
+		uint32_t Capacity() const;
+		uint32_t Used() const;
+		//Largest size Allocate can currently succeed with
+		uint32_t LargestFreeRange() const;
+	private:
+		std::map<uint32_t, uint32_t> m_freeRanges; //Offset to size
+		uint32_t m_capacity;
+		uint32_t m_used;
+	};
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "scorch/core/bounds.h"
+#include "scorch/core/cpu.h"
+
+namespace SC
+{
+	enum class FrustumTest : uint8_t
+	{
+		OUTSIDE,
+		INTERSECTS,
+		INSIDE,
+	};
+
+	//Six world space planes of a view frustum, a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for every plane.
+	//The overloads of Cull without a SimdLevel use Cpu::ActiveSimdLevel()
+	class Frustum
+	{
+	public:
+		static constexpr uint32_t PLANE_COUNT = 6;
+
+		//Contains everything
+		Frustum();
+		//Extracts the planes from a projection * view matrix, the order is left, right, bottom, top, near, far
+		explicit Frustum(const glm::mat4& viewProjection);
+
+		const glm::vec4& Plane(uint32_t index) const;
+
+		//Conservative test, boxes close to the edges of the frustum can pass without being inside it. Empty or inverted boxes never
+		//pass, even when the frustum contains everything
+		bool Intersects(const AABB& bounds) const;
+		//Same test as Intersects but also reports boxes that are completely inside, so hierarchies can skip testing their children
+		FrustumTest Classify(const AABB& bounds) const;
+
+		//Writes the indices of the boxes that pass Intersects to visibleIndices in ascending order and returns how many passed.
+		//visibleIndices needs room for bounds.Size() indices. SSE tests 4 boxes at a time and AVX2 8 boxes at a time
+		uint32_t Cull(const AABBArray& bounds, uint32_t* visibleIndices) const;
+		uint32_t Cull(const AABBArray& bounds, uint32_t* visibleIndices, SimdLevel level) const;
+	private:
+		std::array<glm::vec4, PLANE_COUNT> m_planes;
+	};
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "scorch/core/bounds.h"
+
+namespace SC
+{
+	//Half line from origin along direction, distances along the ray are in units of the direction's length
+	struct Ray
+	{
+		glm::vec3 origin{ 0.0f };
+		glm::vec3 direction{ 0.0f, 0.0f, -1.0f };
+
+		Ray() = default;
+		Ray(const glm::vec3& origin, const glm::vec3& direction) : origin(origin), direction(direction) {}
+
+		glm::vec3 At(float distance) const { return origin + direction * distance; }
+
+		//The affine part of the transform is applied so distances along the transformed ray match distances along this one
+		Ray Transformed(const glm::mat4& transform) const;
+
+		//Ray from the eye through a pixel, (0, 0) is the top left of the viewport. The projection is expected to use Vulkan's
+		//clip space where y points down, like the view projection matrices the scene is rendered with
+		static Ray FromScreenPoint(float x, float y, float width, float height, const glm::mat4& viewProjection);
+	};
+
+	//Returns the distance along the ray to where it enters the box, 0 when it starts inside the box, or a negative value when it
+	//misses the box or only hits it further than maxDistance. inverseDirection is 1 / ray.direction, so many boxes can share it.
+	//Empty boxes are always missed
+	inline float IntersectRayAABB(const glm::vec3& origin, const glm::vec3& inverseDirection, const AABB& bounds, float maxDistance)
+	{
+		if (bounds.IsEmpty()) return -1.0f;
+
+		const glm::vec3 t0 = (bounds.min - origin) * inverseDirection;
+		const glm::vec3 t1 = (bounds.max - origin) * inverseDirection;
+		const glm::vec3 tNear = glm::min(t0, t1);
+		const glm::vec3 tFar = glm::max(t0, t1);
+
+		const float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		const float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+		return enter <= exit ? enter : -1.0f;
+	}
+
+	//Möller-Trumbore, hits the front and back of the triangle. On a hit distance is along the ray and barycentric holds the
+	//weights of v1 and v2
+	bool IntersectRayTriangle(const Ray& ray, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& distance, glm::vec2& barycentric);
+}
@@ -1,13 +1,133 @@
 #pragma once
 #include "scorch/render/mesh.h"
+#include "scorch/core/slabPool.h"
+#include "scorch/core/bounds.h"
 #include "xutility"
 
-namespace SC 
+namespace SC
 {
+	struct SceneNode;
+	class SceneGraph;
+	class ThreadPool;
+
+	//TransformHierarchy holds the local and world transforms of every node in a tree in contiguous arrays.
+	//The arrays are kept in depth first order so a parent is always stored before its children and each subtree
+	//is a contiguous range, this allows the whole tree (or any subtree) to be updated with a single linear sweep.
+	//Nodes are addressed by a stable NodeId, the array index of a node changes when the order gets rebuilt.
+	//Changing a node marks it dirty and Update only recomputes the subtrees of dirty nodes.
+	//Each node also has local bounds for its own geometry and a world space box enclosing its whole subtree, the boxes are
+	//updated with the matrices and the boxes of the ancestors of updated nodes are refreshed afterwards.
+	class TransformHierarchy
+	{
+	public:
+		using NodeId = uint32_t;
+		static constexpr NodeId INVALID_NODE = std::numeric_limits<NodeId>::max();
+
+		TransformHierarchy();
+
+		NodeId Add(SceneNode* node, NodeId parent);
+		void Remove(NodeId id);
+		void SetParent(NodeId id, NodeId parent);
+
+		void SetPosition(NodeId id, const glm::vec3& position);
+		const glm::vec3& Position(NodeId id) const;
+		void SetRotation(NodeId id, const glm::quat& rotation);
+		const glm::quat& Rotation(NodeId id) const;
+		void SetScale(NodeId id, const glm::vec3& scale);
+		const glm::vec3& Scale(NodeId id) const;
+
+		//Flags the node so its subtree gets recomputed on the next Update
+		void MarkDirty(NodeId id);
+
+		const glm::mat4& LocalMatrix(NodeId id) const;
+		const glm::mat4& WorldMatrix(NodeId id) const;
+
+		//Local space bounds of the node's own geometry, nodes without geometry keep an empty box
+		void SetLocalBounds(NodeId id, const AABB& bounds);
+		const AABB& LocalBounds(NodeId id) const;
+		//World space bounds of the node's own geometry, computed from the local bounds and the world matrix
+		AABB WorldBounds(NodeId id) const;
+		//World space bounds of the node and all of its descendants
+		const AABB& SubtreeBounds(NodeId id) const;
+
+		//Updates the dirty matrices of the node and all of its descendants, INVALID_NODE updates the whole hierarchy
+		//When a thread pool is given large updates are split into independent subtrees that are computed in parallel,
+		//each matrix is computed the same way as the serial path so the results are identical
+		void Update(NodeId root = INVALID_NODE, ThreadPool* threadPool = nullptr);
+
+		uint32_t NodeCount() const;
+		//Number of matrices recomputed by the last call to Update
+		uint32_t UpdatedMatrixCount() const;
+
+		//Index ranges recomputed by the last call to Update, valid until nodes are added, removed or re-parented
+		const std::vector<std::pair<uint32_t, uint32_t>>& UpdatedRanges() const;
+		NodeId IdAt(uint32_t index) const;
+
+		//Incremented whenever nodes are added, removed or re-parented
+		uint32_t StructureVersion() const;
+		//Incremented by every call to Update that recomputes anything, lets structures built over the world bounds
+		//tell whether UpdatedRanges covers everything that changed since they were last refreshed
+		uint32_t UpdateVersion() const;
+	private:
+		uint32_t Index(NodeId id) const;
+		void RebuildOrder();
+		template<typename T>
+		void ApplyOrder(std::vector<T>& values, size_t newSize);
+		void UpdateRange(uint32_t begin, uint32_t end);
+		void UpdateAncestorBounds();
+		void GatherSubtreeBounds(uint32_t index);
+		void UpdateParallel(ThreadPool& threadPool, uint32_t matrixCount);
+		void SplitRange(uint32_t begin, uint32_t end, uint32_t jobSize);
+	private:
+		//Indexed by NodeId
+		std::vector<uint32_t> m_idToIndex;
+		std::vector<SceneNode*> m_nodes;
+		std::vector<NodeId> m_freeIds;
+		std::vector<uint8_t> m_dirtyFlags;
+
+		std::vector<NodeId> m_dirtyNodes;
+		std::vector<uint32_t> m_dirtyScratch; //Reused each update to avoid allocating
+		uint32_t m_updatedMatrixCount;
+		uint32_t m_structureVersion;
+		uint32_t m_updateVersion;
+
+		//Scratch for parallel updates, subtree ranges to sweep and the split roots that are computed before them
+		std::vector<std::pair<uint32_t, uint32_t>> m_updateRanges;
+		std::vector<std::pair<uint32_t, uint32_t>> m_jobRanges;
+		std::vector<uint32_t> m_splitNodes;
+		std::vector<std::pair<uint32_t, uint32_t>> m_splitStack;
+
+		//Nodes whose subtree bounds must be rebuilt from their children, e.g. after a child was removed
+		std::vector<NodeId> m_boundsDirtyNodes;
+		std::vector<uint32_t> m_boundsRefresh;
+		std::vector<uint8_t> m_boundsVisited;
+
+		//Scratch for rebuilding the order
+		std::vector<uint32_t> m_rebuildOrder; //New index to old index
+		std::vector<uint32_t> m_rebuildParents;
+		std::vector<uint8_t> m_rebuildVisited;
+		std::vector<std::pair<SceneNode*, uint32_t>> m_rebuildStack;
+
+		//Indexed by position in the hierarchy
+		std::vector<NodeId> m_indexToId;
+		std::vector<uint32_t> m_parents;
+		std::vector<uint32_t> m_subtreeEnds; //One past the last descendant of the node
+		std::vector<glm::vec3> m_positions;
+		std::vector<glm::quat> m_rotations;
+		std::vector<glm::vec3> m_scales;
+		std::vector<glm::mat4> m_localMatrices;
+		std::vector<glm::mat4> m_worldMatrices;
+		std::vector<AABB> m_localBounds;
+		std::vector<AABB> m_subtreeBounds;
+
+		bool m_orderDirty; //Set when nodes are added, removed or re-parented
+	};
+
+	//Transform is a view of a single node inside a TransformHierarchy
 	struct Transform
 	{
 	public:
-		Transform();
+		Transform(TransformHierarchy* hierarchy, TransformHierarchy::NodeId id);
 
 		void Translate(const glm::vec3& translate);
 		void SetPosition(const glm::vec3& position);
@@ -23,51 +143,169 @@ namespace SC
 
 		glm::mat4 ModelMatrix() const;
 	private:
-		glm::vec3 position;
-		glm::vec3 scale;
-		glm::quat rotation;
+		TransformHierarchy* m_hierarchy;
+		TransformHierarchy::NodeId m_id;
 	};
 
+	using SceneNodeHandle = PoolHandle;
+
+	//Returned by traversal visitors, visitors that return void always continue
+	enum class TraversalResult : uint8_t
+	{
+		CONTINUE,
+		SKIP_CHILDREN,
+		STOP,
+	};
+
+	//SceneNodes are allocated from their SceneGraph's pool, use AddChild to create them and Remove to destroy them.
+	//Children are linked intrusively through pool indices so adding, removing and walking nodes doesn't allocate
 	struct SceneNode
 	{
+		friend class TransformHierarchy;
+		friend class SceneGraph;
 
-		SceneNode();
+		//Called by the SceneGraph's pool, parent is null for the root
+		SceneNode(SceneNodeHandle handle, SceneGraph* graph, SceneNode* parent);
 		~SceneNode();
 
-		template<typename... TArgs>
-		std::shared_ptr<SceneNode> AddChild(const TArgs&... args);
+		SceneNode(const SceneNode&) = delete;
+		SceneNode& operator=(const SceneNode&) = delete;
+
+		SceneNode& AddChild();
 
+		//Destroys the node and all of its children, removing the root only removes its children
 		void Remove();
 		void SetParent(SceneNode& parent);
 
-		const std::list<std::shared_ptr<SceneNode>>& Children() const;
+		SceneNode* Parent() const;
+		SceneNode* FirstChild() const;
+		SceneNode* NextSibling() const;
+
+		SceneNodeHandle Handle() const;
+		TransformHierarchy::NodeId Id() const;
 
 		RenderObject& GetRenderObject();
 
-		void UpdateSelfAndChildren();
+		void UpdateSelfAndChildren(ThreadPool* threadPool = nullptr);
 
-		void TraverseTree(std::function<void(SceneNode& node)> func);
+		//Visits the node and its descendants depth first, a parent is always visited before its children and
+		//children are visited in the order they were added. Walks the intrusive links so it never allocates,
+		//the tree must not be changed during the traversal
+		template<typename TVisitor>
+		void TraverseTree(TVisitor&& visitor);
 
 		Transform& GetTransform();
 
 		//Cached model matrix, call UpdateSelfAndChildren to ensure is updated
+		//The reference is only valid until nodes are added, removed or re-parented
 		const glm::mat4& ModelMatrix() const;
 
+		//Local bounds of the node's geometry, set them when a mesh is assigned to the render object
+		void SetLocalBounds(const AABB& bounds);
+		//World space bounds of the node's geometry and of its whole subtree, updated with the model matrix
+		AABB WorldBounds() const;
+		const AABB& SubtreeBounds() const;
+
+		const TransformHierarchy& Hierarchy() const;
+
 	private:
-		std::list<std::shared_ptr<SceneNode>> m_children;
-		SceneNode* m_parent;
+		SceneGraph* m_graph;
+		SceneNodeHandle m_handle;
+		TransformHierarchy::NodeId m_id;
+
+		//Pool indices, PoolHandle::INVALID_INDEX when not set
+		uint32_t m_parent;
+		uint32_t m_firstChild;
+		uint32_t m_lastChild;
+		uint32_t m_nextSibling;
+		uint32_t m_prevSibling;
+
 		Transform m_transform;
-		glm::mat4 modelMatrix;
 
 		RenderObject m_renderObject;
 	};
 
-	template<typename... TArgs>
-	std::shared_ptr<SceneNode> SC::SceneNode::AddChild(const TArgs&... args)
+	//SceneGraph owns the node pool and transform hierarchy of a tree of SceneNodes, it always has a root node
+	class SceneGraph
+	{
+	public:
+		SceneGraph();
+		~SceneGraph();
+
+		SceneGraph(const SceneGraph&) = delete;
+		SceneGraph& operator=(const SceneGraph&) = delete;
+
+		SceneNode& Root();
+		const SceneNode& Root() const;
+
+		//Returns nullptr if the node has been removed
+		SceneNode* Get(SceneNodeHandle handle);
+
+		const TransformHierarchy& Hierarchy() const;
+
+		uint32_t NodeCount() const;
+	private:
+		friend struct SceneNode;
+
+		SceneNode& CreateNode(SceneNode* parent);
+		void RemoveNode(SceneNode& node);
+		void SetParent(SceneNode& node, SceneNode& parent);
+
+		void Link(SceneNode& node, SceneNode& parent);
+		void Unlink(SceneNode& node);
+
+		SceneNode* NodeAt(uint32_t index);
+	private:
+		TransformHierarchy m_hierarchy; //Declared before the pool so it outlives the nodes
+		SlabPool<SceneNode> m_nodes;
+		SceneNodeHandle m_root;
+
+		std::vector<uint32_t> m_removeScratch; //Reused when removing subtrees
+	};
+
+	inline SceneNode* SceneGraph::NodeAt(uint32_t index)
+	{
+		return &m_nodes.At(index);
+	}
+
+	inline SceneNode* SceneNode::Parent() const
+	{
+		return m_parent != PoolHandle::INVALID_INDEX ? m_graph->NodeAt(m_parent) : nullptr;
+	}
+
+	inline SceneNode* SceneNode::FirstChild() const
 	{
-		m_children.emplace_back(std::make_shared<SceneNode>(args...));
-		m_children.back()->m_parent = this;
-		return m_children.back();
+		return m_firstChild != PoolHandle::INVALID_INDEX ? m_graph->NodeAt(m_firstChild) : nullptr;
 	}
 
-}
\ No newline at end of file
+	inline SceneNode* SceneNode::NextSibling() const
+	{
+		return m_nextSibling != PoolHandle::INVALID_INDEX ? m_graph->NodeAt(m_nextSibling) : nullptr;
+	}
+
+	template<typename TVisitor>
+	void SceneNode::TraverseTree(TVisitor&& visitor)
+	{
+		SceneNode* node = this;
+		while (node)
+		{
+			TraversalResult result = TraversalResult::CONTINUE;
+			if constexpr (std::is_void_v<std::invoke_result_t<TVisitor&, SceneNode&>>)
+				visitor(*node);
+			else
+				result = visitor(*node);
+
+			if (result == TraversalResult::STOP)
+				return;
+
+			//Go down to the first child, otherwise to the next sibling of the node or its closest ancestor without leaving this subtree
+			SceneNode* next = result == TraversalResult::CONTINUE ? node->FirstChild() : nullptr;
+			while (!next && node != this)
+			{
+				next = node->NextSibling();
+				node = node->Parent();
+			}
+			node = next;
+		}
+	}
+}
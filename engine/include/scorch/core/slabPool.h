@@ -0,0 +1,149 @@
+#pragma once
+#include <optional>
+
+namespace SC
+{
+	//Handle to an object in a SlabPool, the generation detects handles to objects that have since been freed
+	struct PoolHandle
+	{
+		static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+		uint32_t index{ INVALID_INDEX };
+		uint32_t generation{ 0 };
+
+		bool IsValid() const { return index != INVALID_INDEX; }
+		bool operator==(const PoolHandle& other) const { return index == other.index && generation == other.generation; }
+		bool operator!=(const PoolHandle& other) const { return !(*this == other); }
+	};
+
+	//SlabPool stores objects in fixed size chunks so their addresses never change, freed slots are reused before a new chunk is allocated
+	template<typename T, uint32_t ChunkSize = 256>
+	class SlabPool
+	{
+	public:
+		SlabPool() : m_freeHead(PoolHandle::INVALID_INDEX), m_size(0) {}
+		~SlabPool() { Clear(); }
+
+		SlabPool(const SlabPool&) = delete;
+		SlabPool& operator=(const SlabPool&) = delete;
+
+		//The handle is passed to the constructor first so objects can know their own handle
+		template<typename... TArgs>
+		PoolHandle Allocate(TArgs&&... args);
+		void Free(PoolHandle handle);
+		void Clear();
+
+		//Returns nullptr if the handle is stale
+		T* Get(PoolHandle handle);
+		const T* Get(PoolHandle handle) const;
+
+		//Only valid for indices of live objects
+		T& At(uint32_t index);
+		const T& At(uint32_t index) const;
+
+		uint32_t Size() const { return m_size; }
+		uint32_t Capacity() const { return static_cast<uint32_t>(m_chunks.size()) * ChunkSize; }
+	private:
+		struct Slot
+		{
+			std::optional<T> object;
+			uint32_t generation{ 0 };
+			uint32_t nextFree{ PoolHandle::INVALID_INDEX };
+		};
+
+		Slot& SlotAt(uint32_t index) { return m_chunks[index / ChunkSize][index % ChunkSize]; }
+		const Slot& SlotAt(uint32_t index) const { return m_chunks[index / ChunkSize][index % ChunkSize]; }
+	private:
+		std::vector<std::unique_ptr<Slot[]>> m_chunks;
+		uint32_t m_freeHead;
+		uint32_t m_size;
+	};
+
+	template<typename T, uint32_t ChunkSize>
+	template<typename... TArgs>
+	PoolHandle SlabPool<T, ChunkSize>::Allocate(TArgs&&... args)
+	{
+		if (m_freeHead == PoolHandle::INVALID_INDEX)
+		{
+			//Thread the new chunk's slots onto the free list
+			const uint32_t first = Capacity();
+			m_chunks.emplace_back(std::make_unique<Slot[]>(ChunkSize));
+			for (uint32_t i = 0; i < ChunkSize; ++i)
+			{
+				m_chunks.back()[i].nextFree = i + 1 < ChunkSize ? first + i + 1 : PoolHandle::INVALID_INDEX;
+			}
+			m_freeHead = first;
+		}
+
+		const uint32_t index = m_freeHead;
+		Slot& slot = SlotAt(index);
+		m_freeHead = slot.nextFree;
+
+		PoolHandle handle{ index, slot.generation };
+		slot.object.emplace(handle, std::forward<TArgs>(args)...);
+		++m_size;
+
+		return handle;
+	}
+
+	template<typename T, uint32_t ChunkSize>
+	void SlabPool<T, ChunkSize>::Free(PoolHandle handle)
+	{
+		CORE_ASSERT(Get(handle), "Freeing an invalid handle");
+		if (!Get(handle)) return;
+
+		Slot& slot = SlotAt(handle.index);
+		slot.object.reset();
+		++slot.generation;
+		slot.nextFree = m_freeHead;
+		m_freeHead = handle.index;
+		--m_size;
+	}
+
+	template<typename T, uint32_t ChunkSize>
+	void SlabPool<T, ChunkSize>::Clear()
+	{
+		for (auto& chunk : m_chunks)
+		{
+			for (uint32_t i = 0; i < ChunkSize; ++i)
+			{
+				chunk[i].object.reset();
+			}
+		}
+		m_chunks.clear();
+		m_freeHead = PoolHandle::INVALID_INDEX;
+		m_size = 0;
+	}
+
+	template<typename T, uint32_t ChunkSize>
+	T* SlabPool<T, ChunkSize>::Get(PoolHandle handle)
+	{
+		if (handle.index >= Capacity()) return nullptr;
+
+		Slot& slot = SlotAt(handle.index);
+		return slot.generation == handle.generation && slot.object ? &*slot.object : nullptr;
+	}
+
+	template<typename T, uint32_t ChunkSize>
+	const T* SlabPool<T, ChunkSize>::Get(PoolHandle handle) const
+	{
+		if (handle.index >= Capacity()) return nullptr;
+
+		const Slot& slot = SlotAt(handle.index);
+		return slot.generation == handle.generation && slot.object ? &*slot.object : nullptr;
+	}
+
+	template<typename T, uint32_t ChunkSize>
+	T& SlabPool<T, ChunkSize>::At(uint32_t index)
+	{
+		CORE_ASSERT(index < Capacity() && SlotAt(index).object, "Index is not a live object");
+		return *SlotAt(index).object;
+	}
+
+	template<typename T, uint32_t ChunkSize>
+	const T& SlabPool<T, ChunkSize>::At(uint32_t index) const
+	{
+		CORE_ASSERT(index < Capacity() && SlotAt(index).object, "Index is not a live object");
+		return *SlotAt(index).object;
+	}
+}
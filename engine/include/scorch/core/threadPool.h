@@ -0,0 +1,47 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "scorch/core/utils.h"
+
+namespace SC
+{
+	//ThreadPool keeps a fixed set of worker threads alive to split data parallel work across.
+	//ParallelFor is blocking and the calling thread takes jobs as well, it must only be called from one thread at a time.
+	class ThreadPool
+	{
+	public:
+		//Defaults to one worker less than the hardware threads as the calling thread also runs jobs
+		explicit ThreadPool(uint32_t workerCount = DefaultWorkerCount());
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		//Worker threads plus the calling thread
+		uint32_t ThreadCount() const;
+
+		//Runs func(index) for every index in [0, count) and returns once all of them have finished. Only a reference to func
+		//is kept since it is blocking, so passing a lambda never allocates
+		void ParallelFor(uint32_t count, FunctionRef<void(uint32_t index)> func);
+
+		static uint32_t DefaultWorkerCount();
+	private:
+		void WorkerLoop();
+		void RunJobs(FunctionRef<void(uint32_t)> func, uint32_t count);
+	private:
+		std::vector<std::thread> m_workers;
+
+		std::mutex m_mutex;
+		std::condition_variable m_jobAvailable;
+		std::condition_variable m_jobsFinished;
+
+		const FunctionRef<void(uint32_t)>* m_job;
+		uint32_t m_jobCount;
+		std::atomic<uint32_t> m_nextIndex;
+		uint32_t m_activeWorkers;
+		uint64_t m_generation; //Incremented for every ParallelFor so workers know there is new work
+		bool m_stopping;
+	};
+}
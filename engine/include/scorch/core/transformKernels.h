@@ -0,0 +1,24 @@
+#pragma once
+#include "scorch/core/cpu.h"
+#include <glm/gtx/quaternion.hpp>
+
+namespace SC
+{
+	//Batched transform math used by the TransformHierarchy, each function has a scalar, SSE and AVX2 path.
+	//The overloads without a SimdLevel use Cpu::ActiveSimdLevel()
+	class TransformKernels
+	{
+	public:
+		//matrices[i] = translate(positions[i]) * toMat4(rotations[i]) * scale(scales[i])
+		//SSE composes 4 nodes at a time and AVX2 8 nodes at a time
+		static void ComposeMatrices(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* matrices, uint32_t count);
+		static void ComposeMatrices(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* matrices, uint32_t count, SimdLevel level);
+
+		//worldMatrices[i] = worldMatrices[parents[i]] * localMatrices[i] for i in [begin, end), parents that are INVALID_PARENT copy the local matrix.
+		//Parents must be stored before their children, a parent inside the range is used after it has been computed
+		static void MultiplyParents(const uint32_t* parents, const glm::mat4* localMatrices, glm::mat4* worldMatrices, uint32_t begin, uint32_t end);
+		static void MultiplyParents(const uint32_t* parents, const glm::mat4* localMatrices, glm::mat4* worldMatrices, uint32_t begin, uint32_t end, SimdLevel level);
+
+		static constexpr uint32_t INVALID_PARENT = std::numeric_limits<uint32_t>::max();
+	};
+}
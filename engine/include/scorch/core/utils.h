@@ -10,4 +10,38 @@ namespace SC
 
 		void flush();
 	};
+
+	//Rounds value up to a multiple of alignment, which has to be a power of two
+	constexpr size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	//Non owning reference to a callable, unlike std::function it never allocates. The callable must outlive the FunctionRef
+	template<typename TSignature>
+	class FunctionRef;
+
+	template<typename TReturn, typename... TArgs>
+	class FunctionRef<TReturn(TArgs...)>
+	{
+	public:
+		template<typename TCallable, typename = std::enable_if_t<!std::is_same_v<std::decay_t<TCallable>, FunctionRef>>>
+		FunctionRef(TCallable&& callable) :
+			m_callable(const_cast<void*>(static_cast<const void*>(std::addressof(callable)))),
+			m_invoke([](void* callable, TArgs... args) -> TReturn
+				{
+					return (*static_cast<std::add_pointer_t<TCallable>>(callable))(std::forward<TArgs>(args)...);
+				})
+		{
+
+		}
+
+		TReturn operator()(TArgs... args) const
+		{
+			return m_invoke(m_callable, std::forward<TArgs>(args)...);
+		}
+	private:
+		void* m_callable;
+		TReturn(*m_invoke)(void*, TArgs...);
+	};
 }
\ No newline at end of file
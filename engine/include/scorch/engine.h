@@ -5,19 +5,34 @@
 
 #include "core/app.h"
 #include "core/log.h"
+#include "core/bounds.h"
+#include "core/frustum.h"
+#include "core/ray.h"
+#include "core/bvh.h"
 #include "core/sceneGraph.h"
+#include "core/threadPool.h"
+#include "core/cpu.h"
+#include "core/transformKernels.h"
 #include "render/renderer.h"
 #include "render/gui.h"
 #include "render/shaderModule.h"
 #include "render/pipeline.h"
 #include "render/buffer.h"
+#include "render/frameAllocator.h"
+#include "render/perFrameBuffer.h"
+#include "render/geometryPool.h"
 #include "render/descriptorSet.h"
 #include "render/mesh.h"
 #include "render/materialSystem.h"
+#include "render/renderQueue.h"
+#include "render/gpuCulling.h"
 #include "event/event.h"
 #include "core/input.h"
 #include "render/scene.h"
 #include "render/camera.h"
 #include "render/texture.h"
+#include "render/mipChain.h"
+#include "render/textureCompression.h"
+#include "render/textureStreamer.h"
 #include "render/renderpass.h"
 #include "render/commandbuffer.h"
@@ -6,6 +6,7 @@ namespace SC
 	{
 	public:
 		ScopedMapData();
+		//unmapFunc can be empty when there is nothing to unmap, e.g. persistently mapped buffers
 		ScopedMapData(void* mapData, std::function<void()>&& unmapFunc);
 		~ScopedMapData();
 		void* const Data() const;
@@ -20,6 +21,8 @@ namespace SC
 		VERTEX_BUFFER,
 		INDEX_BUFFER,
 		UNIFORM_BUFFER,
+		STORAGE_BUFFER,
+		INDIRECT_BUFFER,
 		MAP,
 		TRANSFER_SRC,
 		TRANSFER_DST,
@@ -44,6 +47,11 @@ namespace SC
 		virtual ScopedMapData Map() = 0;
 
 		virtual void CopyFrom(Buffer* src) = 0;
+		//Copies size bytes from srcOffset in src to dstOffset in this buffer
+		virtual void CopyFrom(Buffer* src, size_t srcOffset, size_t dstOffset, size_t size) = 0;
+		//Copies size bytes of data to offset in this buffer, buffers that can't be mapped are written through staging memory.
+		//The copy is visible to commands submitted afterwards, data can be freed as soon as this returns
+		virtual void CopyData(const void* data, size_t size, size_t offset = 0) = 0;
 
 		bool HasUsage(BufferUsage usage) const;
 		size_t GetSize() const;
@@ -1,5 +1,6 @@
 #pragma once
 #include "glm/glm.hpp"
+#include "scorch/core/ray.h"
 
 namespace SC 
 {
@@ -22,6 +23,9 @@ namespace SC
 
 		float Fov() const;
 
+		//Ray from the camera through a pixel, (0, 0) is the top left of a viewport of the given size. Fov is the vertical field of view
+		Ray ScreenPointToRay(float x, float y, float width, float height) const;
+
 		float& Yaw();
 		const float& Yaw() const;
 
@@ -11,30 +11,94 @@ namespace SC
 	class PipelineLayout;
 	class DescriptorSet;
 
+	//Same layout as the graphics APIs' indexed indirect draw arguments, these are written to indirect buffers
+	struct DrawIndexedIndirectCommand
+	{
+		uint32_t indexCount;
+		uint32_t instanceCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		uint32_t firstInstance;
+	};
+
+	enum class CommandBufferLevel
+	{
+		PRIMARY,
+		SECONDARY, //Recorded separately, possibly on another thread, and executed by a primary command buffer
+	};
+
+	enum class SubpassContents
+	{
+		INLINE,
+		SECONDARY_COMMAND_BUFFERS, //The render pass is only filled by ExecuteCommands
+	};
+
+	enum class PipelineStage : uint8_t
+	{
+		TRANSFER,
+		COMPUTE_SHADER,
+		DRAW_INDIRECT,
+		VERTEX_SHADER,
+		FRAGMENT_SHADER,
+		COUNT
+	};
+	using PipelineStageFlags = Flags<PipelineStage>;
+
+	//Counted since recording began
+	struct CommandBufferStats
+	{
+		uint32_t recorded{ 0 }; //Commands passed on to the graphics API
+		uint32_t filtered{ 0 }; //Binds and dynamic state matching what was already set, these are skipped
+	};
+
+	//Binds and dynamic state are compared against what is already set on the command buffer and skipped when unchanged
 	class CommandBuffer
 	{
 	public:
 		virtual ~CommandBuffer() = default;
 
-		virtual void BeginRecording() const = 0;
+		virtual void BeginRecording() = 0;
+		//Secondary command buffers that are executed inside renderPass drawing to renderTarget. They don't inherit any
+		//state from the primary command buffer so pipelines, descriptors and dynamic state have to be set again
+		virtual void BeginRecording(const Renderpass* renderPass, const RenderTarget* renderTarget) = 0;
 		virtual void EndRecording() const = 0;
 
-		virtual void BeginRenderPass(const Renderpass* renderPass, const RenderTarget* renderTarget, float clearR = 0, float clearG = 0, float clearB = 0, float clearDepth = 1.0f) = 0;
+		virtual void BeginRenderPass(const Renderpass* renderPass, const RenderTarget* renderTarget, float clearR = 0, float clearG = 0, float clearB = 0, float clearDepth = 1.0f,
+			SubpassContents contents = SubpassContents::INLINE) = 0;
 		virtual void EndRenderPass() = 0;
 
 
 		virtual void SetViewport(const Viewport& viewport) = 0;
 		virtual void SetScissor(const Scissor& scissor) = 0;
 
+		//Descriptor sets and push constants are bound to the graphics or compute bind point of the last bound pipeline
 		virtual void BindPipeline(const Pipeline* pipeline) = 0;
 		virtual void BindVertexBuffer(const Buffer* buffer) = 0;
 		virtual void BindIndexBuffer(const Buffer* buffer) = 0;
-		virtual void BindDescriptorSet(const PipelineLayout* pipelineLayout, const DescriptorSet* descriptorSet, int set = 0) = 0;
+		//dynamicOffsets holds one offset for each dynamic binding of the set, in binding order
+		virtual void BindDescriptorSet(const PipelineLayout* pipelineLayout, const DescriptorSet* descriptorSet, int set = 0,
+			const uint32_t* dynamicOffsets = nullptr, uint32_t dynamicOffsetCount = 0) = 0;
 		virtual void PushConstants(const PipelineLayout* pipelineLayout, uint32_t rangeIndex, uint32_t offset, uint32_t size, void* data) = 0;
 		virtual void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) = 0;
 		virtual void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, uint32_t vertexOffset, uint32_t firstInstance) = 0;
+		//Draws drawCount DrawIndexedIndirectCommands read from buffer, the buffer needs BufferUsage::INDIRECT_BUFFER
+		virtual void DrawIndexedIndirect(const Buffer* buffer, size_t offset, uint32_t drawCount, uint32_t stride = sizeof(DrawIndexedIndirectCommand)) = 0;
+		//Same as DrawIndexedIndirect but the draw count is a uint32_t read from countBuffer, clamped to maxDrawCount.
+		//Only available when Renderer::SupportsDrawIndirectCount
+		virtual void DrawIndexedIndirectCount(const Buffer* buffer, size_t offset, const Buffer* countBuffer, size_t countOffset, uint32_t maxDrawCount, uint32_t stride = sizeof(DrawIndexedIndirectCommand)) = 0;
+
+		//Executes secondary command buffers, the render pass has to be begun with SubpassContents::SECONDARY_COMMAND_BUFFERS
+		virtual void ExecuteCommands(const CommandBuffer* const* commandBuffers, uint32_t count) = 0;
+		//Dispatches groupCount work groups of the bound compute pipeline, must be recorded outside of a render pass
+		virtual void Dispatch(uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1) = 0;
+		//Makes memory written by srcStages visible to dstStages, e.g. a compute shader writing draw commands before they are drawn
+		virtual void PipelineBarrier(const PipelineStageFlags& srcStages, const PipelineStageFlags& dstStages) = 0;
 
 		virtual void ResetCommands() = 0;
+
+		//Forgets the bound state so the next binds are recorded, needed after recording into the API command buffer directly
+		virtual void InvalidateState() = 0;
+		virtual const CommandBufferStats& GetStats() const = 0;
 	};
 
 	class CommandPool
@@ -43,7 +107,9 @@ namespace SC
 		static std::unique_ptr<CommandPool> Create();
 		virtual ~CommandPool() = default;
 
-		virtual std::unique_ptr<CommandBuffer> CreateCommandBuffer() = 0;
+		virtual std::unique_ptr<CommandBuffer> CreateCommandBuffer(CommandBufferLevel level = CommandBufferLevel::PRIMARY) = 0;
+		//Resets every command buffer created from this pool, cheaper than resetting them one by one
+		virtual void Reset() = 0;
 	protected:
 		CommandPool() = default;
 	};
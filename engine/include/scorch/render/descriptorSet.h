@@ -7,6 +7,10 @@ namespace SC
 	{
 		UNIFORM,
 		SAMPLER,
+		STORAGE,
+		//The offset into the buffer is given when binding the set, e.g. to pick the current frame's copy of a PerFrameBuffer
+		UNIFORM_DYNAMIC,
+		STORAGE_DYNAMIC,
 		COUNT
 	};
 
@@ -25,6 +29,8 @@ namespace SC
 
 		void AddBinding(DescriptorBindingType type, const ShaderModuleFlags&& stages);
 		const std::vector<DescriptorBinding>& Bindings() const;
+		//Sets using this layout need a dynamic offset for each of these bindings, in binding order, when they are bound
+		uint32_t DynamicBindingCount() const;
 	protected:
 		DescriptorSetLayout();
 		DescriptorSetLayout(std::vector<DescriptorBinding>&& bindings);
@@ -40,7 +46,9 @@ namespace SC
 		static std::unique_ptr<DescriptorSet> Create(const DescriptorSetLayout* layout);
 		virtual ~DescriptorSet();
 
-		virtual void SetBuffer(const Buffer* buffer, uint32_t binding) = 0;
+		//A range of 0 uses the rest of the buffer after offset. Dynamic bindings need the range of one element since their
+		//dynamic offset is added to offset
+		virtual void SetBuffer(const Buffer* buffer, uint32_t binding, size_t offset = 0, size_t range = 0) = 0;
 		virtual void SetTexture(const Texture* texture, uint32_t binding) = 0;
 		const DescriptorSetLayout* Layout() const;
 	protected:
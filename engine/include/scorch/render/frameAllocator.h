@@ -0,0 +1,56 @@
+#pragma once
+#include "buffer.h"
+#include <atomic>
+
+namespace SC
+{
+	//Sub-allocation of a FrameAllocator, valid until the same frame comes around again
+	struct FrameAllocation
+	{
+		Buffer* buffer{ nullptr };
+		size_t offset{ 0 }; //From the start of the buffer
+		size_t size{ 0 };
+		void* data{ nullptr }; //Mapped, only write to it as reading host visible memory can be slow
+
+		bool IsValid() const { return data != nullptr; }
+	};
+
+	//Linear allocator over one persistently mapped host buffer split into a region per overlapping frame. Allocating bumps an
+	//atomic offset so it can be used from several threads, a frame's region is rewound by the renderer once the frame's
+	//fence has signalled so nothing allocated in it is still read by the GPU
+	class FrameAllocator
+	{
+	public:
+		//Every region starts at a multiple of this, larger alignments can't be guaranteed
+		static constexpr size_t MAX_ALIGNMENT = 256;
+
+		FrameAllocator(size_t frameCapacity, uint8_t frameCount, const BufferUsageSet& bufferUsage);
+
+		FrameAllocator(const FrameAllocator&) = delete;
+		FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+		//Rewinds frameIndex's region and allocates from it until the next call
+		void BeginFrame(uint8_t frameIndex);
+
+		//alignment has to be a power of two, returns an invalid allocation when the frame's region is full
+		FrameAllocation Allocate(size_t size, size_t alignment);
+		template<typename T>
+		FrameAllocation Allocate(size_t count, size_t alignment = alignof(T))
+		{
+			return Allocate(sizeof(T) * count, alignment);
+		}
+
+		Buffer* GetBuffer() const;
+		size_t FrameCapacity() const;
+		//Bytes allocated in the current frame, including alignment padding
+		size_t FrameUsed() const;
+	private:
+		std::unique_ptr<Buffer> m_buffer;
+		ScopedMapData m_mappedData;
+
+		size_t m_frameCapacity;
+		uint8_t m_frameCount;
+		size_t m_frameBegin;
+		std::atomic<size_t> m_frameOffset;
+	};
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "buffer.h"
+#include "scorch/core/freeListAllocator.h"
+#include <mutex>
+
+namespace SC
+{
+	struct Vertex;
+	using VertexIndexType = uint32_t;
+
+	//Range of a GeometryPool's buffers, counted in vertices and indices so it can be given to indexed draws as is
+	struct GeometryAllocation
+	{
+		uint32_t vertexOffset{ FreeListAllocator::INVALID_OFFSET };
+		uint32_t vertexCount{ 0 };
+		uint32_t firstIndex{ FreeListAllocator::INVALID_OFFSET };
+		uint32_t indexCount{ 0 };
+
+		bool IsValid() const { return vertexOffset != FreeListAllocator::INVALID_OFFSET; }
+	};
+
+	//One device vertex buffer and one device index buffer that meshes sub-allocate their geometry from, so drawing meshes
+	//one after another doesn't need their buffers rebinding and indirect draws of different meshes can be submitted together.
+	//Freed ranges are only reused once the frames that could still be drawing from them have finished
+	class GeometryPool
+	{
+	public:
+		GeometryPool(uint32_t vertexCapacity, uint32_t indexCapacity, uint8_t frameCount);
+
+		GeometryPool(const GeometryPool&) = delete;
+		GeometryPool& operator=(const GeometryPool&) = delete;
+
+		//Uploads the geometry to free ranges of the buffers, returns an invalid allocation when it doesn't fit
+		GeometryAllocation Allocate(const Vertex* vertices, uint32_t vertexCount, const VertexIndexType* indices, uint32_t indexCount);
+		//The ranges become free once the current frame has been through BeginFrame again
+		void Free(const GeometryAllocation& allocation);
+
+		//Called by the renderer once frameIndex's fence has signalled, releases the ranges freed the last time it was current
+		void BeginFrame(uint8_t frameIndex);
+
+		Buffer* GetVertexBuffer() const;
+		Buffer* GetIndexBuffer() const;
+
+		uint32_t VertexCapacity() const;
+		uint32_t VerticesUsed() const;
+		uint32_t IndexCapacity() const;
+		uint32_t IndicesUsed() const;
+	private:
+		std::unique_ptr<Buffer> m_vertexBuffer;
+		std::unique_ptr<Buffer> m_indexBuffer;
+
+		mutable std::mutex m_mutex;
+		FreeListAllocator m_vertexAllocator;
+		FreeListAllocator m_indexAllocator;
+
+		std::vector<std::vector<GeometryAllocation>> m_pendingFrees; //Indexed by frame
+		uint8_t m_frameIndex;
+	};
+}
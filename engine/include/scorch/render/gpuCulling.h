@@ -0,0 +1,63 @@
+#pragma once
+#include "scorch/core/frustum.h"
+
+namespace SC
+{
+	class ShaderModule;
+	class Pipeline;
+	class PipelineLayout;
+	class DescriptorSetLayout;
+	class DescriptorSet;
+	class CommandBuffer;
+
+	//Frustum culls objects with a compute shader and compacts the visible ones into instanced indirect draws.
+	//Every object belongs to a batch, the DrawIndexedIndirectCommand at the same index in the command buffer. Visible objects
+	//increment their batch's instanceCount and copy their transform to the instance buffer at firstInstance + the old count, so
+	//commands need to be written with an instanceCount of 0 and room reserved for every object of the batch
+	class GpuCulling
+	{
+	public:
+		static constexpr uint32_t GROUP_SIZE = 64; //Has to match local_size_x of the shader
+
+		//Storage buffers of the descriptor set, in binding order
+		enum Binding : uint32_t
+		{
+			OBJECTS,	//Object per object
+			TRANSFORMS, //mat4 per object
+			INSTANCES,	//mat4 per instance, written
+			COMMANDS,	//DrawIndexedIndirectCommand per batch, instanceCount is written
+			BINDING_COUNT
+		};
+
+		//std430 layout of the shader's object struct, the bounds are in world space
+		struct Object
+		{
+			glm::vec3 boundsMin;
+			uint32_t batch;
+			glm::vec3 boundsMax;
+			uint32_t padding;
+		};
+
+		GpuCulling();
+		~GpuCulling();
+
+		GpuCulling(const GpuCulling&) = delete;
+		GpuCulling& operator=(const GpuCulling&) = delete;
+
+		//Loads the culling compute shader and builds its pipeline
+		bool Init(const std::string& shaderPath);
+		bool IsInitialised() const;
+
+		//Layout of the descriptor sets given to Dispatch
+		const DescriptorSetLayout* SetLayout() const;
+
+		//Records the culling dispatch followed by a barrier so later draws see the commands and instances it wrote.
+		//Has to be recorded outside of a render pass
+		void Dispatch(CommandBuffer& commandBuffer, const DescriptorSet* descriptorSet, const Frustum& frustum, uint32_t objectCount) const;
+	private:
+		std::unique_ptr<ShaderModule> m_shader;
+		std::unique_ptr<DescriptorSetLayout> m_setLayout;
+		std::unique_ptr<PipelineLayout> m_pipelineLayout;
+		std::unique_ptr<Pipeline> m_pipeline;
+	};
+}
@@ -7,6 +7,7 @@ struct GLFWwindow;
 namespace SC
 {
 	class Renderer;
+	class CommandBuffer;
 	class GUI
 	{
 	public:
@@ -14,7 +15,10 @@ namespace SC
 		~GUI();
 
 		void BeginFrame();
+		//Records the GUI into the frame command buffer
 		void EndFrame();
+		//Records the GUI into commandBuffer, e.g. a secondary command buffer when the render pass is filled by secondaries
+		void EndFrame(CommandBuffer& commandBuffer);
 	private:
 		GUI(Renderer* renderer, GLFWwindow* window);
 		void Init();
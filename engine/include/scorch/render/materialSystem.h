@@ -5,6 +5,7 @@
 #include "shaderModule.h"
 #include "pipeline.h"
 #include "renderer.h"
+#include "perFrameBuffer.h"
 
 namespace SC
 {
@@ -55,7 +56,8 @@ namespace SC
 		glm::vec4 GetVec4(const std::string& key);
 
 		const std::vector<uint8_t>& GetData() const;
-		Buffer* GetBuffer(uint8_t frameIndex);
+		//Bound to a UNIFORM_DYNAMIC binding, the frame's copy is picked with its FrameOffset
+		const PerFrameBuffer& GetBuffer() const;
 
 		const std::unordered_map<std::string, std::pair<ShaderParamterTypes, void*>>& GetRegister() const;
 	private:
@@ -70,7 +72,7 @@ namespace SC
 		bool IsValid(bool validateCreated, bool validateNotCreated,
 			const std::string& checkRegistered = "", const std::string& checkNotRegistered = "");
 
-		FrameData<Buffer> m_parameterBuffers;
+		PerFrameBuffer m_parameterBuffer;
 	};
 
 	struct ShaderEffect
@@ -172,8 +174,10 @@ namespace SC
 	struct Material
 	{
 		EffectTemplate* original;
-		PerPassData<FrameData<DescriptorSet>> passSets;
+		//The parameters are bound with a dynamic offset so one set serves every frame
+		PerPassData<std::unique_ptr<DescriptorSet>> passSets;
 		std::vector<Texture*> textures; //Material doesn't own textures
+		std::vector<uint32_t> textureVersions; //Texture::GetImageVersion when the sets were written
 
 		ShaderParameters parameters;
 	};
@@ -197,7 +201,13 @@ namespace SC
 		std::shared_ptr<Material> GetMaterial(const std::string& materialName);
 
 		const std::unordered_map<std::string, std::shared_ptr<Material>>& Materials() const;
+
+		//Writes new descriptor sets for materials whose textures have replaced their images, e.g. when streaming changed
+		//their mip levels. The old sets are freed once the frames using them have finished. Call before recording draws,
+		//returns how many materials were updated
+		uint32_t UpdateTextureSets();
 	private:
+		bool WriteTextureSets(Material& material);
 		struct MaterialInfoHash
 		{
 			std::size_t operator()(const MaterialData& k) const
@@ -3,11 +3,15 @@
 #include <glm/gtx/transform.hpp>
 #include "descriptorSet.h"
 #include "materialSystem.h"
+#include "geometryPool.h"
+#include "scorch/core/bounds.h"
+#include "scorch/core/ray.h"
 
 namespace SC
 {
 	class Pipeline;
 	class PipelineLayout;
+	class BVH;
 	using VertexIndexType = uint32_t;
 	struct Material;
 	struct MaterialInfo;
@@ -29,7 +33,18 @@ namespace SC
 
 		std::vector<Vertex> vertices;
 		std::vector<VertexIndexType> indices;
+		//Only created by Build when the geometry doesn't fit in the renderer's GeometryPool, use GetVertexBuffer and GetIndexBuffer
 		std::unique_ptr<Buffer> vertexBuffer, indexBuffer;
+		//Where the geometry starts in GetVertexBuffer and GetIndexBuffer, in vertices and indices, for indexed draws
+		uint32_t vertexOffset;
+		uint32_t firstIndex;
+
+		//Local space bounds of the vertices, computed by Build so they remain valid after the vertices are released
+		AABB bounds;
+		BoundingSphere boundingSphere;
+
+		//Optional BVH over the triangles for ray queries, it and Raycast need the vertices and indices kept after Build
+		std::unique_ptr<BVH> triangleBvh;
 
 		uint32_t VertexCount() const;
 		uint32_t VertexSize() const;
@@ -37,9 +52,27 @@ namespace SC
 		uint32_t IndexCount() const;
 		uint32_t IndexSize() const;
 
+		//Uploads the geometry to the renderer's GeometryPool, or to dedicated buffers when the pool is full
 		bool Build();
+		Buffer* GetVertexBuffer() const;
+		Buffer* GetIndexBuffer() const;
+		//Whether the geometry is sub-allocated from the GeometryPool, meshes that are share their buffers
+		bool IsPooled() const;
+		void ComputeBounds();
+		void BuildTriangleBvh();
+
+		bool HasGeometry() const;
+		//Closest triangle hit by a ray in the mesh's local space, triangle indexes the triangles in indices.
+		//Tests every triangle when there is no triangle BVH
+		bool Raycast(const Ray& ray, float maxDistance, float& distance, uint32_t& triangle) const;
+		void Triangle(uint32_t triangle, glm::vec3& v0, glm::vec3& v1, glm::vec3& v2) const;
 
 		Mesh& operator=(Mesh&& other);
+	private:
+		void ReleaseBuffers();
+	private:
+		GeometryPool* m_geometryPool;
+		GeometryAllocation m_geometryAllocation;
 	};
 
 	struct RenderObject
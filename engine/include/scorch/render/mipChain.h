@@ -0,0 +1,39 @@
+#pragma once
+#include "pipeline.h"
+#include <cstdint>
+#include <vector>
+
+namespace SC
+{
+	enum class MipFilter
+	{
+		BOX, //Averages each 2x2 block
+		KAISER, //Kaiser windowed sinc, keeps more detail than a box filter with little ringing
+	};
+
+	//Level of a MipChain, offset is from the start of MipChain::pixels
+	struct MipLevel
+	{
+		size_t offset;
+		size_t size;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	//Every mip level of an 8 bit RGBA image packed one after the other, level 0 first. This is the layout Texture::CopyData
+	//expects when it is given more than one level
+	struct MipChain
+	{
+		std::vector<uint8_t> pixels;
+		std::vector<MipLevel> levels;
+	};
+
+	//Levels down to 1x1 for an image of this size
+	uint32_t MipLevelCount(uint32_t width, uint32_t height);
+	//Bytes taken by the first levelCount levels packed one after the other
+	size_t MipChainSize(Format format, uint32_t width, uint32_t height, uint32_t levelCount);
+
+	//Builds every level from 8 bit RGBA pixels on the CPU so uploading a texture doesn't need blits on the GPU. With srgb the
+	//colour channels are filtered in linear space and converted back, alpha is always filtered as it is
+	MipChain GenerateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, MipFilter filter = MipFilter::KAISER);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "buffer.h"
+
+namespace SC
+{
+	//One persistently mapped buffer holding a copy of the data for each overlapping frame. Every copy starts at an offset
+	//aligned for uniform and storage descriptors, so one descriptor set with a UNIFORM_DYNAMIC or STORAGE_DYNAMIC binding
+	//can address any frame's copy by passing FrameOffset as the dynamic offset when binding it
+	class PerFrameBuffer
+	{
+	public:
+		PerFrameBuffer();
+		//bufferUsage needs MAP, data is copied into every frame's copy when given
+		PerFrameBuffer(size_t size, const BufferUsageSet& bufferUsage, const void* data = nullptr);
+
+		PerFrameBuffer(PerFrameBuffer&&) = default;
+		PerFrameBuffer& operator=(PerFrameBuffer&&) = default;
+
+		void* GetFrameData(uint8_t frameIndex) const;
+		uint32_t FrameOffset(uint8_t frameIndex) const;
+
+		Buffer* GetBuffer() const;
+		//Of one frame's copy, the range to give DescriptorSet::SetBuffer
+		size_t Size() const;
+		uint8_t FrameCount() const;
+		bool IsValid() const;
+	private:
+		std::unique_ptr<Buffer> m_buffer;
+		uint8_t* m_mapped;
+		size_t m_size;
+		size_t m_stride;
+		uint8_t m_frameCount;
+	};
+}
@@ -16,8 +16,21 @@ namespace SC
 		R32G32_SFLOAT,
 		R32G32B32_SFLOAT,
 		R32G32B32A32_SFLOAT,
+		BC1_RGB_UNORM, //RGB, 8 bytes per block
+		BC1_RGB_SRGB,
+		BC3_UNORM, //RGBA, BC1 colour with a separate alpha block, 16 bytes per block
+		BC3_SRGB,
+		BC5_UNORM, //Two channels e.g. normal maps, 16 bytes per block
+		BC7_UNORM, //RGBA at higher quality than BC3, 16 bytes per block
+		BC7_SRGB,
 	};
+	//Bytes per texel, block compressed formats don't have one so use ImageSize for them
 	uint32_t ConvertFormatSize(Format format);
+	//Block compressed formats store 4x4 texel blocks
+	bool IsBlockCompressed(Format format);
+	uint32_t FormatBlockSize(Format format);
+	//Bytes of a width x height image, rounded up to whole blocks for block compressed formats
+	size_t ImageSize(Format format, uint32_t width, uint32_t height);
 
 	enum class VertexInputRate
 	{
@@ -152,7 +165,9 @@ namespace SC
 
 		//TODO multi sampling and blending
 	public:
+		//Pipelines with a compute module are compute pipelines, they only use the pipeline layout and ignore the renderpass
 		virtual bool Build(const Renderpass* renderpass = nullptr) = 0;
+		bool IsCompute() const;
 
 		virtual ~Pipeline();
 	protected:
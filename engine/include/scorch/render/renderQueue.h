@@ -0,0 +1,37 @@
+#pragma once
+#include "materialSystem.h"
+#include <unordered_map>
+
+namespace SC
+{
+	//Draws to be sorted by a 64 bit key so objects sharing state end up next to each other. From the most significant bits:
+	//pass (4) | pipeline (12) | material (16) | mesh (16) | depth (16)
+	//Objects sharing a pipeline, material and mesh are drawn front to back, or back to front in the transparency pass
+	class RenderQueue
+	{
+	public:
+		struct Item
+		{
+			uint64_t key;
+			uint32_t object; //Index of the object this draw belongs to, chosen by whoever fills the queue
+		};
+
+		static uint64_t MakeKey(MeshpassType pass, uint32_t pipelineId, uint32_t materialId, uint32_t meshId, float viewDistance);
+
+		//Small ids for keys, assigned in order of first use. Ids wider than their field in the key wrap, which only makes the
+		//sort group less well
+		uint32_t SortId(const void* object);
+		void ResetSortIds();
+
+		void Clear();
+		void Add(uint64_t key, uint32_t object);
+		//Stable least significant digit radix sort, passes where every key has the same digit are skipped
+		void Sort();
+
+		const std::vector<Item>& Items() const;
+	private:
+		std::vector<Item> m_items;
+		std::vector<Item> m_sortScratch;
+		std::unordered_map<const void*, uint32_t> m_sortIds;
+	};
+}
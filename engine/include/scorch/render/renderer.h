@@ -19,10 +19,30 @@ namespace SC
 	class Renderpass;
 	struct RenderTarget;
 	class CommandBuffer;
+	class FrameAllocator;
+	class GeometryPool;
+
+	struct UploadStats
+	{
+		uint64_t uploads{ 0 };
+		uint64_t bytes{ 0 };
+		uint64_t batches{ 0 };
+		uint64_t stalls{ 0 }; //Times the CPU waited for the GPU to free up staging memory or a batch
+		//Staging memory holding data the GPU hasn't copied yet, the most it has been and how much is allocated in total
+		size_t stagingInUse{ 0 };
+		size_t stagingPeak{ 0 };
+		size_t stagingAllocated{ 0 };
+	};
 
 	class Renderer
 	{
 	public:
+		//Bytes each frame can allocate from the frame allocator
+		static constexpr size_t FRAME_ALLOCATOR_CAPACITY = 4 * 1024 * 1024;
+		//Vertices and indices the geometry pool has room for, meshes that don't fit get their own buffers
+		static constexpr uint32_t GEOMETRY_POOL_VERTEX_CAPACITY = 2 * 1024 * 1024;
+		static constexpr uint32_t GEOMETRY_POOL_INDEX_CAPACITY = 6 * 1024 * 1024;
+
 		static std::unique_ptr<Renderer> Create(GraphicsAPI api);
 		virtual ~Renderer();
 
@@ -35,20 +55,55 @@ namespace SC
 		virtual void BeginFrame() = 0;
 		virtual void EndFrame() = 0;
 		virtual void SubmitCommandBuffer(const CommandBuffer& commandBuffer) = 0;
+		//Submits work that isn't part of a frame, e.g. compute work, and blocks until the GPU has finished it
+		virtual void SubmitAndWait(const CommandBuffer& commandBuffer) = 0;
 
 		virtual CommandBuffer& GetFrameCommandBuffer() const = 0;
+		//Makes sure every frame has at least count secondary command buffers, each with its own command pool so they can be
+		//recorded on different threads at the same time. Has to be called from the main thread
+		virtual void ReserveSecondaryCommandBuffers(uint32_t count) = 0;
+		//Secondary command buffers of the current frame, their pools are reset in BeginFrame
+		virtual CommandBuffer& GetFrameSecondaryCommandBuffer(uint32_t index) const = 0;
+		virtual uint32_t SecondaryCommandBufferCount() const = 0;
 		virtual Renderpass* DefaultRenderPass() const = 0;
 		virtual RenderTarget* DefaultRenderTarget() const = 0;
 
+		//Totals since Init of the uploads made by Buffer::CopyData and Texture::CopyData
+		virtual UploadStats GetUploadStats() const = 0;
+
 		uint8_t FrameDataIndex() const;
 		uint8_t FrameDataIndexCount() const;
 
+		//Whether CommandBuffer::DrawIndexedIndirect can submit more than one draw and the draws can start at a firstInstance other
+		//than 0. Indirect scene draws and gpu culling need both, the scene draws directly without them
+		bool SupportsMultiDrawIndirect() const;
+		//Whether CommandBuffer::DrawIndexedIndirectCount can be used
+		bool SupportsDrawIndirectCount() const;
+		//Whether textures can use the BC formats
+		bool SupportsBlockCompression() const;
+		//Offsets of uniform and storage buffers bound to descriptors have to be multiples of these
+		size_t UniformBufferAlignment() const;
+		size_t StorageBufferAlignment() const;
+
+		//Per frame allocations for uniforms, instance data, indirect commands etc. They are rewound in BeginFrame once the
+		//GPU is done with the frame so they only live for the frame they were allocated in
+		FrameAllocator& GetFrameAllocator() const;
+		//Shared vertex and index buffers meshes sub-allocate from, nullptr before Init and after Cleanup
+		GeometryPool* GetGeometryPool() const;
+
 		Texture* WhiteTexture() const;
 		Texture* BlackTexture() const;
 	protected:
 		Renderer(GraphicsAPI api);
 
 		uint32_t m_currentFrame;
+		bool m_supportsMultiDrawIndirect;
+		bool m_supportsDrawIndirectCount;
+		bool m_supportsBlockCompression;
+		size_t m_uniformBufferAlignment;
+		size_t m_storageBufferAlignment;
+		std::unique_ptr<FrameAllocator> m_frameAllocator;
+		std::unique_ptr<GeometryPool> m_geometryPool;
 	private:
 		GraphicsAPI m_api;
 	};
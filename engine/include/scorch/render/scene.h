@@ -2,6 +2,14 @@
 #include "mesh.h"
 #include "materialSystem.h"
 #include "scorch/core/sceneGraph.h"
+#include "scorch/core/frustum.h"
+#include "scorch/core/bvh.h"
+#include "scorch/core/utils.h"
+#include "renderQueue.h"
+#include "gpuCulling.h"
+#include "perFrameBuffer.h"
+#include "frameAllocator.h"
+#include "textureStreamer.h"
 
 #include "jaam.h"
 #include "glm/glm.hpp"
@@ -12,6 +20,12 @@ namespace SC
 	class Pipeline;
 	class PipelineLayout;
 	class Buffer;
+	class DescriptorSet;
+	class CommandBuffer;
+	struct DrawIndexedIndirectCommand;
+	class Renderpass;
+	struct RenderTarget;
+	class ThreadPool;
 	struct Texture;
 
 	static constexpr uint32_t MAX_LIGHTS = 8;
@@ -29,32 +43,224 @@ namespace SC
 		alignas(16) Light Lights[MAX_LIGHTS];
 	};
 
+	struct CullingStats
+	{
+		uint32_t objects{ 0 };
+		uint32_t culled{ 0 };
+		uint32_t tested{ 0 }; //Bounding boxes tested, including BVH nodes
+	};
+
+	struct DrawStats
+	{
+		uint32_t draws{ 0 }; //Instanced draws, each one is an indirect command when drawing indirectly
+		uint32_t drawCalls{ 0 }; //Draw commands recorded into the command buffer
+		uint32_t instances{ 0 };
+		uint32_t pipelineBinds{ 0 };
+		uint32_t materialBinds{ 0 };
+		uint32_t meshBinds{ 0 }; //Vertex and index buffer pairs
+		//Recorded while drawing the scene, including the draw callback's, see CommandBufferStats
+		uint32_t commandsRecorded{ 0 };
+		uint32_t commandsFiltered{ 0 };
+	};
+
+	struct RaycastHit
+	{
+		SceneNode* node{ nullptr };
+		float distance{ 0.0f };
+		glm::vec3 point{ 0.0f };
+		glm::vec3 normal{ 0.0f }; //Faces the ray
+		uint32_t triangle{ std::numeric_limits<uint32_t>::max() }; //Not set when the mesh has no geometry and its bounds were hit instead
+	};
+
 	class Scene
 	{
 	public:
+		//Objects the instance buffer has room for before it first grows, each one takes a matrix in it
+		static constexpr uint32_t MIN_INSTANCE_CAPACITY = 16384;
+		//DrawObjectsParallel gives each thread at least this many batches, fewer aren't worth a command buffer of their own
+		static constexpr uint32_t MIN_BATCHES_PER_CHUNK = 64;
+
+		using PerRenderObjectFunc = FunctionRef<void(CommandBuffer& commandBuffer, const RenderObject& renderObject, bool pipelineChanged, bool materialChanged)>;
+
 		Scene();
 		~Scene();
 
-		void DrawObjects(Renderer* renderer,
-			std::function<void(const RenderObject& renderObject, bool pipelineChanged)> PerRenderObjectFunc);
+		//Updates the transforms of every node and refits the BVH to the render objects that moved. The BVH is rebuilt when
+		//nodes have been added, removed or re-parented, large rebuilds are split across the thread pool when one is given
+		void Update(ThreadPool* threadPool = nullptr);
+
+		//Draws the visible objects sorted by pipeline, material, mesh and then front to back. Objects sharing a material and
+		//mesh are drawn with one instanced draw and their transforms are read from GetInstanceBuffer, so the vertex shader
+		//needs it bound as a storage buffer. perRenderObjectFunc is called before each draw with its first object, it only
+		//needs to bind the material's descriptors when materialChanged is set and dynamic state such as the viewport when
+		//pipelineChanged is set. With indirect draws enabled it is only called when the pipeline, material or geometry
+		//buffers change since the draws in between are submitted together.
+		//With gpu culling enabled DispatchCulling has to be called first. When nodes were added since Update and the instance
+		//buffer had to grow nothing is drawn, as descriptor sets made before still point at the old buffer
+		void DrawObjects(Renderer* renderer, PerRenderObjectFunc perRenderObjectFunc);
+		//Same as DrawObjects but the batches are split into contiguous chunks that are recorded on the thread pool, each into
+		//one of the frame's secondary command buffers which the frame command buffer then executes. The render pass has to be
+		//begun with SubpassContents::SECONDARY_COMMAND_BUFFERS. perRenderObjectFunc is called from several threads at once
+		//with a different command buffer each, pipelineChanged is set for the first draw of every command buffer
+		void DrawObjectsParallel(Renderer* renderer, const Renderpass* renderPass, const RenderTarget* renderTarget, ThreadPool& threadPool,
+			PerRenderObjectFunc perRenderObjectFunc);
+
+		//With gpu culling enabled this batches every object and records the culling dispatch into the frame command buffer,
+		//it has to be called outside of a render pass before DrawObjects. Does nothing when gpu culling is disabled
+		void DispatchCulling(Renderer* renderer);
+
+		//Requests the texture levels each object needs from its size on screen with SceneUbo::ViewMatrix and lets the streamer
+		//stream levels in or out. Call once per frame after Update, MaterialSystem::UpdateTextureSets then has to be called
+		//before drawing so materials use the new images
+		void UpdateTextureStreaming(uint32_t viewportWidth, uint32_t viewportHeight);
 
 		void Reset();
 
 		SceneNode& Root();
 
-		SceneNode* LoadModel(const std::string& path, MaterialSystem* materialSystem);
+		//Keeping the geometry builds a triangle BVH per mesh so raycasts hit triangles, otherwise the vertices are released
+		//after upload and raycasts only hit the mesh bounds. Textures are BC7 compressed when the device supports it, the
+		//thread pool is used to compress the ones not in the cache yet
+		SceneNode* LoadModel(const std::string& path, MaterialSystem* materialSystem, bool keepGeometry = false, ThreadPool* threadPool = nullptr);
 
 		SceneUbo& GetSceneData();
-		Buffer* GetSceneUniformBuffer(uint8_t frameDataIndex);
+		//This frame's copy of GetSceneData in the renderer's frame allocator, written when drawing starts. Bind the frame
+		//allocator's buffer to a UNIFORM_DYNAMIC binding with a range of sizeof(SceneUbo) and pass the offset as its dynamic offset
+		const FrameAllocation& GetSceneUniforms() const;
+		//A model matrix for every render object, bound to a STORAGE_DYNAMIC binding, the frame's copy is picked with its FrameOffset
+		const PerFrameBuffer& GetInstanceBuffer() const;
+		//Changes when the instance buffer is recreated to fit more render objects, descriptor sets using it have to be created
+		//again before recording any draws. It only grows when nodes were added, so check it after Update and DispatchCulling
+		uint32_t GetInstanceBufferVersion() const;
+
+		//Textures loaded by LoadModel are streamed, only their smallest levels are loaded until UpdateTextureStreaming asks
+		//for more. Enabled by default, changing it only affects textures loaded afterwards
+		void SetTextureStreaming(bool enabled);
+		bool TextureStreamingEnabled() const;
+		TextureStreamer& GetTextureStreamer();
+
+		//Objects outside the frustum of SceneUbo::ViewMatrix are not drawn, enabled by default
+		void SetFrustumCulling(bool enabled);
+		bool FrustumCullingEnabled() const;
+		//Writes the draws into the renderer's frame allocator and records one indirect draw per run of draws sharing a pipeline,
+		//material and geometry buffers instead of one draw each, disabled by default. Draws stay direct on devices without
+		//Renderer::SupportsMultiDrawIndirect
+		void SetIndirectDraws(bool enabled);
+		bool IndirectDrawsEnabled() const;
+		//Loads the culling compute shader, see GpuCulling. Has to succeed before gpu culling can be enabled, it fails on devices
+		//without Renderer::SupportsMultiDrawIndirect
+		bool InitGpuCulling(const std::string& cullShaderPath);
+		//Frustum culls on the GPU instead of the CPU, the culling stats are read back from FRAME_OVERLAP_COUNT frames ago.
+		//Disabled by default
+		void SetGpuCulling(bool enabled);
+		bool GpuCullingEnabled() const;
+		//Stats of the last DrawObjects call
+		const CullingStats& GetCullingStats() const;
+		const DrawStats& GetDrawStats() const;
+
+		//Ray queries against the render objects, distances are in units of the ray direction's length
+		bool Raycast(const Ray& ray, RaycastHit& hit, float maxDistance = std::numeric_limits<float>::max());
+		//Every object hit, nearest first. Only the nearest hit of each object is reported
+		uint32_t RaycastAll(const Ray& ray, std::vector<RaycastHit>& hits, float maxDistance = std::numeric_limits<float>::max());
+
+		//BVH over the world bounds of the render objects, its primitives index into GetRenderNodes.
+		//Render nodes are the nodes that had a mesh when the structure of the graph last changed
+		const BVH& GetBvh() const;
+		const std::vector<SceneNode*>& GetRenderNodes() const;
 	private:
-		void CreateSceneUniformBuffers();
-		void UpdateSceneUniformBuffers(uint8_t frameDataIndex);
+		//Copies the scene data into the frame allocator, returns false when it is full
+		bool UpdateSceneUniforms(Renderer* renderer);
+		void CreateInstanceBuffer();
+		//Grows the instance buffer when it can't hold count objects
+		void ReserveInstances(uint32_t count);
+		void CreateIndirectBuffers();
+		//Sized to the instance capacity like the instance buffer, recreated when it grows
+		void CreateCullingBuffers();
+		void CreateCullingDescriptorSets();
+
+		//Culls and batches the visible objects unless DispatchCulling already has, returns false when there is nothing to draw
+		bool PrepareDraws(Renderer* renderer);
+		//Where this frame's indirect commands are drawn from, the buffer is null when drawing directly
+		struct IndirectCommands
+		{
+			Buffer* buffer{ nullptr };
+			size_t offset{ 0 }; //Of the first batch's command
+			DrawIndexedIndirectCommand* commands{ nullptr }; //Written by the CPU while recording, null when the GPU writes them
+		};
+		IndirectCommands FrameIndirectCommands(Renderer* renderer);
+		//Records the batches [begin, end), each batch's indirect command is at its index
+		void RecordBatches(CommandBuffer& commandBuffer, uint32_t begin, uint32_t end, const IndirectCommands& indirect,
+			DrawStats& stats, PerRenderObjectFunc perRenderObjectFunc);
+
+		//Fills m_visibleNodes with the objects in the frustum
+		void CullObjects();
+		//Sorts the visible objects into batches of objects sharing a material and mesh and writes their transforms in draw order
+		void BuildBatches(glm::mat4* instanceTransforms);
+
+		void SyncBvh(ThreadPool* threadPool);
+		void RebuildBvh(ThreadPool* threadPool);
+		void SetRenderBounds(uint32_t renderNode, const AABB& bounds);
+		bool RaycastObject(uint32_t renderNode, const Ray& ray, float maxDistance, RaycastHit& hit);
 
 	private:
-		SceneNode m_root;
+		//Run of sorted render queue items drawn with one instanced draw
+		struct DrawBatch
+		{
+			uint32_t first;
+			uint32_t count;
+		};
+
+		//What the last culling dispatch using a frame's buffers submitted
+		struct GpuCullingFrame
+		{
+			uint32_t objects{ 0 };
+			uint32_t batches{ 0 };
+		};
+
+		SceneGraph m_graph;
 
 		SceneUbo m_sceneUbo;
-		FrameData<Buffer> m_sceneUniformBuffers;
+		FrameAllocation m_sceneUniforms;
+		PerFrameBuffer m_instanceBuffer;
+		uint32_t m_instanceCapacity;
+		uint32_t m_instanceBufferVersion;
+		FrameData<Buffer> m_indirectBuffers; //m_instanceCapacity draw commands written by gpu culling, CPU written ones use the frame allocator
+
+		bool m_indirectDraws;
+
+		std::unique_ptr<GpuCulling> m_gpuCulling;
+		FrameData<Buffer> m_cullObjectBuffers; //m_instanceCapacity GpuCulling::Objects
+		FrameData<Buffer> m_objectTransformBuffers; //m_instanceCapacity model matrices, copied to the instance buffer when visible
+		FrameData<DescriptorSet> m_cullDescriptorSets;
+		std::vector<GpuCullingFrame> m_gpuCullingFrames;
+		bool m_gpuCullingEnabled;
+		bool m_cullingDispatched;
+
+		bool m_frustumCulling;
+		CullingStats m_cullingStats;
+
+		TextureStreamer m_textureStreamer;
+		bool m_textureStreaming;
+
+		//Render nodes and their world bounds, the bounds are kept both as boxes for the BVH and as arrays for SIMD culling
+		std::vector<SceneNode*> m_renderNodes;
+		std::vector<AABB> m_renderBounds;
+		AABBArray m_renderBoundsArrays;
+		std::vector<uint32_t> m_renderNodeOfId; //Hierarchy NodeId to render node
+
+		BVH m_bvh;
+		uint32_t m_bvhStructureVersion;
+		uint32_t m_bvhUpdateVersion;
+
+		//Reused to avoid allocating
+		std::vector<uint32_t> m_refitNodes;
+		std::vector<uint32_t> m_visibleNodes;
+
+		RenderQueue m_renderQueue;
+		std::vector<DrawBatch> m_batches;
+		DrawStats m_drawStats;
+		std::vector<DrawStats> m_chunkDrawStats;
+		std::vector<const CommandBuffer*> m_chunkCommandBuffers;
 
 		std::unordered_set<Asset::AssetHandle> m_loadedModels;
 		std::unordered_map<std::string, std::shared_ptr<Mesh>> m_meshes;
@@ -6,6 +6,7 @@ namespace SC
 	{
 		VERTEX,
 		FRAGMENT,
+		COMPUTE,
 		COUNT
 	};
 
@@ -20,6 +21,7 @@ namespace SC
 	public:
 		bool LoadModule(ShaderStage stage, const std::string& modulePath);
 		const ShaderBufferType& GetModule(ShaderStage stage) const;
+		bool IsCompute() const;
 	private:
 		ShaderModule();
 		ShaderModuleArray<ShaderBufferType> m_modules;
@@ -30,9 +32,12 @@ namespace SC
 	public:
 		ShaderModuleBuilder& SetVertexModulePath(const std::string& path);
 		ShaderModuleBuilder& SetFragmentModulePath(const std::string& path);
+		//Compute modules can't be combined with the other stages
+		ShaderModuleBuilder& SetComputeModulePath(const std::string& path);
 		std::unique_ptr<ShaderModule> Build();
 	private:
 		std::string m_vertexModulePath;
 		std::string m_fragmentModulePath;
+		std::string m_computeModulePath;
 	};
 }
@@ -32,9 +32,28 @@ namespace SC
 
 		virtual bool Build(uint32_t width, uint32_t height, bool generateMipmaps) = 0;
 		virtual bool LoadFromFile(const std::string& path) = 0;
-		virtual bool CopyData(const void* data, size_t size) = 0;
+		//data holds mipLevelCount levels packed one after the other from level 0, e.g. MipChain::pixels. When the texture was
+		//built with more levels the rest are generated on the GPU from the last one given
+		virtual bool CopyData(const void* data, size_t size, uint32_t mipLevelCount = 1) = 0;
+
+		//Streamed textures only keep the levels from the resident mip down on the GPU. BuildStreamed sets the full size
+		//without creating an image, it is created by the first SetResidentMip
+		virtual bool BuildStreamed(uint32_t width, uint32_t height) = 0;
+		//The image is replaced by one with the levels from residentMip down, the old one is destroyed once the frames using it
+		//have finished. Levels already resident are copied from the old image on the GPU, data only holds the missing ones,
+		//from residentMip to the resident mip packed like CopyData. It isn't read when levels are dropped and can be null.
+		//Descriptor sets using the texture have to be written again, GetImageVersion tells when
+		virtual bool SetResidentMip(const void* data, size_t size, uint32_t residentMip) = 0;
 
 		Format GetFormat() const;
+		uint32_t GetWidth() const;
+		uint32_t GetHeight() const;
+		uint32_t GetMipLevelCount() const;
+		//Most detailed level on the GPU, 0 unless the texture is streamed
+		uint32_t GetResidentMip() const;
+		bool IsStreamed() const;
+		//Incremented whenever the image is replaced
+		uint32_t GetImageVersion() const;
 	protected:
 		bool ReadImageFromFile(const std::string& path, ImageData& imageData);
 
@@ -43,6 +62,10 @@ namespace SC
 		TextureUsage m_usage;
 		Format m_format;
 		uint32_t m_width, m_height;
+		uint32_t m_mipLevels;
+		uint32_t m_residentMip;
+		bool m_streamed;
+		uint32_t m_imageVersion;
 	};
 
 	class Renderpass;
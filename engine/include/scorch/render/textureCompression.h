@@ -0,0 +1,33 @@
+#pragma once
+#include "pipeline.h"
+#include "mipChain.h"
+#include <string>
+
+namespace SC
+{
+	class ThreadPool;
+
+	//Every mip level of a block compressed image packed one after the other, level 0 first. Offsets and sizes of the levels
+	//are in bytes like MipChain so data can be given to Texture::CopyData as it is
+	struct CompressedTexture
+	{
+		Format format{ Format::UNDEFINED };
+		uint32_t width{ 0 };
+		uint32_t height{ 0 };
+		std::vector<uint8_t> data;
+		std::vector<MipLevel> levels;
+	};
+
+	//Encodes every level of an 8 bit RGBA chain to a BC format, blocks at the right and bottom edge repeat the last texel.
+	//BC1 drops alpha and BC5 only keeps red and green. BC7 only uses mode 6, one RGBA endpoint pair per block, which is
+	//good for most textures but blurs blocks with several distinct colours. Block rows are encoded in parallel when a
+	//thread pool is given, it must not be used by another thread while this runs
+	CompressedTexture CompressMipChain(const MipChain& chain, Format format, ThreadPool* threadPool = nullptr);
+
+	//Compressing is slow so the result is cached on disk, files are only read back when they were written by the same version.
+	//R8G8B8A8_SRGB chains can be cached the same way so streamed textures can reload their levels from disk
+	bool WriteCompressedTexture(const std::string& path, const CompressedTexture& texture);
+	bool ReadCompressedTexture(const std::string& path, CompressedTexture& texture);
+	//Reads levelCount levels from firstLevel without the rest of the file, packed one after the other like CompressedTexture::data
+	bool ReadCompressedTextureLevels(const std::string& path, uint32_t firstLevel, uint32_t levelCount, std::vector<uint8_t>& data);
+}
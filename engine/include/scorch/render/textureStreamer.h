@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace SC
+{
+	struct Texture;
+
+	struct TextureStreamingStats
+	{
+		uint32_t textures{ 0 };
+		uint32_t residentMips{ 0 }; //Levels on the GPU summed over every texture
+		uint32_t requestedMips{ 0 }; //Levels the last Update wanted before the budget was applied
+		uint32_t streamedIn{ 0 }; //Textures given more levels by the last Update
+		uint32_t evicted{ 0 }; //Textures that lost levels in the last Update
+		size_t residentBytes{ 0 };
+		size_t requestedBytes{ 0 };
+		size_t uploadedBytes{ 0 }; //By the last Update, only the levels that weren't resident are uploaded
+	};
+
+	struct StreamedTextureState
+	{
+		const Texture* texture;
+		uint32_t mipLevels;
+		uint32_t residentMip;
+		uint32_t requestedMip;
+	};
+
+	//Keeps only the levels of streamed textures that are needed on the GPU, the levels aren't kept on the CPU but read back
+	//from the texture cache when they are streamed in. Every frame the scene requests levels from how large the objects
+	//using a texture are on screen, Update then streams levels in or out so the resident levels fit the memory budget.
+	//Levels that are no longer requested stay for EVICT_DELAY_FRAMES so textures don't flicker between levels while the
+	//camera moves
+	class TextureStreamer
+	{
+	public:
+		static constexpr size_t DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+		//Uploads started by one Update, larger ones are spread over several frames. One texture is always streamed in even
+		//when it is larger so the biggest levels can still be loaded
+		static constexpr size_t MAX_UPLOAD_BYTES_PER_UPDATE = 16 * 1024 * 1024;
+		static constexpr uint32_t EVICT_DELAY_FRAMES = 120;
+		//Levels up to this size are loaded straight away and never evicted so there is always something to sample
+		static constexpr uint32_t MIN_RESIDENT_SIZE = 64;
+
+		TextureStreamer();
+
+		//The texture has to be built with Texture::BuildStreamed and cachePath has to hold its levels, see WriteCompressedTexture.
+		//mipChain holds every level like Texture::CopyData expects, the smallest levels are uploaded from it straight away and
+		//it isn't kept
+		void Add(Texture* texture, const std::string& cachePath, const std::vector<uint8_t>& mipChain);
+		void Remove(const Texture* texture);
+		bool Contains(const Texture* texture) const;
+
+		//Asks for the level that has about one texel per pixel when the texture covers screenSize pixels. Textures that
+		//aren't streamed are ignored, the most detailed level requested in a frame is used
+		void Request(const Texture* texture, float screenSize);
+		//Picks each texture's levels from this frame's requests and the budget and starts the uploads, call once per frame
+		void Update();
+
+		void SetMemoryBudget(size_t bytes);
+		size_t GetMemoryBudget() const;
+		//Added to every requested level, negative values ask for more detail. Useful as textures usually repeat across an
+		//object rather than covering it once as the requests assume
+		void SetMipBias(int bias);
+		int GetMipBias() const;
+
+		const TextureStreamingStats& GetStats() const;
+		void GetTextureStates(std::vector<StreamedTextureState>& states) const;
+	private:
+		struct StreamedTexture
+		{
+			Texture* texture;
+			std::string cachePath; //Cleared when reading it fails, the texture then keeps the levels it has
+			uint32_t minimumMip; //Least detailed level allowed, levels from here down are always resident
+			uint32_t requestedMip; //Most detailed level requested this frame, minimumMip when there were no requests
+			uint32_t lastRequestedMip; //requestedMip of the last Update
+			uint32_t targetMip;
+			uint64_t lastUsedFrame; //Last frame a level at least as detailed as the resident one was requested
+		};
+
+		static size_t ResidentSize(const Texture& texture, uint32_t residentMip);
+
+		std::unordered_map<const Texture*, StreamedTexture> m_textures;
+		size_t m_memoryBudget;
+		int m_mipBias;
+		uint64_t m_frame;
+		TextureStreamingStats m_stats;
+
+		//Reused to avoid allocating
+		std::vector<StreamedTexture*> m_streamIn;
+		std::vector<uint8_t> m_levelData;
+	};
+}
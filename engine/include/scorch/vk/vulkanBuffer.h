@@ -12,6 +12,8 @@ namespace SC
 		~VulkanBuffer();
 		ScopedMapData Map() override;
 		void CopyFrom(Buffer* src) override;
+		void CopyFrom(Buffer* src, size_t srcOffset, size_t dstOffset, size_t size) override;
+		void CopyData(const void* data, size_t size, size_t offset = 0) override;
 
 		void Destroy() override;
 
@@ -19,6 +21,7 @@ namespace SC
 	private:
 		VkBuffer m_buffer;
 		VmaAllocation m_allocation;
+		void* m_mapped; //Buffers with the MAP usage stay mapped for their lifetime
 
 		DeletionQueue m_deletionQueue;
 	};
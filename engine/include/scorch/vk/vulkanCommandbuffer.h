@@ -14,7 +14,8 @@ namespace SC
 
 		VkCommandPool GetCommandPool() const;
 
-		std::unique_ptr<CommandBuffer> CreateCommandBuffer() override;
+		std::unique_ptr<CommandBuffer> CreateCommandBuffer(CommandBufferLevel level = CommandBufferLevel::PRIMARY) override;
+		void Reset() override;
 
 	private:
 		void Init();
@@ -28,13 +29,15 @@ namespace SC
 	{
 	public:
 		friend class VulkanCommandPool;
-		VulkanCommandBuffer();
+		VulkanCommandBuffer(CommandBufferLevel level = CommandBufferLevel::PRIMARY);
 		~VulkanCommandBuffer();
 
-		void BeginRecording() const;
+		void BeginRecording();
+		void BeginRecording(const Renderpass* renderPass, const RenderTarget* renderTarget);
 		void EndRecording() const;
 
-		void BeginRenderPass(const Renderpass* renderPass, const RenderTarget* renderTarget, float clearR = 0, float clearG = 0, float clearB = 0, float clearDepth = 1.0f);
+		void BeginRenderPass(const Renderpass* renderPass, const RenderTarget* renderTarget, float clearR = 0, float clearG = 0, float clearB = 0, float clearDepth = 1.0f,
+			SubpassContents contents = SubpassContents::INLINE);
 		void EndRenderPass();
 
 
@@ -44,16 +47,60 @@ namespace SC
 		void BindPipeline(const Pipeline* pipeline);
 		void BindVertexBuffer(const Buffer* buffer);
 		void BindIndexBuffer(const Buffer* buffer);
-		void BindDescriptorSet(const PipelineLayout* pipelineLayout, const DescriptorSet* descriptorSet, int set = 0);
+		void BindDescriptorSet(const PipelineLayout* pipelineLayout, const DescriptorSet* descriptorSet, int set = 0,
+			const uint32_t* dynamicOffsets = nullptr, uint32_t dynamicOffsetCount = 0);
 		void PushConstants(const PipelineLayout* pipelineLayout, uint32_t rangeIndex, uint32_t offset, uint32_t size, void* data);
 		void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
 		void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, uint32_t vertexOffset, uint32_t firstInstance);
+		void DrawIndexedIndirect(const Buffer* buffer, size_t offset, uint32_t drawCount, uint32_t stride = sizeof(DrawIndexedIndirectCommand));
+		void DrawIndexedIndirectCount(const Buffer* buffer, size_t offset, const Buffer* countBuffer, size_t countOffset, uint32_t maxDrawCount, uint32_t stride = sizeof(DrawIndexedIndirectCommand));
+		void ExecuteCommands(const CommandBuffer* const* commandBuffers, uint32_t count);
+		void Dispatch(uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+		void PipelineBarrier(const PipelineStageFlags& srcStages, const PipelineStageFlags& dstStages);
 
 		void ResetCommands();
 
+		void InvalidateState();
+		const CommandBufferStats& GetStats() const;
+
 		const VkCommandBuffer& GetCommandBuffer() const;
+	private:
+		//Sets and dynamic offsets past these are always recorded
+		static constexpr uint32_t MAX_TRACKED_SETS = 4;
+		static constexpr uint32_t MAX_TRACKED_DYNAMIC_OFFSETS = 4;
+
+		struct BoundDescriptorSet
+		{
+			VkDescriptorSet set;
+			std::array<uint32_t, MAX_TRACKED_DYNAMIC_OFFSETS> dynamicOffsets;
+			uint32_t dynamicOffsetCount;
+		};
+
+		//Indexed by VkPipelineBindPoint, graphics and compute are tracked separately
+		struct BindPointState
+		{
+			VkPipeline pipeline;
+			VkPipelineLayout layout; //Of the bound descriptor sets
+			std::array<BoundDescriptorSet, MAX_TRACKED_SETS> descriptorSets;
+		};
+
+		struct BoundState
+		{
+			std::array<BindPointState, 2> bindPoints;
+			VkBuffer vertexBuffer;
+			VkBuffer indexBuffer;
+			VkViewport viewport;
+			VkRect2D scissor;
+			bool viewportSet;
+			bool scissorSet;
+		};
 	private:
 		VkCommandBuffer m_commandBuffer;
+		CommandBufferLevel m_level;
+		VkPipelineBindPoint m_bindPoint; //Of the last bound pipeline
 		DeletionQueue m_freeCommandQueue; //Frees the command buffer using the command pool that was used to create this buffer
+
+		BoundState m_boundState;
+		CommandBufferStats m_stats;
 	};
 }
\ No newline at end of file
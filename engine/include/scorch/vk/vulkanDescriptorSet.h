@@ -27,7 +27,7 @@ namespace SC
 		VulkanDescriptorSet(const DescriptorSetLayout* layout);
 		~VulkanDescriptorSet();
 
-		void SetBuffer(const Buffer* buffer, uint32_t binding) override;
+		void SetBuffer(const Buffer* buffer, uint32_t binding, size_t offset = 0, size_t range = 0) override;
 		void SetTexture(const Texture* texture, uint32_t binding) override;
 
 		VkDescriptorSet m_descriptorSet;
@@ -28,9 +28,11 @@ namespace SC
 		bool Build(const Renderpass* renderpass = nullptr) override;
 
 		VkPipeline GetPipeline() const;
+		VkPipelineBindPoint GetBindPoint() const;
 	private:
 		VkPipeline m_pipeline;
 		VkPipelineLayout m_tempPipelineLayout; //For now each pipeline has its own layout, in the future we need to cache and reuse layouts that are the same
+		VkPipelineBindPoint m_bindPoint;
 
 		DeletionQueue m_deletionQueue;
 	};
@@ -4,6 +4,7 @@
 #include "core/utils.h"
 #include "vk_mem_alloc.h"
 #include "vulkanTexture.h"
+#include <mutex>
 
 #define VK_CHECK(x)                                                 \
 	do                                                              \
@@ -22,6 +23,7 @@ namespace SC
 	class VulkanRenderpass;
 	class CommandPool;
 	class CommandBuffer;
+	class VulkanUploadManager;
 
 	struct VulkanFrameData
 	{
@@ -30,6 +32,10 @@ namespace SC
 
 		std::unique_ptr<CommandPool> m_commandPool;
 		std::unique_ptr<CommandBuffer> m_mainCommandBuffer;
+
+		//Command pools are not thread safe so each secondary command buffer has a pool of its own
+		std::vector<std::unique_ptr<CommandPool>> m_secondaryCommandPools;
+		std::vector<std::unique_ptr<CommandBuffer>> m_secondaryCommandBuffers;
 	};
 
 	struct UploadContext
@@ -52,12 +58,22 @@ namespace SC
 		void BeginFrame() override;
 		void EndFrame() override;
 		void SubmitCommandBuffer(const CommandBuffer& commandBuffer) override;
+		void SubmitAndWait(const CommandBuffer& commandBuffer) override;
 
 		CommandBuffer& GetFrameCommandBuffer() const override;
+		void ReserveSecondaryCommandBuffers(uint32_t count) override;
+		CommandBuffer& GetFrameSecondaryCommandBuffer(uint32_t index) const override;
+		uint32_t SecondaryCommandBufferCount() const override;
 
 		void ImmediateSubmit(std::function<void(VkCommandBuffer cmd)>&& function) const;
+		//Queues are externally synchronised, every submission goes through here so uploads can be submitted from any thread
+		void QueueSubmit(VkQueue queue, const VkSubmitInfo& submit, VkFence fence) const;
+
+		//Runs deletor once every frame that could be using the resource has finished instead of waiting for the frames in
+		//flight. deletor must only capture handles by value as the resource it came from is usually gone by then
+		void DeferDestroy(std::function<void()>&& deletor) const;
 
-		void WaitOnFences() const;
+		VulkanUploadManager& GetUploadManager() const;
 
 		VulkanFrameData& GetCurrentFrame();
 		const VulkanFrameData& GetCurrentFrame() const;
@@ -67,6 +83,8 @@ namespace SC
 		Renderpass* DefaultRenderPass() const override;
 		RenderTarget* DefaultRenderTarget() const override;
 
+		UploadStats GetUploadStats() const override;
+
 	private:
 		void InitVulkan();
 		void InitSwapchain();
@@ -78,6 +96,11 @@ namespace SC
 		void InitSyncStructures();
 
 		void InitDescriptors();
+
+		void InitUploads();
+
+		//Runs the deferred deletors of frames whose fence has signalled, or every deletor when all is set
+		void DestroyRetiredResources(bool all);
 	public:
 		VkInstance m_instance;
 		VkDebugUtilsMessengerEXT m_debug_messenger; // Vulkan debug output handle
@@ -94,6 +117,10 @@ namespace SC
 		VkQueue m_graphicsQueue; //queue we will submit to
 		uint32_t m_graphicsQueueFamily; //family of that queue
 
+		//Dedicated transfer queue for uploads, the graphics queue when the device doesn't have one
+		VkQueue m_transferQueue;
+		uint32_t m_transferQueueFamily;
+
 		std::unique_ptr<VulkanRenderpass> m_vulkanRenderPass;
 
 		VmaAllocator m_allocator; //vma lib allocator
@@ -105,6 +132,23 @@ namespace SC
 		uint32_t m_swapchainImageIndex;
 
 		UploadContext m_uploadContext;
+		std::unique_ptr<VulkanUploadManager> m_uploadManager;
+
+		struct DeferredDeletor
+		{
+			uint64_t frame; //Frame being recorded when the resource was destroyed
+			std::function<void()> deletor;
+		};
+		//Oldest first, frames only grow
+		mutable std::deque<DeferredDeletor> m_deferredDeletors;
+		mutable std::mutex m_deferredDeletorMutex;
+		//Set once the device is idle during cleanup
+		bool m_destroyImmediately;
+		mutable std::mutex m_queueMutex;
+
+		//Reused by SubmitCommandBuffer so submitting doesn't allocate
+		std::vector<VkSemaphore> m_submitWaitSemaphores;
+		std::vector<VkPipelineStageFlags> m_submitWaitStages;
 
 		std::array<VulkanFrameData, FRAME_OVERLAP_COUNT[to_underlying(GraphicsAPI::VULKAN)]> m_frames;
 	};
@@ -14,14 +14,24 @@ namespace SC
 
 		bool Build(uint32_t width, uint32_t height, bool generateMipmaps) override;
 		bool LoadFromFile(const std::string& path) override;
-		bool CopyData(const void* data, size_t size) override;
+		bool CopyData(const void* data, size_t size, uint32_t mipLevelCount = 1) override;
+		bool BuildStreamed(uint32_t width, uint32_t height) override;
+		bool SetResidentMip(const void* data, size_t size, uint32_t residentMip) override;
 	public:
 		VkImage m_image;
 		VmaAllocation m_allocation;
 		VkImageView  m_imageView;
 	private:
+		//Records copies of mipLevelCount packed levels from the staging buffer into image, which has imageLevels levels of which
+		//the first is width x height. Levels that aren't given are blitted, the image is left ready for the fragment shader
+		void RecordCopy(VkCommandBuffer cmd, VkBuffer stagingBuffer, VkDeviceSize stagingOffset, VkImage image,
+			uint32_t width, uint32_t height, uint32_t imageLevels, uint32_t mipLevelCount) const;
+		//Records filling image, which has the levels from residentMip down, for a streamed texture. Levels more detailed than
+		//the resident ones come from the staging buffer and the rest are copied from the resident image, both images are left
+		//ready for the fragment shader
+		void RecordResidentCopy(VkCommandBuffer cmd, VkBuffer stagingBuffer, VkDeviceSize stagingOffset, VkImage image, uint32_t residentMip) const;
+
 		DeletionQueue m_deletionQueue;
-		uint32_t m_mipLevels;
 	};
 
 	struct VulkanRenderTarget : RenderTarget
@@ -0,0 +1,126 @@
+#pragma once
+#include "render/renderer.h"
+#include "volk.h"
+#include "vk_mem_alloc.h"
+#include "core/utils.h"
+#include <array>
+#include <deque>
+#include <map>
+#include <mutex>
+
+namespace SC
+{
+	class VulkanRenderer;
+
+	//Queue an upload's commands are recorded for
+	enum class UploadQueue
+	{
+		TRANSFER, //Copies only, runs on a dedicated transfer queue when the device has one
+		GRAPHICS, //Needs the graphics queue, e.g. blits to generate mipmaps or barriers for shader stages
+		COUNT
+	};
+
+	//Packs uploads into batches instead of submitting and waiting for every resource. Data is staged in a persistently mapped
+	//ring buffer per queue and the copies are recorded into the batch's command buffer, which is submitted when Flush is called,
+	//when the ring needs space or when the renderer submits a frame. The frame waits on a semaphore signalled by the last batch
+	//so everything uploaded before it is visible to it, the CPU only waits when staging memory is still in use by the GPU
+	class VulkanUploadManager
+	{
+	public:
+		//Staging memory per queue, larger uploads use pooled staging buffers rounded up to a power of two
+		static constexpr VkDeviceSize STAGING_RING_CAPACITY = 32 * 1024 * 1024;
+		static constexpr uint32_t BATCHES_PER_QUEUE = 4;
+		//Free pooled staging buffers kept per size, more than this are released once their upload has finished
+		static constexpr uint32_t MAX_FREE_STAGING_PER_SIZE = 2;
+
+		using RecordFunc = FunctionRef<void(VkCommandBuffer cmd, VkBuffer stagingBuffer, VkDeviceSize stagingOffset)>;
+
+		VulkanUploadManager(const VulkanRenderer* renderer);
+		~VulkanUploadManager();
+
+		VulkanUploadManager(const VulkanUploadManager&) = delete;
+		VulkanUploadManager& operator=(const VulkanUploadManager&) = delete;
+
+		//Copies size bytes of data to staging memory aligned to alignment and calls record to record the commands reading it.
+		//data can be freed as soon as this returns
+		void Upload(UploadQueue queue, const void* data, VkDeviceSize size, VkDeviceSize alignment, RecordFunc record);
+		//Records commands that don't need staging memory, e.g. buffer to buffer copies
+		void Record(UploadQueue queue, FunctionRef<void(VkCommandBuffer cmd)> record);
+
+		//Submits the batches being recorded without waiting for them
+		void Flush();
+		//Flush and have each queue signal a semaphore for frameIndex if anything was submitted since the last frame, the
+		//semaphores are added to waitSemaphores. Call once per frame submission
+		void FlushForFrame(uint8_t frameIndex, std::vector<VkSemaphore>& waitSemaphores);
+		//Flush and block until every upload has finished on the GPU
+		void WaitIdle();
+
+		bool HasTransferQueue() const;
+		UploadStats GetStats() const;
+	private:
+		struct StagingBuffer
+		{
+			VkBuffer buffer{ VK_NULL_HANDLE };
+			VmaAllocation allocation{ VK_NULL_HANDLE };
+			uint8_t* data{ nullptr };
+			VkDeviceSize size{ 0 };
+		};
+
+		struct Batch
+		{
+			VkCommandPool commandPool{ VK_NULL_HANDLE };
+			VkCommandBuffer commandBuffer{ VK_NULL_HANDLE };
+			VkFence fence{ VK_NULL_HANDLE };
+			uint64_t ringEnd{ 0 }; //Ring position the staging memory is free up to once the batch has finished
+			std::vector<StagingBuffer> pooledStaging; //Uploads too large for the ring, returned to the pool once finished
+			bool recording{ false };
+			bool submitted{ false };
+		};
+
+		struct Lane
+		{
+			VkQueue queue{ VK_NULL_HANDLE };
+			uint32_t queueFamily{ 0 };
+
+			StagingBuffer ring;
+			//Positions only grow, the offset into the ring is position % STAGING_RING_CAPACITY
+			uint64_t ringHead{ 0 };
+			uint64_t ringTail{ 0 };
+
+			std::array<Batch, BATCHES_PER_QUEUE> batches;
+			uint32_t currentBatch{ 0 };
+			std::deque<uint32_t> submittedBatches; //Oldest first
+			bool needsFrameSync{ false }; //Batches were submitted since a frame last waited on this queue
+			std::vector<VkSemaphore> frameSemaphores;
+
+			//Free staging buffers by size, only used by this queue so their contents never change queue family
+			std::map<VkDeviceSize, std::vector<StagingBuffer>> freeStaging;
+		};
+
+		Lane& GetLane(UploadQueue queue);
+		void CreateLane(Lane& lane, VkQueue queue, uint32_t queueFamily);
+		void DestroyLane(Lane& lane);
+
+		StagingBuffer CreateStagingBuffer(VkDeviceSize size);
+		void DestroyStagingBuffer(StagingBuffer& stagingBuffer);
+		StagingBuffer AcquirePooledStaging(Lane& lane, VkDeviceSize size);
+		void ReleasePooledStaging(Lane& lane, StagingBuffer& stagingBuffer);
+		void UpdateStagingPeak();
+
+		bool TryAllocateStaging(Lane& lane, VkDeviceSize size, VkDeviceSize alignment, uint64_t& position) const;
+		//Returns the command buffer of the batch being recorded, starting a batch when there isn't one
+		VkCommandBuffer BeginBatch(Lane& lane);
+		void SubmitBatch(Lane& lane, VkSemaphore signalSemaphore);
+		//Waits for the oldest submitted batch and frees its staging memory
+		void RetireOldestBatch(Lane& lane);
+		void FlushLocked();
+
+		const VulkanRenderer* m_renderer;
+		//Only one lane when there is no dedicated transfer queue, both queues then use it
+		std::vector<Lane> m_lanes;
+		std::array<uint32_t, static_cast<size_t>(UploadQueue::COUNT)> m_laneIndices;
+		UploadStats m_stats;
+		size_t m_pooledStagingInUse;
+		mutable std::mutex m_mutex;
+	};
+}
@@ -9,4 +9,5 @@ namespace vkutils
 	VkAttachmentLoadOp ConvertLoadOp(SC::AttachmentLoadOp loadOp);
 	VkAttachmentStoreOp ConvertStoreOp(SC::AttachmentStoreOp storeOp);
 	VkImageLayout ConvertImageLayout(SC::ImageLayout layout);
+	VkShaderStageFlags ConvertShaderStages(const SC::ShaderModuleFlags& stages);
 }
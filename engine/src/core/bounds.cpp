@@ -0,0 +1,52 @@
+#include "pch.h"
+#include "core/bounds.h"
+
+using namespace SC;
+
+AABB AABB::Transformed(const glm::mat4& transform) const
+{
+	if (IsEmpty())
+		return AABB();
+
+	//Transform the center and project the extents onto each axis using the absolute rotation/scale part of the matrix
+	const glm::vec3 x = glm::vec3(transform[0]);
+	const glm::vec3 y = glm::vec3(transform[1]);
+	const glm::vec3 z = glm::vec3(transform[2]);
+
+	const glm::vec3 center = Center();
+	const glm::vec3 extents = Extents();
+	const glm::vec3 worldCenter = x * center.x + y * center.y + z * center.z + glm::vec3(transform[3]);
+	const glm::vec3 worldExtents = glm::abs(x) * extents.x + glm::abs(y) * extents.y + glm::abs(z) * extents.z;
+
+	return AABB(worldCenter - worldExtents, worldCenter + worldExtents);
+}
+
+void AABBArray::Add(const AABB& bounds)
+{
+	minX.push_back(bounds.min.x);
+	minY.push_back(bounds.min.y);
+	minZ.push_back(bounds.min.z);
+	maxX.push_back(bounds.max.x);
+	maxY.push_back(bounds.max.y);
+	maxZ.push_back(bounds.max.z);
+}
+
+void AABBArray::Set(uint32_t index, const AABB& bounds)
+{
+	minX[index] = bounds.min.x;
+	minY[index] = bounds.min.y;
+	minZ[index] = bounds.min.z;
+	maxX[index] = bounds.max.x;
+	maxY[index] = bounds.max.y;
+	maxZ[index] = bounds.max.z;
+}
+
+void AABBArray::Clear()
+{
+	minX.clear();
+	minY.clear();
+	minZ.clear();
+	maxX.clear();
+	maxY.clear();
+	maxZ.clear();
+}
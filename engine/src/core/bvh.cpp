@@ -0,0 +1,445 @@
+#include "pch.h"
+#include "core/bvh.h"
+#include "core/threadPool.h"
+#include <numeric>
+
+using namespace SC;
+
+namespace
+{
+	constexpr uint32_t BIN_COUNT = 16;
+	//Nodes with this many primitives or less are always leaves, larger nodes only become leaves when the SAH prefers it
+	constexpr uint32_t LEAF_MAX_PRIMITIVES = 4;
+	constexpr uint32_t SAH_LEAF_MAX_PRIMITIVES = 16;
+	//Cost of visiting a node relative to testing a primitive
+	constexpr float TRAVERSAL_COST = 1.0f;
+	//Deeper nodes are made leaves so traversals can use a fixed size stack
+	constexpr uint32_t MAX_DEPTH = 48;
+	constexpr uint32_t STACK_SIZE = MAX_DEPTH + 2;
+
+	//Builds smaller than this are not worth splitting across threads
+	constexpr uint32_t PARALLEL_BUILD_MIN_PRIMITIVES = 16384;
+	constexpr uint32_t PARALLEL_BUILD_MIN_TASK_SIZE = 2048;
+
+	struct Bin
+	{
+		AABB bounds;
+		uint32_t count{ 0 };
+	};
+
+	uint32_t BinIndex(float centroid, float min, float scale)
+	{
+		return std::min(BIN_COUNT - 1, static_cast<uint32_t>((centroid - min) * scale));
+	}
+}
+
+BVH::BVH() :
+	m_nodeCount(0)
+{
+
+}
+
+void BVH::Build(const AABB* bounds, uint32_t count, ThreadPool* threadPool)
+{
+	Clear();
+	if (count == 0) return;
+
+	m_primitives.resize(count);
+	std::iota(m_primitives.begin(), m_primitives.end(), 0);
+
+	m_centroids.resize(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		m_centroids[i] = bounds[i].IsEmpty() ? glm::vec3(0.0f) : bounds[i].Center();
+	}
+
+	//A binary tree with a primitive or more per leaf never needs more nodes than this
+	m_nodes.resize(2 * count - 1);
+	m_parents.resize(2 * count - 1);
+	m_nodes[0] = Node{ AABB(), 0, count };
+	m_parents[0] = INVALID_INDEX;
+	m_nodeCount = 1;
+
+	if (threadPool && threadPool->ThreadCount() > 1 && count >= PARALLEL_BUILD_MIN_PRIMITIVES)
+	{
+		//The top of the tree is split serially until there are enough subtrees to keep every thread busy, the subtrees don't
+		//share any primitives or nodes so they can then be built independently
+		const uint32_t taskSize = std::max(PARALLEL_BUILD_MIN_TASK_SIZE, count / (threadPool->ThreadCount() * 4));
+
+		m_buildTasks.clear();
+		m_buildStack.clear();
+		m_buildStack.push_back({ 0, 0 });
+		while (!m_buildStack.empty())
+		{
+			const BuildTask task = m_buildStack.back();
+			m_buildStack.pop_back();
+
+			if (m_nodes[task.node].count <= taskSize)
+			{
+				m_buildTasks.push_back(task);
+			}
+			else if (Split(task.node, task.depth, bounds))
+			{
+				m_buildStack.push_back({ m_nodes[task.node].first, task.depth + 1 });
+				m_buildStack.push_back({ m_nodes[task.node].first + 1, task.depth + 1 });
+			}
+		}
+
+		threadPool->ParallelFor(static_cast<uint32_t>(m_buildTasks.size()), [this, bounds](uint32_t index)
+			{
+				BuildSubtree(m_buildTasks[index].node, m_buildTasks[index].depth, bounds);
+			});
+	}
+	else
+	{
+		BuildSubtree(0, 0, bounds);
+	}
+
+	m_nodes.resize(m_nodeCount);
+	m_parents.resize(m_nodeCount);
+
+	m_primitiveBounds.resize(count);
+	m_primitiveSlots.resize(count);
+	m_primitiveLeaves.resize(count);
+	for (uint32_t nodeIndex = 0; nodeIndex < m_nodes.size(); ++nodeIndex)
+	{
+		const Node& node = m_nodes[nodeIndex];
+		for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+		{
+			const uint32_t primitive = m_primitives[slot];
+			m_primitiveBounds[slot] = bounds[primitive];
+			m_primitiveSlots[primitive] = slot;
+			m_primitiveLeaves[primitive] = nodeIndex;
+		}
+	}
+}
+
+void BVH::BuildSubtree(uint32_t nodeIndex, uint32_t depth, const AABB* bounds)
+{
+	//At most one pending sibling per level, plus the node being split
+	std::array<BuildTask, STACK_SIZE> stack;
+	uint32_t stackSize = 0;
+	stack[stackSize++] = { nodeIndex, depth };
+	while (stackSize > 0)
+	{
+		const BuildTask task = stack[--stackSize];
+		if (Split(task.node, task.depth, bounds))
+		{
+			stack[stackSize++] = { m_nodes[task.node].first + 1, task.depth + 1 };
+			stack[stackSize++] = { m_nodes[task.node].first, task.depth + 1 };
+		}
+	}
+}
+
+bool BVH::Split(uint32_t nodeIndex, uint32_t depth, const AABB* bounds)
+{
+	Node& node = m_nodes[nodeIndex];
+	const uint32_t begin = node.first;
+	const uint32_t end = node.first + node.count;
+
+	AABB centroidBounds;
+	node.bounds = AABB();
+	for (uint32_t slot = begin; slot < end; ++slot)
+	{
+		const uint32_t primitive = m_primitives[slot];
+		node.bounds.Expand(bounds[primitive]);
+		centroidBounds.Expand(m_centroids[primitive]);
+	}
+
+	if (node.count <= LEAF_MAX_PRIMITIVES || depth >= MAX_DEPTH)
+		return false;
+
+	//Bin the centroids along each axis and pick the boundary between bins with the lowest surface area cost
+	float bestCost = std::numeric_limits<float>::max();
+	uint32_t bestAxis = 0;
+	uint32_t bestBin = 0;
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		const float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+		if (extent <= 0.0f) continue;
+
+		const float scale = BIN_COUNT / extent;
+		std::array<Bin, BIN_COUNT> bins;
+		for (uint32_t slot = begin; slot < end; ++slot)
+		{
+			const uint32_t primitive = m_primitives[slot];
+			Bin& bin = bins[BinIndex(m_centroids[primitive][axis], centroidBounds.min[axis], scale)];
+			bin.bounds.Expand(bounds[primitive]);
+			++bin.count;
+		}
+
+		//Sweep from the right to get the cost of everything after each boundary, then from the left to finish the costs
+		std::array<float, BIN_COUNT - 1> rightCosts;
+		AABB rightBounds;
+		uint32_t rightCount = 0;
+		for (uint32_t i = BIN_COUNT - 1; i > 0; --i)
+		{
+			rightBounds.Expand(bins[i].bounds);
+			rightCount += bins[i].count;
+			rightCosts[i - 1] = rightCount > 0 ? rightBounds.SurfaceArea() * rightCount : std::numeric_limits<float>::max();
+		}
+
+		AABB leftBounds;
+		uint32_t leftCount = 0;
+		for (uint32_t i = 0; i < BIN_COUNT - 1; ++i)
+		{
+			leftBounds.Expand(bins[i].bounds);
+			leftCount += bins[i].count;
+			if (leftCount == 0 || leftCount == node.count) continue;
+
+			const float cost = leftBounds.SurfaceArea() * leftCount + rightCosts[i];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = i;
+			}
+		}
+	}
+
+	uint32_t leftCount = node.count / 2;
+	if (bestCost < std::numeric_limits<float>::max())
+	{
+		const float leafCost = node.bounds.SurfaceArea() * node.count;
+		if (TRAVERSAL_COST * node.bounds.SurfaceArea() + bestCost >= leafCost && node.count <= SAH_LEAF_MAX_PRIMITIVES)
+			return false;
+
+		const float min = centroidBounds.min[bestAxis];
+		const float scale = BIN_COUNT / (centroidBounds.max[bestAxis] - min);
+		const auto middle = std::partition(m_primitives.begin() + begin, m_primitives.begin() + end, [&](uint32_t primitive)
+			{
+				return BinIndex(m_centroids[primitive][bestAxis], min, scale) <= bestBin;
+			});
+		leftCount = static_cast<uint32_t>(middle - (m_primitives.begin() + begin));
+	}
+	//Otherwise every centroid is in the same place, splitting the range in half still keeps the leaves small
+
+	const uint32_t children = m_nodeCount.fetch_add(2);
+	CORE_ASSERT(children + 1 < m_nodes.size(), "BVH node array is too small");
+
+	m_nodes[children] = Node{ AABB(), begin, leftCount };
+	m_nodes[children + 1] = Node{ AABB(), begin + leftCount, node.count - leftCount };
+	m_parents[children] = nodeIndex;
+	m_parents[children + 1] = nodeIndex;
+
+	node.first = children;
+	node.count = 0;
+
+	return true;
+}
+
+void BVH::Clear()
+{
+	m_nodes.clear();
+	m_parents.clear();
+	m_primitives.clear();
+	m_primitiveBounds.clear();
+	m_primitiveSlots.clear();
+	m_primitiveLeaves.clear();
+	m_nodeCount = 0;
+}
+
+void BVH::Refit(const AABB* bounds, const uint32_t* primitives, uint32_t primitiveCount)
+{
+	//Collect the leaves of the primitives and every node above them once
+	m_refitVisited.resize(m_nodes.size(), false);
+	m_refitNodes.clear();
+	for (uint32_t i = 0; i < primitiveCount; ++i)
+	{
+		const uint32_t primitive = primitives[i];
+		CORE_ASSERT(primitive < PrimitiveCount(), "Primitive is not in the BVH");
+
+		m_primitiveBounds[m_primitiveSlots[primitive]] = bounds[primitive];
+		for (uint32_t node = m_primitiveLeaves[primitive]; node != INVALID_INDEX && !m_refitVisited[node]; node = m_parents[node])
+		{
+			m_refitVisited[node] = true;
+			m_refitNodes.push_back(node);
+		}
+	}
+
+	//Children are stored after their parent so refitting from the back updates each child before its parent reads it
+	std::sort(m_refitNodes.begin(), m_refitNodes.end(), std::greater<uint32_t>());
+	for (uint32_t node : m_refitNodes)
+	{
+		m_refitVisited[node] = false;
+		UpdateNodeBounds(node);
+	}
+}
+
+void BVH::Refit(const AABB* bounds)
+{
+	for (uint32_t slot = 0; slot < m_primitives.size(); ++slot)
+	{
+		m_primitiveBounds[slot] = bounds[m_primitives[slot]];
+	}
+
+	for (size_t node = m_nodes.size(); node-- > 0;)
+	{
+		UpdateNodeBounds(static_cast<uint32_t>(node));
+	}
+}
+
+void BVH::UpdateNodeBounds(uint32_t nodeIndex)
+{
+	Node& node = m_nodes[nodeIndex];
+	if (node.IsLeaf())
+	{
+		node.bounds = AABB();
+		for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+		{
+			node.bounds.Expand(m_primitiveBounds[slot]);
+		}
+	}
+	else
+	{
+		node.bounds = m_nodes[node.first].bounds;
+		node.bounds.Expand(m_nodes[node.first + 1].bounds);
+	}
+}
+
+uint32_t BVH::Query(const Frustum& frustum, std::vector<uint32_t>& primitives) const
+{
+	if (m_nodes.empty()) return 0;
+
+	//Nodes are pushed with whether their parent was completely inside, those don't need testing
+	std::array<std::pair<uint32_t, bool>, STACK_SIZE> stack;
+	uint32_t stackSize = 0;
+	uint32_t tested = 0;
+
+	stack[stackSize++] = { 0, false };
+	while (stackSize > 0)
+	{
+		auto [nodeIndex, inside] = stack[--stackSize];
+		const Node& node = m_nodes[nodeIndex];
+
+		if (!inside)
+		{
+			++tested;
+			const FrustumTest result = frustum.Classify(node.bounds);
+			if (result == FrustumTest::OUTSIDE) continue;
+			inside = result == FrustumTest::INSIDE;
+		}
+
+		if (node.IsLeaf())
+		{
+			for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+			{
+				const AABB& bounds = m_primitiveBounds[slot];
+				if (inside ? !bounds.IsEmpty() : (++tested, frustum.Intersects(bounds)))
+					primitives.push_back(m_primitives[slot]);
+			}
+			continue;
+		}
+
+		stack[stackSize++] = { node.first + 1, inside };
+		stack[stackSize++] = { node.first, inside };
+	}
+
+	return tested;
+}
+
+uint32_t BVH::Query(const AABB& bounds, std::vector<uint32_t>& primitives) const
+{
+	if (m_nodes.empty()) return 0;
+
+	std::array<uint32_t, STACK_SIZE> stack;
+	uint32_t stackSize = 0;
+	uint32_t tested = 0;
+
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const Node& node = m_nodes[stack[--stackSize]];
+
+		++tested;
+		if (!node.bounds.Overlaps(bounds)) continue;
+
+		if (node.IsLeaf())
+		{
+			for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+			{
+				++tested;
+				if (m_primitiveBounds[slot].Overlaps(bounds))
+					primitives.push_back(m_primitives[slot]);
+			}
+			continue;
+		}
+
+		stack[stackSize++] = node.first + 1;
+		stack[stackSize++] = node.first;
+	}
+
+	return tested;
+}
+
+uint32_t BVH::Raycast(const Ray& ray, float maxDistance, FunctionRef<float(uint32_t primitive, float maxDistance)> visit) const
+{
+	if (m_nodes.empty()) return 0;
+
+	const glm::vec3 inverseDirection = 1.0f / ray.direction;
+
+	//Nodes are pushed with the distance to their box so the ones behind a closer hit are skipped when popped
+	std::array<std::pair<uint32_t, float>, STACK_SIZE> stack;
+	uint32_t stackSize = 0;
+	uint32_t tested = 1;
+
+	const float rootDistance = IntersectRayAABB(ray.origin, inverseDirection, m_nodes[0].bounds, maxDistance);
+	if (rootDistance < 0.0f) return tested;
+
+	stack[stackSize++] = { 0, rootDistance };
+	while (stackSize > 0)
+	{
+		const auto [nodeIndex, distance] = stack[--stackSize];
+		if (distance > maxDistance) continue;
+
+		const Node& node = m_nodes[nodeIndex];
+		if (node.IsLeaf())
+		{
+			for (uint32_t slot = node.first; slot < node.first + node.count; ++slot)
+			{
+				++tested;
+				if (IntersectRayAABB(ray.origin, inverseDirection, m_primitiveBounds[slot], maxDistance) >= 0.0f)
+					maxDistance = visit(m_primitives[slot], maxDistance);
+			}
+			continue;
+		}
+
+		tested += 2;
+		const float left = IntersectRayAABB(ray.origin, inverseDirection, m_nodes[node.first].bounds, maxDistance);
+		const float right = IntersectRayAABB(ray.origin, inverseDirection, m_nodes[node.first + 1].bounds, maxDistance);
+
+		//The nearer child is pushed last so it is visited first
+		const bool leftFirst = right < 0.0f || (left >= 0.0f && left <= right);
+		const uint32_t nearChild = leftFirst ? node.first : node.first + 1;
+		const uint32_t farChild = leftFirst ? node.first + 1 : node.first;
+		const float nearDistance = leftFirst ? left : right;
+		const float farDistance = leftFirst ? right : left;
+
+		if (farDistance >= 0.0f)
+			stack[stackSize++] = { farChild, farDistance };
+		if (nearDistance >= 0.0f)
+			stack[stackSize++] = { nearChild, nearDistance };
+	}
+
+	return tested;
+}
+
+uint32_t BVH::PrimitiveAt(uint32_t slot) const
+{
+	return m_primitives[slot];
+}
+
+const AABB& BVH::PrimitiveBounds(uint32_t slot) const
+{
+	return m_primitiveBounds[slot];
+}
+
+const std::vector<BVH::Node>& BVH::Nodes() const
+{
+	return m_nodes;
+}
+
+uint32_t BVH::PrimitiveCount() const
+{
+	return static_cast<uint32_t>(m_primitives.size());
+}
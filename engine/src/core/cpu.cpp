@@ -0,0 +1,79 @@
+#include "pch.h"
+#include "core/cpu.h"
+
+#if defined(SCORCH_SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace SC;
+
+namespace
+{
+	SimdLevel DetectSimdLevel()
+	{
+#if defined(SCORCH_SIMD_X86) && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		const bool sse2 = (info[3] & (1 << 26)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		if (!sse2)
+			return SimdLevel::SCALAR;
+
+		//AVX registers also need to be enabled by the OS
+		if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6)
+		{
+			__cpuidex(info, 7, 0);
+			if (info[1] & (1 << 5))
+				return SimdLevel::AVX2;
+		}
+		return SimdLevel::SSE;
+#elif defined(SCORCH_SIMD_X86)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			return SimdLevel::AVX2;
+		if (__builtin_cpu_supports("sse2"))
+			return SimdLevel::SSE;
+		return SimdLevel::SCALAR;
+#else
+		return SimdLevel::SCALAR;
+#endif
+	}
+
+	const SimdLevel gSupportedLevel = DetectSimdLevel();
+	SimdLevel gActiveLevel = gSupportedLevel;
+}
+
+const char* SC::SimdLevelToString(SimdLevel level)
+{
+	switch (level)
+	{
+	case SimdLevel::SCALAR:
+		return "Scalar";
+	case SimdLevel::SSE:
+		return "SSE";
+	case SimdLevel::AVX2:
+		return "AVX2";
+	default:
+		CORE_ASSERT(false, "Unknown simd level");
+		return "Unknown";
+	}
+}
+
+SimdLevel Cpu::SupportedSimdLevel()
+{
+	return gSupportedLevel;
+}
+
+SimdLevel Cpu::ActiveSimdLevel()
+{
+	return gActiveLevel;
+}
+
+void Cpu::SetActiveSimdLevel(SimdLevel level)
+{
+	gActiveLevel = std::min(level, gSupportedLevel);
+}
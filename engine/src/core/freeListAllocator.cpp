@@ -0,0 +1,94 @@
+#include "pch.h"
+#include "core/freeListAllocator.h"
+
+using namespace SC;
+
+FreeListAllocator::FreeListAllocator(uint32_t capacity) :
+	m_capacity(capacity),
+	m_used(0)
+{
+	Reset();
+}
+
+uint32_t FreeListAllocator::Allocate(uint32_t size)
+{
+	CORE_ASSERT(size > 0, "Can't allocate an empty range");
+
+	for (auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it)
+	{
+		if (it->second < size)
+			continue;
+
+		//Allocate from the front of the range and keep the rest free
+		const uint32_t offset = it->first;
+		const uint32_t remaining = it->second - size;
+		m_freeRanges.erase(it);
+		if (remaining > 0)
+			m_freeRanges.emplace(offset + size, remaining);
+
+		m_used += size;
+		return offset;
+	}
+
+	return INVALID_OFFSET;
+}
+
+void FreeListAllocator::Free(uint32_t offset, uint32_t size)
+{
+	CORE_ASSERT(size > 0 && offset + size <= m_capacity, "Range is outside of the allocator");
+	CORE_ASSERT(size <= m_used, "Freeing more than was allocated");
+
+	m_used -= size;
+
+	auto next = m_freeRanges.lower_bound(offset);
+	CORE_ASSERT(next == m_freeRanges.end() || offset + size <= next->first, "Range overlaps a free range, was it freed twice?");
+
+	//Merge with the free ranges either side
+	if (next != m_freeRanges.begin())
+	{
+		auto previous = std::prev(next);
+		CORE_ASSERT(previous->first + previous->second <= offset, "Range overlaps a free range, was it freed twice?");
+		if (previous->first + previous->second == offset)
+		{
+			offset = previous->first;
+			size += previous->second;
+			m_freeRanges.erase(previous);
+		}
+	}
+
+	if (next != m_freeRanges.end() && offset + size == next->first)
+	{
+		size += next->second;
+		m_freeRanges.erase(next);
+	}
+
+	m_freeRanges.emplace(offset, size);
+}
+
+void FreeListAllocator::Reset()
+{
+	m_freeRanges.clear();
+	if (m_capacity > 0)
+		m_freeRanges.emplace(0, m_capacity);
+	m_used = 0;
+}
+
+uint32_t FreeListAllocator::Capacity() const
+{
+	return m_capacity;
+}
+
+uint32_t FreeListAllocator::Used() const
+{
+	return m_used;
+}
+
+uint32_t FreeListAllocator::LargestFreeRange() const
+{
+	uint32_t largest = 0;
+	for (const auto& range : m_freeRanges)
+	{
+		largest = std::max(largest, range.second);
+	}
+	return largest;
+}
@@ -0,0 +1,235 @@
+#include "pch.h"
+#include "core/frustum.h"
+
+#ifdef SCORCH_SIMD_X86
+#include <immintrin.h>
+#endif
+
+using namespace SC;
+
+namespace
+{
+	//Corner of the box furthest along the plane normal, the box is outside if even this corner is behind the plane
+	bool OutsidePlane(const glm::vec4& plane, const AABB& bounds)
+	{
+		const float x = plane.x >= 0.0f ? bounds.max.x : bounds.min.x;
+		const float y = plane.y >= 0.0f ? bounds.max.y : bounds.min.y;
+		const float z = plane.z >= 0.0f ? bounds.max.z : bounds.min.z;
+		return plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f;
+	}
+
+	//Corner of the box furthest behind the plane normal, the box is completely in front of the plane if this corner is
+	bool InsidePlane(const glm::vec4& plane, const AABB& bounds)
+	{
+		const float x = plane.x >= 0.0f ? bounds.min.x : bounds.max.x;
+		const float y = plane.y >= 0.0f ? bounds.min.y : bounds.max.y;
+		const float z = plane.z >= 0.0f ? bounds.min.z : bounds.max.z;
+		return plane.x * x + plane.y * y + plane.z * z + plane.w >= 0.0f;
+	}
+
+	bool IntersectsScalar(const std::array<glm::vec4, Frustum::PLANE_COUNT>& planes, const AABBArray& bounds, uint32_t i)
+	{
+		const AABB box(glm::vec3(bounds.minX[i], bounds.minY[i], bounds.minZ[i]), glm::vec3(bounds.maxX[i], bounds.maxY[i], bounds.maxZ[i]));
+		if (box.IsEmpty())
+			return false;
+
+		for (const glm::vec4& plane : planes)
+		{
+			if (OutsidePlane(plane, box))
+				return false;
+		}
+		return true;
+	}
+
+	uint32_t CullScalar(const std::array<glm::vec4, Frustum::PLANE_COUNT>& planes, const AABBArray& bounds, uint32_t* visibleIndices, uint32_t begin)
+	{
+		uint32_t visibleCount = 0;
+		for (uint32_t i = begin; i < bounds.Size(); ++i)
+		{
+			visibleIndices[visibleCount] = i;
+			visibleCount += IntersectsScalar(planes, bounds, i);
+		}
+		return visibleCount;
+	}
+
+	//Appends base + bit for each set bit of the mask without branching
+	uint32_t CompactMask(uint32_t mask, uint32_t bitCount, uint32_t base, uint32_t* visibleIndices)
+	{
+		uint32_t visibleCount = 0;
+		for (uint32_t bit = 0; bit < bitCount; ++bit)
+		{
+			visibleIndices[visibleCount] = base + bit;
+			visibleCount += (mask >> bit) & 1;
+		}
+		return visibleCount;
+	}
+
+#ifdef SCORCH_SIMD_X86
+	//The plane is the same for every lane so picking the corner is a choice between the min and max registers
+	SCORCH_TARGET_SSE uint32_t CullSSE(const std::array<glm::vec4, Frustum::PLANE_COUNT>& planes, const AABBArray& bounds, uint32_t* visibleIndices)
+	{
+		const uint32_t count = bounds.Size();
+		const __m128 zero = _mm_setzero_ps();
+
+		uint32_t visibleCount = 0;
+		uint32_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 minX = _mm_loadu_ps(&bounds.minX[i]);
+			const __m128 minY = _mm_loadu_ps(&bounds.minY[i]);
+			const __m128 minZ = _mm_loadu_ps(&bounds.minZ[i]);
+			const __m128 maxX = _mm_loadu_ps(&bounds.maxX[i]);
+			const __m128 maxY = _mm_loadu_ps(&bounds.maxY[i]);
+			const __m128 maxZ = _mm_loadu_ps(&bounds.maxZ[i]);
+
+			//Empty and inverted boxes are outside whatever the planes are
+			__m128 outside = _mm_or_ps(_mm_cmpgt_ps(minX, maxX), _mm_or_ps(_mm_cmpgt_ps(minY, maxY), _mm_cmpgt_ps(minZ, maxZ)));
+			for (const glm::vec4& plane : planes)
+			{
+				const __m128 x = plane.x >= 0.0f ? maxX : minX;
+				const __m128 y = plane.y >= 0.0f ? maxY : minY;
+				const __m128 z = plane.z >= 0.0f ? maxZ : minZ;
+
+				__m128 distance = _mm_mul_ps(_mm_set1_ps(plane.x), x);
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.y), y));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.z), z));
+				distance = _mm_add_ps(distance, _mm_set1_ps(plane.w));
+
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, zero));
+			}
+
+			const uint32_t visibleMask = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xF;
+			visibleCount += CompactMask(visibleMask, 4, i, visibleIndices + visibleCount);
+		}
+
+		return visibleCount + CullScalar(planes, bounds, visibleIndices + visibleCount, i);
+	}
+
+	SCORCH_TARGET_AVX2 uint32_t CullAVX2(const std::array<glm::vec4, Frustum::PLANE_COUNT>& planes, const AABBArray& bounds, uint32_t* visibleIndices)
+	{
+		const uint32_t count = bounds.Size();
+		const __m256 zero = _mm256_setzero_ps();
+
+		uint32_t visibleCount = 0;
+		uint32_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256 minX = _mm256_loadu_ps(&bounds.minX[i]);
+			const __m256 minY = _mm256_loadu_ps(&bounds.minY[i]);
+			const __m256 minZ = _mm256_loadu_ps(&bounds.minZ[i]);
+			const __m256 maxX = _mm256_loadu_ps(&bounds.maxX[i]);
+			const __m256 maxY = _mm256_loadu_ps(&bounds.maxY[i]);
+			const __m256 maxZ = _mm256_loadu_ps(&bounds.maxZ[i]);
+
+			__m256 outside = _mm256_or_ps(_mm256_cmp_ps(minX, maxX, _CMP_GT_OQ),
+				_mm256_or_ps(_mm256_cmp_ps(minY, maxY, _CMP_GT_OQ), _mm256_cmp_ps(minZ, maxZ, _CMP_GT_OQ)));
+			for (const glm::vec4& plane : planes)
+			{
+				const __m256 x = plane.x >= 0.0f ? maxX : minX;
+				const __m256 y = plane.y >= 0.0f ? maxY : minY;
+				const __m256 z = plane.z >= 0.0f ? maxZ : minZ;
+
+				__m256 distance = _mm256_mul_ps(_mm256_set1_ps(plane.x), x);
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.y), y));
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.z), z));
+				distance = _mm256_add_ps(distance, _mm256_set1_ps(plane.w));
+
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, zero, _CMP_LT_OQ));
+			}
+
+			const uint32_t visibleMask = ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xFF;
+			visibleCount += CompactMask(visibleMask, 8, i, visibleIndices + visibleCount);
+		}
+
+		return visibleCount + CullScalar(planes, bounds, visibleIndices + visibleCount, i);
+	}
+#endif
+}
+
+Frustum::Frustum()
+{
+	m_planes.fill(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+	//Gribb/Hartmann, each plane is the last row of the matrix plus or minus one of the other rows
+	const glm::vec4 rows[4] =
+	{
+		glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]),
+		glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]),
+		glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]),
+		glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]),
+	};
+
+	m_planes[0] = rows[3] + rows[0];
+	m_planes[1] = rows[3] - rows[0];
+	m_planes[2] = rows[3] + rows[1];
+	m_planes[3] = rows[3] - rows[1];
+	m_planes[4] = rows[3] + rows[2]; //-1 to 1 depth, for 0 to 1 depth this near plane is slightly behind the real one which is still conservative
+	m_planes[5] = rows[3] - rows[2];
+
+	for (glm::vec4& plane : m_planes)
+	{
+		const float length = glm::length(glm::vec3(plane));
+		if (length > 0.0f)
+			plane /= length;
+	}
+}
+
+const glm::vec4& Frustum::Plane(uint32_t index) const
+{
+	CORE_ASSERT(index < PLANE_COUNT, "Plane index out of range");
+	return m_planes[index];
+}
+
+bool Frustum::Intersects(const AABB& bounds) const
+{
+	if (bounds.IsEmpty())
+		return false;
+
+	for (const glm::vec4& plane : m_planes)
+	{
+		if (OutsidePlane(plane, bounds))
+			return false;
+	}
+	return true;
+}
+
+FrustumTest Frustum::Classify(const AABB& bounds) const
+{
+	if (bounds.IsEmpty())
+		return FrustumTest::OUTSIDE;
+
+	FrustumTest result = FrustumTest::INSIDE;
+	for (const glm::vec4& plane : m_planes)
+	{
+		if (OutsidePlane(plane, bounds))
+			return FrustumTest::OUTSIDE;
+		if (result == FrustumTest::INSIDE && !InsidePlane(plane, bounds))
+			result = FrustumTest::INTERSECTS;
+	}
+	return result;
+}
+
+uint32_t Frustum::Cull(const AABBArray& bounds, uint32_t* visibleIndices) const
+{
+	return Cull(bounds, visibleIndices, Cpu::ActiveSimdLevel());
+}
+
+uint32_t Frustum::Cull(const AABBArray& bounds, uint32_t* visibleIndices, SimdLevel level) const
+{
+	CORE_ASSERT(level <= Cpu::SupportedSimdLevel(), "Simd level is not supported on this cpu");
+
+	switch (level)
+	{
+#ifdef SCORCH_SIMD_X86
+	case SimdLevel::AVX2:
+		return CullAVX2(m_planes, bounds, visibleIndices);
+	case SimdLevel::SSE:
+		return CullSSE(m_planes, bounds, visibleIndices);
+#endif
+	default:
+		return CullScalar(m_planes, bounds, visibleIndices, 0);
+	}
+}
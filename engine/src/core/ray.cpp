@@ -0,0 +1,51 @@
+#include "pch.h"
+#include "core/ray.h"
+
+using namespace SC;
+
+Ray Ray::Transformed(const glm::mat4& transform) const
+{
+	return Ray(glm::vec3(transform * glm::vec4(origin, 1.0f)), glm::vec3(transform * glm::vec4(direction, 0.0f)));
+}
+
+Ray Ray::FromScreenPoint(float x, float y, float width, float height, const glm::mat4& viewProjection)
+{
+	const float ndcX = 2.0f * x / width - 1.0f;
+	const float ndcY = 2.0f * y / height - 1.0f;
+
+	const glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+	//-1 is the near plane with -1 to 1 depth and just in front of the eye with 0 to 1 depth, either way a point on the ray
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+	nearPoint /= nearPoint.w;
+	farPoint /= farPoint.w;
+
+	return Ray(glm::vec3(nearPoint), glm::normalize(glm::vec3(farPoint) - glm::vec3(nearPoint)));
+}
+
+bool SC::IntersectRayTriangle(const Ray& ray, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& distance, glm::vec2& barycentric)
+{
+	constexpr float EPSILON = 1e-8f;
+
+	const glm::vec3 edge1 = v1 - v0;
+	const glm::vec3 edge2 = v2 - v0;
+	const glm::vec3 p = glm::cross(ray.direction, edge2);
+	const float determinant = glm::dot(edge1, p);
+	if (std::abs(determinant) < EPSILON) return false; //Parallel to the triangle
+
+	const float inverseDeterminant = 1.0f / determinant;
+	const glm::vec3 s = ray.origin - v0;
+	const float u = glm::dot(s, p) * inverseDeterminant;
+	if (u < 0.0f || u > 1.0f) return false;
+
+	const glm::vec3 q = glm::cross(s, edge1);
+	const float v = glm::dot(ray.direction, q) * inverseDeterminant;
+	if (v < 0.0f || u + v > 1.0f) return false;
+
+	const float t = glm::dot(edge2, q) * inverseDeterminant;
+	if (t < 0.0f) return false;
+
+	distance = t;
+	barycentric = glm::vec2(u, v);
+	return true;
+}
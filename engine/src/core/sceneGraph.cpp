@@ -1,144 +1,627 @@
 #include "pch.h"
 #include "core/sceneGraph.h"
+#include "core/threadPool.h"
+#include "core/transformKernels.h"
 
 using namespace SC;
 
-Transform::Transform() : position(0), scale(1), rotation(glm::vec3(0))
+namespace
 {
+	//Updates smaller than this are not worth splitting across threads
+	constexpr uint32_t PARALLEL_UPDATE_MIN_MATRICES = 4096;
+	constexpr uint32_t PARALLEL_UPDATE_MIN_JOB_SIZE = 512;
 
+	static_assert(TransformHierarchy::INVALID_NODE == TransformKernels::INVALID_PARENT, "Root parents are passed straight to the kernels");
 }
 
-void Transform::Translate(const glm::vec3& t)
+TransformHierarchy::TransformHierarchy() :
+	m_updatedMatrixCount(0),
+	m_structureVersion(0),
+	m_updateVersion(0),
+	m_orderDirty(false)
 {
-	position += t;
+
 }
 
-void Transform::SetPosition(const glm::vec3& p)
+TransformHierarchy::NodeId TransformHierarchy::Add(SceneNode* node, NodeId parent)
 {
-	position = p;
+	CORE_ASSERT(node, "Node can't be null");
+
+	NodeId id;
+	if (!m_freeIds.empty())
+	{
+		id = m_freeIds.back();
+		m_freeIds.pop_back();
+	}
+	else
+	{
+		id = static_cast<NodeId>(m_nodes.size());
+		m_nodes.push_back(nullptr);
+		m_idToIndex.push_back(INVALID_NODE);
+		m_dirtyFlags.push_back(false);
+	}
+
+	//New nodes are appended so the parent is still before the child, but the parents subtree is no longer contiguous
+	const uint32_t index = static_cast<uint32_t>(m_indexToId.size());
+	m_nodes[id] = node;
+	m_idToIndex[id] = index;
+
+	m_indexToId.push_back(id);
+	m_parents.push_back(parent == INVALID_NODE ? INVALID_NODE : Index(parent));
+	m_subtreeEnds.push_back(index + 1);
+	m_positions.emplace_back(0.0f);
+	m_rotations.emplace_back(1.0f, 0.0f, 0.0f, 0.0f);
+	m_scales.emplace_back(1.0f);
+	m_localMatrices.emplace_back(1.0f);
+	m_worldMatrices.emplace_back(1.0f);
+	m_localBounds.emplace_back();
+	m_subtreeBounds.emplace_back();
+
+	if (parent != INVALID_NODE)
+		m_orderDirty = true;
+	++m_structureVersion;
+
+	MarkDirty(id);
+
+	return id;
 }
 
-const glm::vec3& Transform::GetPosition() const
+void TransformHierarchy::Remove(NodeId id)
 {
-	return position;
+	CORE_ASSERT(id < m_nodes.size() && m_nodes[id], "Node id is invalid");
+	if (id >= m_nodes.size() || !m_nodes[id]) return;
+
+	//The parent's subtree bounds shrink without the node
+	const uint32_t parent = m_parents[Index(id)];
+	if (parent != INVALID_NODE)
+		m_boundsDirtyNodes.push_back(m_indexToId[parent]);
+
+	//The removed node's data is left in place until the order is rebuilt
+	//its id may still be in the dirty list, Update skips ids that are no longer valid
+	m_nodes[id] = nullptr;
+	m_idToIndex[id] = INVALID_NODE;
+	m_freeIds.push_back(id);
+	m_orderDirty = true;
+	++m_structureVersion;
 }
 
-void Transform::SetScale(const glm::vec3& s)
+void TransformHierarchy::SetParent(NodeId id, NodeId parent)
 {
-	scale = s;
+	const uint32_t oldParent = m_parents[Index(id)];
+	if (oldParent != INVALID_NODE)
+		m_boundsDirtyNodes.push_back(m_indexToId[oldParent]);
+
+	m_parents[Index(id)] = parent == INVALID_NODE ? INVALID_NODE : Index(parent);
+	m_orderDirty = true;
+	++m_structureVersion;
+
+	MarkDirty(id);
 }
 
-const glm::vec3& Transform::GetScale() const
+void TransformHierarchy::SetPosition(NodeId id, const glm::vec3& position)
 {
-	return scale;
+	m_positions[Index(id)] = position;
+	MarkDirty(id);
 }
 
-void Transform::Rotate(const glm::vec3& axis, float radians)
+const glm::vec3& TransformHierarchy::Position(NodeId id) const
 {
-	rotation = glm::angleAxis(radians, axis) * rotation;
+	return m_positions[Index(id)];
+}
 
+void TransformHierarchy::SetRotation(NodeId id, const glm::quat& rotation)
+{
+	m_rotations[Index(id)] = rotation;
+	MarkDirty(id);
 }
 
-void Transform::SetRotation(const glm::vec3& axis, float radians)
+const glm::quat& TransformHierarchy::Rotation(NodeId id) const
 {
-	rotation = glm::angleAxis(radians, axis);
+	return m_rotations[Index(id)];
 }
 
-const glm::quat& Transform::GetRotation() const
+void TransformHierarchy::SetScale(NodeId id, const glm::vec3& scale)
 {
-	return rotation;
+	m_scales[Index(id)] = scale;
+	MarkDirty(id);
 }
 
-glm::mat4 Transform::ModelMatrix() const
+const glm::vec3& TransformHierarchy::Scale(NodeId id) const
+{
+	return m_scales[Index(id)];
+}
+
+void TransformHierarchy::MarkDirty(NodeId id)
 {
-	glm::mat4 transform(1.0f);
-	transform = glm::translate(transform, position);
-	transform *= glm::toMat4(rotation);
-	transform = glm::scale(transform, scale);
+	if (m_dirtyFlags[id]) return;
 
-	return std::move(transform);
+	m_dirtyFlags[id] = true;
+	m_dirtyNodes.push_back(id);
 }
 
+const glm::mat4& TransformHierarchy::LocalMatrix(NodeId id) const
+{
+	return m_localMatrices[Index(id)];
+}
 
-SceneNode::SceneNode() :
-	m_parent(nullptr)
+const glm::mat4& TransformHierarchy::WorldMatrix(NodeId id) const
 {
+	return m_worldMatrices[Index(id)];
+}
 
+void TransformHierarchy::SetLocalBounds(NodeId id, const AABB& bounds)
+{
+	m_localBounds[Index(id)] = bounds;
+	MarkDirty(id);
 }
 
-void SceneNode::Remove()
+const AABB& TransformHierarchy::LocalBounds(NodeId id) const
+{
+	return m_localBounds[Index(id)];
+}
+
+AABB TransformHierarchy::WorldBounds(NodeId id) const
+{
+	const uint32_t index = Index(id);
+	return m_localBounds[index].Transformed(m_worldMatrices[index]);
+}
+
+const AABB& TransformHierarchy::SubtreeBounds(NodeId id) const
+{
+	return m_subtreeBounds[Index(id)];
+}
+
+void TransformHierarchy::Update(NodeId root, ThreadPool* threadPool)
 {
-	m_children.clear();
+	m_updatedMatrixCount = 0;
+	m_updateRanges.clear();
 
-	//Make sure to remove ourself from the parent
-	if (m_parent)
+	if (m_orderDirty)
+		RebuildOrder();
+
+	if (m_dirtyNodes.empty() && m_boundsDirtyNodes.empty())
+		return;
+
+	++m_updateVersion;
+
+	uint32_t begin = 0;
+	uint32_t end = static_cast<uint32_t>(m_indexToId.size());
+	if (root != INVALID_NODE)
+	{
+		begin = Index(root);
+		end = m_subtreeEnds[begin];
+	}
+
+	//Collect the indices of the dirty nodes inside the range, anything outside stays dirty for a later update
+	m_dirtyScratch.clear();
+	size_t keptCount = 0;
+	for (NodeId id : m_dirtyNodes)
 	{
-		auto new_end = std::remove_if(m_parent->m_children.begin(), m_parent->m_children.end(),
-			[=](const auto& node)
-			{ 
-				return node.get() == this;
-			});
+		const uint32_t index = m_idToIndex[id];
+		if (index == INVALID_NODE)
+		{
+			m_dirtyFlags[id] = false; //Node has been removed
+			continue;
+		}
 
-		m_parent->m_children.erase(new_end, m_parent->m_children.end());
+		if (index >= begin && index < end)
+		{
+			m_dirtyScratch.push_back(index);
+			m_dirtyFlags[id] = false;
+		}
+		else
+			m_dirtyNodes[keptCount++] = id;
+	}
+	m_dirtyNodes.resize(keptCount);
+
+	//Sorted dirty indices let each subtree be swept once, dirty descendants of an already swept node are skipped
+	std::sort(m_dirtyScratch.begin(), m_dirtyScratch.end());
+
+	uint32_t matrixCount = 0;
+	uint32_t sweptEnd = 0;
+	for (uint32_t index : m_dirtyScratch)
+	{
+		if (index < sweptEnd) continue;
+
+		sweptEnd = m_subtreeEnds[index];
+		m_updateRanges.emplace_back(index, sweptEnd);
+		matrixCount += sweptEnd - index;
+	}
+
+	m_splitNodes.clear();
+	if (threadPool && threadPool->ThreadCount() > 1 && matrixCount >= PARALLEL_UPDATE_MIN_MATRICES)
+	{
+		UpdateParallel(*threadPool, matrixCount);
+	}
+	else
+	{
+		for (const auto& [begin, end] : m_updateRanges)
+		{
+			UpdateRange(begin, end);
+		}
 	}
+
+	UpdateAncestorBounds();
+
+	m_updatedMatrixCount = matrixCount;
 }
 
-SceneNode::~SceneNode()
+void TransformHierarchy::UpdateRange(uint32_t begin, uint32_t end)
 {
+	//Local matrices don't depend on each other so they are composed in batches first
+	TransformKernels::ComposeMatrices(&m_positions[begin], &m_rotations[begin], &m_scales[begin], &m_localMatrices[begin], end - begin);
+
+	//Parents are always stored before their children so the parent world matrix is already up to date
+	TransformKernels::MultiplyParents(m_parents.data(), m_localMatrices.data(), m_worldMatrices.data(), begin, end);
 
+	for (uint32_t i = begin; i < end; ++i)
+	{
+		m_subtreeBounds[i] = m_localBounds[i].Transformed(m_worldMatrices[i]);
+	}
+
+	//Walking backwards folds every subtree into its parent before the parent is folded into its own parent,
+	//parents before the range are left to UpdateAncestorBounds
+	for (uint32_t i = end; i-- > begin;)
+	{
+		const uint32_t parent = m_parents[i];
+		if (parent != INVALID_NODE && parent >= begin)
+			m_subtreeBounds[parent].Expand(m_subtreeBounds[i]);
+	}
 }
 
-void SceneNode::SetParent(SceneNode& parent)
+void TransformHierarchy::GatherSubtreeBounds(uint32_t index)
 {
-	SceneNode* oldParent = m_parent;
+	AABB bounds = m_localBounds[index].Transformed(m_worldMatrices[index]);
+	for (uint32_t child = index + 1; child < m_subtreeEnds[index]; child = m_subtreeEnds[child])
+	{
+		bounds.Expand(m_subtreeBounds[child]);
+	}
+	m_subtreeBounds[index] = bounds;
+}
 
-	m_parent = &parent;
+void TransformHierarchy::UpdateAncestorBounds()
+{
+	//Every node above an updated range encloses it, as do parallel split roots whose children were updated by other jobs
+	m_boundsVisited.resize(m_indexToId.size(), false);
+	m_boundsRefresh.clear();
 
-	//Make sure to move ourself to the new parent
-	if (oldParent)
+	const auto addWithAncestors = [this](uint32_t index)
 	{
-		auto self = std::find_if(oldParent->m_children.begin(), oldParent->m_children.end(),
-			[=](const auto& node)
-			{
-				return node.get() == this;
-			});
+		for (; index != INVALID_NODE && !m_boundsVisited[index]; index = m_parents[index])
+		{
+			m_boundsVisited[index] = true;
+			m_boundsRefresh.push_back(index);
+		}
+	};
+
+	for (const auto& [begin, end] : m_updateRanges)
+	{
+		addWithAncestors(m_parents[begin]);
+	}
+	for (uint32_t index : m_splitNodes)
+	{
+		addWithAncestors(index);
+	}
+	for (NodeId id : m_boundsDirtyNodes)
+	{
+		if (m_idToIndex[id] != INVALID_NODE)
+			addWithAncestors(m_idToIndex[id]);
+	}
+	m_boundsDirtyNodes.clear();
+
+	//Children are stored after their parent so refreshing from the back rebuilds each child before its parent reads it
+	std::sort(m_boundsRefresh.begin(), m_boundsRefresh.end(), std::greater<uint32_t>());
+	for (uint32_t index : m_boundsRefresh)
+	{
+		m_boundsVisited[index] = false;
+		GatherSubtreeBounds(index);
+	}
+}
+
+void TransformHierarchy::UpdateParallel(ThreadPool& threadPool, uint32_t matrixCount)
+{
+	//A few jobs per thread so uneven subtrees still balance out
+	const uint32_t jobSize = std::max(PARALLEL_UPDATE_MIN_JOB_SIZE, matrixCount / (threadPool.ThreadCount() * 4));
+
+	//The dirty ranges never overlap and the parent of each range root is clean, so the ranges are independent.
+	//Ranges that are too large are split into their child subtrees, the roots they are split at are computed first
+	m_jobRanges.clear();
+	m_splitNodes.clear();
+	for (const auto& [begin, end] : m_updateRanges)
+	{
+		SplitRange(begin, end, jobSize);
+	}
+
+	//Split roots are stored parent first so computing them in order keeps parents ahead of children
+	for (uint32_t index : m_splitNodes)
+	{
+		UpdateRange(index, index + 1);
+	}
+
+	threadPool.ParallelFor(static_cast<uint32_t>(m_jobRanges.size()), [this](uint32_t job)
+		{
+			UpdateRange(m_jobRanges[job].first, m_jobRanges[job].second);
+		});
+}
+
+void TransformHierarchy::SplitRange(uint32_t begin, uint32_t end, uint32_t jobSize)
+{
+	//Iterative depth first split so deep hierarchies don't overflow the stack, children are pushed in reverse to keep them in order
+	m_splitStack.clear();
+	m_splitStack.emplace_back(begin, end);
+	while (!m_splitStack.empty())
+	{
+		const auto [rangeBegin, rangeEnd] = m_splitStack.back();
+		m_splitStack.pop_back();
 
-		if (self != oldParent->m_children.end())
+		if (rangeEnd - rangeBegin <= jobSize)
 		{
-			m_parent->m_children.push_back(*self);
+			//Neighbouring small subtrees are merged into one job, they don't depend on each other
+			if (!m_jobRanges.empty() && m_jobRanges.back().second == rangeBegin && rangeEnd - m_jobRanges.back().first <= jobSize)
+				m_jobRanges.back().second = rangeEnd;
+			else
+				m_jobRanges.emplace_back(rangeBegin, rangeEnd);
+			continue;
 		}
 
-		oldParent->m_children.erase(self, oldParent->m_children.end());
+		m_splitNodes.push_back(rangeBegin);
+
+		const size_t firstChild = m_splitStack.size();
+		for (uint32_t child = rangeBegin + 1; child < rangeEnd; child = m_subtreeEnds[child])
+		{
+			m_splitStack.emplace_back(child, m_subtreeEnds[child]);
+		}
+		std::reverse(m_splitStack.begin() + firstChild, m_splitStack.end());
 	}
+}
 
+uint32_t TransformHierarchy::NodeCount() const
+{
+	return static_cast<uint32_t>(m_nodes.size() - m_freeIds.size());
 }
 
-RenderObject& SceneNode::GetRenderObject()
+uint32_t TransformHierarchy::UpdatedMatrixCount() const
 {
-	return m_renderObject;
+	return m_updatedMatrixCount;
 }
 
-void SceneNode::TraverseTree(std::function<void(SceneNode& node)> func)
+const std::vector<std::pair<uint32_t, uint32_t>>& TransformHierarchy::UpdatedRanges() const
 {
-	std::stack<SceneNode*> stack;
-	stack.push(this);
+	return m_updateRanges;
+}
 
-	while (!stack.empty()) 
+TransformHierarchy::NodeId TransformHierarchy::IdAt(uint32_t index) const
+{
+	return m_indexToId[index];
+}
+
+uint32_t TransformHierarchy::StructureVersion() const
+{
+	return m_structureVersion;
+}
+
+uint32_t TransformHierarchy::UpdateVersion() const
+{
+	return m_updateVersion;
+}
+
+uint32_t TransformHierarchy::Index(NodeId id) const
+{
+	CORE_ASSERT(id < m_idToIndex.size() && m_idToIndex[id] != INVALID_NODE, "Node id is invalid");
+	return m_idToIndex[id];
+}
+
+void TransformHierarchy::RebuildOrder()
+{
+	const size_t nodeCount = NodeCount();
+
+	//Depth first walk from every root to find the new order, children are reversed on the stack so they keep their insertion order
+	m_rebuildOrder.clear();
+	m_rebuildParents.clear();
+	m_rebuildStack.clear();
+	for (SceneNode* node : m_nodes)
 	{
-		SceneNode* currentNode = stack.top();
-		stack.pop();
+		if (!node || node->m_parent != PoolHandle::INVALID_INDEX) continue;
 
-		// push all children onto the stack:
-		for (std::list<std::shared_ptr<SceneNode>>::iterator i = currentNode->m_children.begin();
-			i != currentNode->m_children.end();
-			i++)
+		m_rebuildStack.emplace_back(node, INVALID_NODE);
+		while (!m_rebuildStack.empty())
 		{
-			stack.push(i->get());
+			auto [current, parentIndex] = m_rebuildStack.back();
+			m_rebuildStack.pop_back();
+
+			const uint32_t newIndex = static_cast<uint32_t>(m_rebuildOrder.size());
+			m_rebuildOrder.push_back(m_idToIndex[current->m_id]);
+			m_rebuildParents.push_back(parentIndex);
+
+			const size_t firstChild = m_rebuildStack.size();
+			for (SceneNode* child = current->FirstChild(); child; child = child->NextSibling())
+			{
+				m_rebuildStack.emplace_back(child, newIndex);
+			}
+			std::reverse(m_rebuildStack.begin() + firstChild, m_rebuildStack.end());
 		}
+	}
+
+	CORE_ASSERT(m_rebuildOrder.size() == nodeCount, "Hierarchy contains nodes that are not reachable from a root");
 
-		// do any processing for this node here
-		func(*currentNode);
+	//Removed nodes go after the live ones so the order is a full permutation that can be applied in place
+	m_rebuildVisited.assign(m_indexToId.size(), false);
+	for (uint32_t oldIndex : m_rebuildOrder)
+	{
+		m_rebuildVisited[oldIndex] = true;
+	}
+	for (uint32_t oldIndex = 0; oldIndex < m_indexToId.size(); ++oldIndex)
+	{
+		if (!m_rebuildVisited[oldIndex])
+			m_rebuildOrder.push_back(oldIndex);
 	}
+
+	//Reordering in place keeps the capacity of the arrays, so clearing and refilling a scene doesn't reallocate them
+	ApplyOrder(m_indexToId, nodeCount);
+	ApplyOrder(m_positions, nodeCount);
+	ApplyOrder(m_rotations, nodeCount);
+	ApplyOrder(m_scales, nodeCount);
+	ApplyOrder(m_localMatrices, nodeCount);
+	ApplyOrder(m_worldMatrices, nodeCount);
+	ApplyOrder(m_localBounds, nodeCount);
+	ApplyOrder(m_subtreeBounds, nodeCount);
+	m_parents.swap(m_rebuildParents);
+
+	for (uint32_t i = 0; i < m_indexToId.size(); ++i)
+	{
+		m_idToIndex[m_indexToId[i]] = i;
+	}
+
+	//Children are after their parent so walking backwards gives each parent the end of its subtree
+	m_subtreeEnds.resize(m_indexToId.size());
+	for (uint32_t i = 0; i < m_subtreeEnds.size(); ++i)
+	{
+		m_subtreeEnds[i] = i + 1;
+	}
+	for (size_t i = m_subtreeEnds.size(); i-- > 0;)
+	{
+		const uint32_t parent = m_parents[i];
+		if (parent != INVALID_NODE)
+			m_subtreeEnds[parent] = std::max(m_subtreeEnds[parent], m_subtreeEnds[i]);
+	}
+
+	m_orderDirty = false;
+}
+
+template<typename T>
+void TransformHierarchy::ApplyOrder(std::vector<T>& values, size_t newSize)
+{
+	//values[i] = old values[m_rebuildOrder[i]], each cycle of the permutation is rotated once
+	m_rebuildVisited.assign(values.size(), false);
+	for (size_t start = 0; start < values.size(); ++start)
+	{
+		if (m_rebuildVisited[start]) continue;
+
+		T first = std::move(values[start]);
+		size_t current = start;
+		while (true)
+		{
+			m_rebuildVisited[current] = true;
+
+			const size_t next = m_rebuildOrder[current];
+			if (next == start)
+			{
+				values[current] = std::move(first);
+				break;
+			}
+
+			values[current] = std::move(values[next]);
+			current = next;
+		}
+	}
+
+	values.resize(newSize);
+}
+
+Transform::Transform(TransformHierarchy* hierarchy, TransformHierarchy::NodeId id) :
+	m_hierarchy(hierarchy),
+	m_id(id)
+{
+
+}
+
+void Transform::Translate(const glm::vec3& t)
+{
+	m_hierarchy->SetPosition(m_id, m_hierarchy->Position(m_id) + t);
+}
+
+void Transform::SetPosition(const glm::vec3& p)
+{
+	m_hierarchy->SetPosition(m_id, p);
+}
+
+const glm::vec3& Transform::GetPosition() const
+{
+	return m_hierarchy->Position(m_id);
+}
+
+void Transform::SetScale(const glm::vec3& s)
+{
+	m_hierarchy->SetScale(m_id, s);
+}
+
+const glm::vec3& Transform::GetScale() const
+{
+	return m_hierarchy->Scale(m_id);
+}
+
+void Transform::Rotate(const glm::vec3& axis, float radians)
+{
+	m_hierarchy->SetRotation(m_id, glm::angleAxis(radians, axis) * m_hierarchy->Rotation(m_id));
+
+}
+
+void Transform::SetRotation(const glm::vec3& axis, float radians)
+{
+	m_hierarchy->SetRotation(m_id, glm::angleAxis(radians, axis));
+}
+
+const glm::quat& Transform::GetRotation() const
+{
+	return m_hierarchy->Rotation(m_id);
+}
+
+glm::mat4 Transform::ModelMatrix() const
+{
+	glm::mat4 matrix;
+	TransformKernels::ComposeMatrices(&m_hierarchy->Position(m_id), &m_hierarchy->Rotation(m_id), &m_hierarchy->Scale(m_id), &matrix, 1);
+	return matrix;
+}
+
+
+SceneNode::SceneNode(SceneNodeHandle handle, SceneGraph* graph, SceneNode* parent) :
+	m_graph(graph),
+	m_handle(handle),
+	m_id(graph->m_hierarchy.Add(this, parent ? parent->m_id : TransformHierarchy::INVALID_NODE)),
+	m_parent(PoolHandle::INVALID_INDEX),
+	m_firstChild(PoolHandle::INVALID_INDEX),
+	m_lastChild(PoolHandle::INVALID_INDEX),
+	m_nextSibling(PoolHandle::INVALID_INDEX),
+	m_prevSibling(PoolHandle::INVALID_INDEX),
+	m_transform(&graph->m_hierarchy, m_id)
+{
+
+}
+
+SceneNode::~SceneNode()
+{
+	//Links are handled by the SceneGraph, which may destroy nodes in any order
+	m_graph->m_hierarchy.Remove(m_id);
+}
+
+SceneNode& SceneNode::AddChild()
+{
+	return m_graph->CreateNode(this);
+}
+
+void SceneNode::Remove()
+{
+	m_graph->RemoveNode(*this);
+}
+
+void SceneNode::SetParent(SceneNode& parent)
+{
+	m_graph->SetParent(*this, parent);
+}
+
+SceneNodeHandle SceneNode::Handle() const
+{
+	return m_handle;
+}
+
+TransformHierarchy::NodeId SceneNode::Id() const
+{
+	return m_id;
+}
+
+RenderObject& SceneNode::GetRenderObject()
+{
+	return m_renderObject;
 }
 
 Transform& SceneNode::GetTransform()
@@ -146,26 +629,170 @@ Transform& SceneNode::GetTransform()
 	return m_transform;
 }
 
-const std::list<std::shared_ptr<SC::SceneNode>>& SceneNode::Children() const
+void SceneNode::UpdateSelfAndChildren(ThreadPool* threadPool)
+{
+	m_graph->m_hierarchy.Update(m_id, threadPool);
+}
+
+const glm::mat4& SceneNode::ModelMatrix() const
 {
-	return m_children;
+	return m_graph->m_hierarchy.WorldMatrix(m_id);
 }
 
-void SceneNode::UpdateSelfAndChildren()
+void SceneNode::SetLocalBounds(const AABB& bounds)
 {
-	if (m_parent)
-		modelMatrix = m_parent->modelMatrix * m_transform.ModelMatrix();
-	else
-		modelMatrix = m_transform.ModelMatrix();
+	m_graph->m_hierarchy.SetLocalBounds(m_id, bounds);
+}
+
+AABB SceneNode::WorldBounds() const
+{
+	return m_graph->m_hierarchy.WorldBounds(m_id);
+}
+
+const AABB& SceneNode::SubtreeBounds() const
+{
+	return m_graph->m_hierarchy.SubtreeBounds(m_id);
+}
+
+const TransformHierarchy& SceneNode::Hierarchy() const
+{
+	return m_graph->m_hierarchy;
+}
+
+
+SceneGraph::SceneGraph() :
+	m_root(m_nodes.Allocate(this, nullptr))
+{
+
+}
 
-	for (auto& child : m_children)
+SceneGraph::~SceneGraph()
+{
+	//Free the nodes while the hierarchy is still alive
+	m_nodes.Clear();
+}
+
+SceneNode& SceneGraph::Root()
+{
+	return m_nodes.At(m_root.index);
+}
+
+const SceneNode& SceneGraph::Root() const
+{
+	return m_nodes.At(m_root.index);
+}
+
+SceneNode* SceneGraph::Get(SceneNodeHandle handle)
+{
+	return m_nodes.Get(handle);
+}
+
+const TransformHierarchy& SceneGraph::Hierarchy() const
+{
+	return m_hierarchy;
+}
+
+uint32_t SceneGraph::NodeCount() const
+{
+	return m_nodes.Size();
+}
+
+SceneNode& SceneGraph::CreateNode(SceneNode* parent)
+{
+	const SceneNodeHandle handle = m_nodes.Allocate(this, parent);
+	SceneNode& node = m_nodes.At(handle.index);
+
+	if (parent)
+		Link(node, *parent);
+
+	return node;
+}
+
+void SceneGraph::RemoveNode(SceneNode& node)
+{
+	CORE_ASSERT(node.m_graph == this, "Node belongs to a different graph");
+
+	//Gather every descendant breadth first, the links are no longer needed once the whole subtree is going
+	m_removeScratch.clear();
+	for (SceneNode* child = node.FirstChild(); child; child = child->NextSibling())
+	{
+		m_removeScratch.push_back(child->m_handle.index);
+	}
+	for (size_t i = 0; i < m_removeScratch.size(); ++i)
 	{
-		child->UpdateSelfAndChildren();
+		for (SceneNode* child = NodeAt(m_removeScratch[i])->FirstChild(); child; child = child->NextSibling())
+		{
+			m_removeScratch.push_back(child->m_handle.index);
+		}
+	}
+
+	for (uint32_t index : m_removeScratch)
+	{
+		m_nodes.Free(NodeAt(index)->m_handle);
+	}
+
+	node.m_firstChild = PoolHandle::INVALID_INDEX;
+	node.m_lastChild = PoolHandle::INVALID_INDEX;
+
+	if (node.m_handle != m_root)
+	{
+		Unlink(node);
+		m_nodes.Free(node.m_handle);
 	}
 }
 
-const glm::mat4& SceneNode::ModelMatrix() const
+void SceneGraph::SetParent(SceneNode& node, SceneNode& parent)
 {
-	return modelMatrix;
+	CORE_ASSERT(node.m_handle != m_root, "Root node can't be re-parented");
+	CORE_ASSERT(parent.m_graph == this, "Nodes must belong to the same graph");
+	if (node.m_handle == m_root || parent.m_graph != this) return;
+
+	//Parenting a node to one of its own descendants would detach the subtree from the root
+	for (SceneNode* ancestor = &parent; ancestor; ancestor = ancestor->Parent())
+	{
+		CORE_ASSERT(ancestor != &node, "Node can't be parented to its own descendant");
+		if (ancestor == &node) return;
+	}
+
+	Unlink(node);
+	Link(node, parent);
+
+	m_hierarchy.SetParent(node.m_id, parent.m_id);
+}
+
+void SceneGraph::Link(SceneNode& node, SceneNode& parent)
+{
+	const uint32_t index = node.m_handle.index;
+
+	node.m_parent = parent.m_handle.index;
+	node.m_prevSibling = parent.m_lastChild;
+	node.m_nextSibling = PoolHandle::INVALID_INDEX;
+
+	if (parent.m_lastChild != PoolHandle::INVALID_INDEX)
+		NodeAt(parent.m_lastChild)->m_nextSibling = index;
+	else
+		parent.m_firstChild = index;
+
+	parent.m_lastChild = index;
 }
 
+void SceneGraph::Unlink(SceneNode& node)
+{
+	SceneNode* parent = node.Parent();
+	CORE_ASSERT(parent, "Node has no parent to unlink from");
+	if (!parent) return;
+
+	if (node.m_prevSibling != PoolHandle::INVALID_INDEX)
+		NodeAt(node.m_prevSibling)->m_nextSibling = node.m_nextSibling;
+	else
+		parent->m_firstChild = node.m_nextSibling;
+
+	if (node.m_nextSibling != PoolHandle::INVALID_INDEX)
+		NodeAt(node.m_nextSibling)->m_prevSibling = node.m_prevSibling;
+	else
+		parent->m_lastChild = node.m_prevSibling;
+
+	node.m_parent = PoolHandle::INVALID_INDEX;
+	node.m_nextSibling = PoolHandle::INVALID_INDEX;
+	node.m_prevSibling = PoolHandle::INVALID_INDEX;
+}
@@ -0,0 +1,110 @@
+#include "pch.h"
+#include "core/threadPool.h"
+
+using namespace SC;
+
+ThreadPool::ThreadPool(uint32_t workerCount) :
+	m_job(nullptr),
+	m_jobCount(0),
+	m_nextIndex(0),
+	m_activeWorkers(0),
+	m_generation(0),
+	m_stopping(false)
+{
+	m_workers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; ++i)
+	{
+		m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_jobAvailable.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+uint32_t ThreadPool::ThreadCount() const
+{
+	return static_cast<uint32_t>(m_workers.size()) + 1;
+}
+
+void ThreadPool::ParallelFor(uint32_t count, FunctionRef<void(uint32_t index)> func)
+{
+	if (count == 0) return;
+
+	//Not worth waking the workers
+	if (m_workers.empty() || count == 1)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			func(i);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_job = &func;
+		m_jobCount = count;
+		m_nextIndex = 0;
+		++m_generation;
+	}
+	m_jobAvailable.notify_all();
+
+	RunJobs(func, count);
+
+	//All indices are taken, wait for the workers that are still running one
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_jobsFinished.wait(lock, [this] { return m_activeWorkers == 0; });
+	m_job = nullptr;
+}
+
+uint32_t ThreadPool::DefaultWorkerCount()
+{
+	const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+	return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+void ThreadPool::WorkerLoop()
+{
+	uint64_t generation = 0;
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_jobAvailable.wait(lock, [&] { return m_stopping || m_generation != generation; });
+		if (m_stopping) return;
+
+		generation = m_generation;
+
+		//Woke up after the job already finished
+		if (!m_job) continue;
+
+		const FunctionRef<void(uint32_t)> job = *m_job;
+		const uint32_t jobCount = m_jobCount;
+		++m_activeWorkers;
+		lock.unlock();
+
+		RunJobs(job, jobCount);
+
+		lock.lock();
+		if (--m_activeWorkers == 0)
+			m_jobsFinished.notify_all();
+	}
+}
+
+void ThreadPool::RunJobs(FunctionRef<void(uint32_t)> func, uint32_t count)
+{
+	for (uint32_t index = m_nextIndex++; index < count; index = m_nextIndex++)
+	{
+		func(index);
+	}
+}
@@ -0,0 +1,334 @@
+#include "pch.h"
+#include "core/transformKernels.h"
+
+#ifdef SCORCH_SIMD_X86
+#include <immintrin.h>
+#endif
+
+using namespace SC;
+
+namespace
+{
+	//Same operation order as translate * toMat4 * scale in glm, the zero terms of the full matrix products are skipped
+	void ComposeScalar(const glm::vec3& p, const glm::quat& q, const glm::vec3& s, glm::mat4& m)
+	{
+		const float qxx = q.x * q.x;
+		const float qyy = q.y * q.y;
+		const float qzz = q.z * q.z;
+		const float qxz = q.x * q.z;
+		const float qxy = q.x * q.y;
+		const float qyz = q.y * q.z;
+		const float qwx = q.w * q.x;
+		const float qwy = q.w * q.y;
+		const float qwz = q.w * q.z;
+
+		m[0] = glm::vec4((1.0f - 2.0f * (qyy + qzz)) * s.x, (2.0f * (qxy + qwz)) * s.x, (2.0f * (qxz - qwy)) * s.x, 0.0f);
+		m[1] = glm::vec4((2.0f * (qxy - qwz)) * s.y, (1.0f - 2.0f * (qxx + qzz)) * s.y, (2.0f * (qyz + qwx)) * s.y, 0.0f);
+		m[2] = glm::vec4((2.0f * (qxz + qwy)) * s.z, (2.0f * (qyz - qwx)) * s.z, (1.0f - 2.0f * (qxx + qyy)) * s.z, 0.0f);
+		m[3] = glm::vec4(p, 1.0f);
+	}
+
+	void ComposeMatricesScalar(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* matrices, uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			ComposeScalar(positions[i], rotations[i], scales[i], matrices[i]);
+		}
+	}
+
+	void MultiplyParentsScalar(const uint32_t* parents, const glm::mat4* localMatrices, glm::mat4* worldMatrices, uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			const uint32_t parent = parents[i];
+			if (parent != TransformKernels::INVALID_PARENT)
+				worldMatrices[i] = worldMatrices[parent] * localMatrices[i];
+			else
+				worldMatrices[i] = localMatrices[i];
+		}
+	}
+
+#ifdef SCORCH_SIMD_X86
+	static_assert(sizeof(glm::vec3) == 3 * sizeof(float) && sizeof(glm::quat) == 4 * sizeof(float), "Kernels expect tightly packed glm types");
+
+	//Loads 4 packed vec3s and shuffles them into one register per component
+	SCORCH_TARGET_SSE void LoadVec3SSE(const glm::vec3* v, __m128& x, __m128& y, __m128& z)
+	{
+		const float* data = &v[0].x;
+		const __m128 a = _mm_loadu_ps(data);     //x0 y0 z0 x1
+		const __m128 b = _mm_loadu_ps(data + 4); //y1 z1 x2 y2
+		const __m128 c = _mm_loadu_ps(data + 8); //z2 x3 y3 z3
+
+		x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+		y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+		z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+	}
+
+	SCORCH_TARGET_SSE void LoadQuatSSE(const glm::quat* q, __m128& x, __m128& y, __m128& z, __m128& w)
+	{
+		const float* data = reinterpret_cast<const float*>(q);
+		__m128 q0 = _mm_loadu_ps(data);
+		__m128 q1 = _mm_loadu_ps(data + 4);
+		__m128 q2 = _mm_loadu_ps(data + 8);
+		__m128 q3 = _mm_loadu_ps(data + 12);
+		_MM_TRANSPOSE4_PS(q0, q1, q2, q3);
+
+#ifdef GLM_FORCE_QUAT_DATA_WXYZ
+		w = q0; x = q1; y = q2; z = q3;
+#else
+		x = q0; y = q1; z = q2; w = q3;
+#endif
+	}
+
+	//Lanes hold the same element of 4 different matrices, the transpose turns them into one column per matrix
+	SCORCH_TARGET_SSE void StoreColumnsSSE(__m128 x, __m128 y, __m128 z, __m128 w, glm::mat4* matrices, uint32_t column)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(&matrices[0][column].x, x);
+		_mm_storeu_ps(&matrices[1][column].x, y);
+		_mm_storeu_ps(&matrices[2][column].x, z);
+		_mm_storeu_ps(&matrices[3][column].x, w);
+	}
+
+	SCORCH_TARGET_SSE void ComposeMatricesSSE(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* matrices, uint32_t count)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 zero = _mm_setzero_ps();
+
+		uint32_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 qx, qy, qz, qw, sx, sy, sz, px, py, pz;
+			LoadQuatSSE(rotations + i, qx, qy, qz, qw);
+			LoadVec3SSE(scales + i, sx, sy, sz);
+			LoadVec3SSE(positions + i, px, py, pz);
+
+			const __m128 qxx = _mm_mul_ps(qx, qx);
+			const __m128 qyy = _mm_mul_ps(qy, qy);
+			const __m128 qzz = _mm_mul_ps(qz, qz);
+			const __m128 qxz = _mm_mul_ps(qx, qz);
+			const __m128 qxy = _mm_mul_ps(qx, qy);
+			const __m128 qyz = _mm_mul_ps(qy, qz);
+			const __m128 qwx = _mm_mul_ps(qw, qx);
+			const __m128 qwy = _mm_mul_ps(qw, qy);
+			const __m128 qwz = _mm_mul_ps(qw, qz);
+
+			StoreColumnsSSE(
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(qyy, qzz))), sx),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(qxy, qwz)), sx),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(qxz, qwy)), sx),
+				zero, matrices + i, 0);
+			StoreColumnsSSE(
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(qxy, qwz)), sy),
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(qxx, qzz))), sy),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(qyz, qwx)), sy),
+				zero, matrices + i, 1);
+			StoreColumnsSSE(
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(qxz, qwy)), sz),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(qyz, qwx)), sz),
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(qxx, qyy))), sz),
+				zero, matrices + i, 2);
+			StoreColumnsSSE(px, py, pz, one, matrices + i, 3);
+		}
+
+		ComposeMatricesScalar(positions + i, rotations + i, scales + i, matrices + i, count - i);
+	}
+
+	//Each result column is a weighted sum of the parent columns, same order as glm's operator*
+	SCORCH_TARGET_SSE void MultiplyParentsSSE(const uint32_t* parents, const glm::mat4* localMatrices, glm::mat4* worldMatrices, uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			const uint32_t parent = parents[i];
+			if (parent == TransformKernels::INVALID_PARENT)
+			{
+				worldMatrices[i] = localMatrices[i];
+				continue;
+			}
+
+			const glm::mat4& a = worldMatrices[parent];
+			const glm::mat4& b = localMatrices[i];
+			const __m128 a0 = _mm_loadu_ps(&a[0].x);
+			const __m128 a1 = _mm_loadu_ps(&a[1].x);
+			const __m128 a2 = _mm_loadu_ps(&a[2].x);
+			const __m128 a3 = _mm_loadu_ps(&a[3].x);
+
+			for (int column = 0; column < 4; ++column)
+			{
+				const __m128 bc = _mm_loadu_ps(&b[column].x);
+
+				__m128 result = _mm_mul_ps(a0, _mm_shuffle_ps(bc, bc, 0x00));
+				result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_shuffle_ps(bc, bc, 0x55)));
+				result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_shuffle_ps(bc, bc, 0xAA)));
+				result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_shuffle_ps(bc, bc, 0xFF)));
+				_mm_storeu_ps(&worldMatrices[i][column].x, result);
+			}
+		}
+	}
+
+	SCORCH_TARGET_AVX2 void StoreColumnsAVX2(__m256 x, __m256 y, __m256 z, __m256 w, glm::mat4* matrices, uint32_t column)
+	{
+		__m128 x0 = _mm256_castps256_ps128(x), x1 = _mm256_extractf128_ps(x, 1);
+		__m128 y0 = _mm256_castps256_ps128(y), y1 = _mm256_extractf128_ps(y, 1);
+		__m128 z0 = _mm256_castps256_ps128(z), z1 = _mm256_extractf128_ps(z, 1);
+		__m128 w0 = _mm256_castps256_ps128(w), w1 = _mm256_extractf128_ps(w, 1);
+
+		_MM_TRANSPOSE4_PS(x0, y0, z0, w0);
+		_MM_TRANSPOSE4_PS(x1, y1, z1, w1);
+
+		_mm_storeu_ps(&matrices[0][column].x, x0);
+		_mm_storeu_ps(&matrices[1][column].x, y0);
+		_mm_storeu_ps(&matrices[2][column].x, z0);
+		_mm_storeu_ps(&matrices[3][column].x, w0);
+		_mm_storeu_ps(&matrices[4][column].x, x1);
+		_mm_storeu_ps(&matrices[5][column].x, y1);
+		_mm_storeu_ps(&matrices[6][column].x, z1);
+		_mm_storeu_ps(&matrices[7][column].x, w1);
+	}
+
+	SCORCH_TARGET_AVX2 __m256 Combine(__m128 low, __m128 high)
+	{
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+	}
+
+	SCORCH_TARGET_AVX2 void ComposeMatricesAVX2(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* matrices, uint32_t count)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 two = _mm256_set1_ps(2.0f);
+		const __m256 zero = _mm256_setzero_ps();
+
+		uint32_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128 qx0, qy0, qz0, qw0, sx0, sy0, sz0, px0, py0, pz0;
+			__m128 qx1, qy1, qz1, qw1, sx1, sy1, sz1, px1, py1, pz1;
+			LoadQuatSSE(rotations + i, qx0, qy0, qz0, qw0);
+			LoadQuatSSE(rotations + i + 4, qx1, qy1, qz1, qw1);
+			LoadVec3SSE(scales + i, sx0, sy0, sz0);
+			LoadVec3SSE(scales + i + 4, sx1, sy1, sz1);
+			LoadVec3SSE(positions + i, px0, py0, pz0);
+			LoadVec3SSE(positions + i + 4, px1, py1, pz1);
+
+			const __m256 qx = Combine(qx0, qx1);
+			const __m256 qy = Combine(qy0, qy1);
+			const __m256 qz = Combine(qz0, qz1);
+			const __m256 qw = Combine(qw0, qw1);
+			const __m256 sx = Combine(sx0, sx1);
+			const __m256 sy = Combine(sy0, sy1);
+			const __m256 sz = Combine(sz0, sz1);
+
+			const __m256 qxx = _mm256_mul_ps(qx, qx);
+			const __m256 qyy = _mm256_mul_ps(qy, qy);
+			const __m256 qzz = _mm256_mul_ps(qz, qz);
+			const __m256 qxz = _mm256_mul_ps(qx, qz);
+			const __m256 qxy = _mm256_mul_ps(qx, qy);
+			const __m256 qyz = _mm256_mul_ps(qy, qz);
+			const __m256 qwx = _mm256_mul_ps(qw, qx);
+			const __m256 qwy = _mm256_mul_ps(qw, qy);
+			const __m256 qwz = _mm256_mul_ps(qw, qz);
+
+			StoreColumnsAVX2(
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(qyy, qzz))), sx),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(qxy, qwz)), sx),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(qxz, qwy)), sx),
+				zero, matrices + i, 0);
+			StoreColumnsAVX2(
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(qxy, qwz)), sy),
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(qxx, qzz))), sy),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(qyz, qwx)), sy),
+				zero, matrices + i, 1);
+			StoreColumnsAVX2(
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(qxz, qwy)), sz),
+				_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(qyz, qwx)), sz),
+				_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(qxx, qyy))), sz),
+				zero, matrices + i, 2);
+			StoreColumnsAVX2(Combine(px0, px1), Combine(py0, py1), Combine(pz0, pz1), one, matrices + i, 3);
+		}
+
+		ComposeMatricesSSE(positions + i, rotations + i, scales + i, matrices + i, count - i);
+	}
+
+	//Two result columns per instruction, the parent columns are broadcast to both halves
+	SCORCH_TARGET_AVX2 void MultiplyParentsAVX2(const uint32_t* parents, const glm::mat4* localMatrices, glm::mat4* worldMatrices, uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			const uint32_t parent = parents[i];
+			if (parent == TransformKernels::INVALID_PARENT)
+			{
+				worldMatrices[i] = localMatrices[i];
+				continue;
+			}
+
+			const glm::mat4& a = worldMatrices[parent];
+			const glm::mat4& b = localMatrices[i];
+			const __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[0].x));
+			const __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[1].x));
+			const __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[2].x));
+			const __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&a[3].x));
+
+			for (int column = 0; column < 4; column += 2)
+			{
+				const __m256 b01 = _mm256_loadu_ps(&b[column].x);
+
+				__m256 result = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+				result = _mm256_add_ps(result, _mm256_mul_ps(a1, _mm256_permute_ps(b01, 0x55)));
+				result = _mm256_add_ps(result, _mm256_mul_ps(a2, _mm256_permute_ps(b01, 0xAA)));
+				result = _mm256_add_ps(result, _mm256_mul_ps(a3, _mm256_permute_ps(b01, 0xFF)));
+				_mm256_storeu_ps(&worldMatrices[i][column].x, result);
+			}
+		}
+	}
+#endif
+}
+
+void TransformKernels::ComposeMatrices(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* matrices, uint32_t count)
+{
+	ComposeMatrices(positions, rotations, scales, matrices, count, Cpu::ActiveSimdLevel());
+}
+
+void TransformKernels::ComposeMatrices(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* matrices, uint32_t count, SimdLevel level)
+{
+	CORE_ASSERT(level <= Cpu::SupportedSimdLevel(), "Simd level is not supported on this cpu");
+
+	switch (level)
+	{
+#ifdef SCORCH_SIMD_X86
+	case SimdLevel::AVX2:
+		ComposeMatricesAVX2(positions, rotations, scales, matrices, count);
+		break;
+	case SimdLevel::SSE:
+		ComposeMatricesSSE(positions, rotations, scales, matrices, count);
+		break;
+#endif
+	default:
+		ComposeMatricesScalar(positions, rotations, scales, matrices, count);
+		break;
+	}
+}
+
+void TransformKernels::MultiplyParents(const uint32_t* parents, const glm::mat4* localMatrices, glm::mat4* worldMatrices, uint32_t begin, uint32_t end)
+{
+	MultiplyParents(parents, localMatrices, worldMatrices, begin, end, Cpu::ActiveSimdLevel());
+}
+
+void TransformKernels::MultiplyParents(const uint32_t* parents, const glm::mat4* localMatrices, glm::mat4* worldMatrices, uint32_t begin, uint32_t end, SimdLevel level)
+{
+	CORE_ASSERT(level <= Cpu::SupportedSimdLevel(), "Simd level is not supported on this cpu");
+
+	switch (level)
+	{
+#ifdef SCORCH_SIMD_X86
+	case SimdLevel::AVX2:
+		MultiplyParentsAVX2(parents, localMatrices, worldMatrices, begin, end);
+		break;
+	case SimdLevel::SSE:
+		MultiplyParentsSSE(parents, localMatrices, worldMatrices, begin, end);
+		break;
+#endif
+	default:
+		MultiplyParentsScalar(parents, localMatrices, worldMatrices, begin, end);
+		break;
+	}
+}
@@ -51,7 +51,8 @@ ScopedMapData::ScopedMapData() :
 
 ScopedMapData::~ScopedMapData()
 {
-	m_unmapFunc();
+	if (m_unmapFunc)
+		m_unmapFunc();
 	m_mapped = nullptr;
 }
 
@@ -103,3 +103,14 @@ float Camera::Fov() const
 {
 	return m_fov;
 }
+
+Ray Camera::ScreenPointToRay(float x, float y, float width, float height) const
+{
+	const float tanHalfFov = std::tan(glm::radians(m_fov) * 0.5f);
+	const float offsetX = (2.0f * x / width - 1.0f) * tanHalfFov * (width / height);
+	const float offsetY = (1.0f - 2.0f * y / height) * tanHalfFov;
+
+	const glm::vec3 right = glm::normalize(Right());
+	const glm::vec3 up = glm::cross(right, m_front);
+	return Ray(m_position, glm::normalize(m_front + right * offsetX + up * offsetY));
+}
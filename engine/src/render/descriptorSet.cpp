@@ -49,6 +49,17 @@ const std::vector<DescriptorBinding>& DescriptorSetLayout::Bindings() const
 	return m_bindings;
 }
 
+uint32_t DescriptorSetLayout::DynamicBindingCount() const
+{
+	uint32_t count = 0;
+	for (const DescriptorBinding& binding : m_bindings)
+	{
+		if (binding.type == DescriptorBindingType::UNIFORM_DYNAMIC || binding.type == DescriptorBindingType::STORAGE_DYNAMIC)
+			++count;
+	}
+	return count;
+}
+
 std::unique_ptr<DescriptorSetLayout> DescriptorSetLayout::Create()
 {
 	SCORCH_API_CREATE(DescriptorSetLayout);
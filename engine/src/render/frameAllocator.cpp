@@ -0,0 +1,61 @@
+#include "pch.h"
+#include "render/frameAllocator.h"
+#include "core/utils.h"
+
+using namespace SC;
+
+FrameAllocator::FrameAllocator(size_t frameCapacity, uint8_t frameCount, const BufferUsageSet& bufferUsage) :
+	m_buffer(Buffer::Create(AlignUp(frameCapacity, MAX_ALIGNMENT) * frameCount, bufferUsage, AllocationUsage::HOST)),
+	m_mappedData(m_buffer->Map()),
+	m_frameCapacity(AlignUp(frameCapacity, MAX_ALIGNMENT)),
+	m_frameCount(frameCount),
+	m_frameBegin(0),
+	m_frameOffset(0)
+{
+	CORE_ASSERT(frameCount > 0, "Frame count must be greater than 0");
+	CORE_ASSERT(m_buffer->HasUsage(BufferUsage::MAP), "Frame allocator buffer needs the MAP usage");
+}
+
+void FrameAllocator::BeginFrame(uint8_t frameIndex)
+{
+	CORE_ASSERT(frameIndex < m_frameCount, "Frame index out of range");
+	m_frameBegin = m_frameCapacity * frameIndex;
+	m_frameOffset.store(0, std::memory_order_relaxed);
+}
+
+FrameAllocation FrameAllocator::Allocate(size_t size, size_t alignment)
+{
+	CORE_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0, "Alignment must be a power of two");
+	CORE_ASSERT(alignment <= MAX_ALIGNMENT, "Alignment is larger than the region alignment");
+
+	size_t offset = m_frameOffset.load(std::memory_order_relaxed);
+	size_t alignedOffset;
+	do
+	{
+		alignedOffset = AlignUp(offset, alignment);
+		if (alignedOffset + size > m_frameCapacity)
+			return FrameAllocation();
+	} while (!m_frameOffset.compare_exchange_weak(offset, alignedOffset + size, std::memory_order_relaxed));
+
+	FrameAllocation allocation;
+	allocation.buffer = m_buffer.get();
+	allocation.offset = m_frameBegin + alignedOffset;
+	allocation.size = size;
+	allocation.data = static_cast<uint8_t*>(m_mappedData.Data()) + allocation.offset;
+	return allocation;
+}
+
+Buffer* FrameAllocator::GetBuffer() const
+{
+	return m_buffer.get();
+}
+
+size_t FrameAllocator::FrameCapacity() const
+{
+	return m_frameCapacity;
+}
+
+size_t FrameAllocator::FrameUsed() const
+{
+	return m_frameOffset.load(std::memory_order_relaxed);
+}
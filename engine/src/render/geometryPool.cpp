@@ -0,0 +1,109 @@
+#include "pch.h"
+#include "render/geometryPool.h"
+#include "render/mesh.h"
+
+using namespace SC;
+
+GeometryPool::GeometryPool(uint32_t vertexCapacity, uint32_t indexCapacity, uint8_t frameCount) :
+	m_vertexAllocator(vertexCapacity),
+	m_indexAllocator(indexCapacity),
+	m_pendingFrees(frameCount),
+	m_frameIndex(0)
+{
+	CORE_ASSERT(frameCount > 0, "Frame count must be greater than 0");
+
+	SC::BufferUsageSet vertexBufferUsage;
+	vertexBufferUsage.set(SC::BufferUsage::VERTEX_BUFFER);
+	vertexBufferUsage.set(SC::BufferUsage::TRANSFER_DST);
+	m_vertexBuffer = Buffer::Create(static_cast<size_t>(vertexCapacity) * sizeof(Vertex), vertexBufferUsage, AllocationUsage::DEVICE);
+
+	SC::BufferUsageSet indexBufferUsage;
+	indexBufferUsage.set(SC::BufferUsage::INDEX_BUFFER);
+	indexBufferUsage.set(SC::BufferUsage::TRANSFER_DST);
+	m_indexBuffer = Buffer::Create(static_cast<size_t>(indexCapacity) * sizeof(VertexIndexType), indexBufferUsage, AllocationUsage::DEVICE);
+}
+
+GeometryAllocation GeometryPool::Allocate(const Vertex* vertices, uint32_t vertexCount, const VertexIndexType* indices, uint32_t indexCount)
+{
+	CORE_ASSERT(vertices && indices && vertexCount > 0 && indexCount > 0, "Geometry can't be empty");
+
+	GeometryAllocation allocation;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		const uint32_t vertexOffset = m_vertexAllocator.Allocate(vertexCount);
+		if (vertexOffset == FreeListAllocator::INVALID_OFFSET)
+			return allocation;
+
+		const uint32_t firstIndex = m_indexAllocator.Allocate(indexCount);
+		if (firstIndex == FreeListAllocator::INVALID_OFFSET)
+		{
+			m_vertexAllocator.Free(vertexOffset, vertexCount);
+			return allocation;
+		}
+
+		allocation.vertexOffset = vertexOffset;
+		allocation.vertexCount = vertexCount;
+		allocation.firstIndex = firstIndex;
+		allocation.indexCount = indexCount;
+	}
+
+	//Batched by the renderer's uploads, the ranges are only handed out once so nothing else writes to them
+	m_vertexBuffer->CopyData(vertices, static_cast<size_t>(vertexCount) * sizeof(Vertex), static_cast<size_t>(allocation.vertexOffset) * sizeof(Vertex));
+	m_indexBuffer->CopyData(indices, static_cast<size_t>(indexCount) * sizeof(VertexIndexType), static_cast<size_t>(allocation.firstIndex) * sizeof(VertexIndexType));
+
+	return allocation;
+}
+
+void GeometryPool::Free(const GeometryAllocation& allocation)
+{
+	if (!allocation.IsValid()) return;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_pendingFrees[m_frameIndex].push_back(allocation);
+}
+
+void GeometryPool::BeginFrame(uint8_t frameIndex)
+{
+	CORE_ASSERT(frameIndex < m_pendingFrees.size(), "Frame index out of range");
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const GeometryAllocation& allocation : m_pendingFrees[frameIndex])
+	{
+		m_vertexAllocator.Free(allocation.vertexOffset, allocation.vertexCount);
+		m_indexAllocator.Free(allocation.firstIndex, allocation.indexCount);
+	}
+	m_pendingFrees[frameIndex].clear();
+	m_frameIndex = frameIndex;
+}
+
+Buffer* GeometryPool::GetVertexBuffer() const
+{
+	return m_vertexBuffer.get();
+}
+
+Buffer* GeometryPool::GetIndexBuffer() const
+{
+	return m_indexBuffer.get();
+}
+
+uint32_t GeometryPool::VertexCapacity() const
+{
+	return m_vertexAllocator.Capacity();
+}
+
+uint32_t GeometryPool::VerticesUsed() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_vertexAllocator.Used();
+}
+
+uint32_t GeometryPool::IndexCapacity() const
+{
+	return m_indexAllocator.Capacity();
+}
+
+uint32_t GeometryPool::IndicesUsed() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_indexAllocator.Used();
+}
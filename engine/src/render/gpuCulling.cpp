@@ -0,0 +1,88 @@
+#include "pch.h"
+#include "render/gpuCulling.h"
+#include "render/shaderModule.h"
+#include "render/pipeline.h"
+#include "render/descriptorSet.h"
+#include "render/commandbuffer.h"
+
+using namespace SC;
+
+namespace
+{
+	//Matches the shader's push constant block
+	struct CullConstants
+	{
+		glm::vec4 planes[Frustum::PLANE_COUNT];
+		uint32_t objectCount;
+	};
+}
+
+GpuCulling::GpuCulling()
+{
+
+}
+
+GpuCulling::~GpuCulling()
+{
+
+}
+
+bool GpuCulling::Init(const std::string& shaderPath)
+{
+	m_shader = ShaderModuleBuilder().SetComputeModulePath(shaderPath).Build();
+	if (!m_shader || !m_shader->IsCompute())
+	{
+		Log::PrintCore(string_format("Failed to load culling shader: {}", shaderPath), LogSeverity::LogError);
+		return false;
+	}
+
+	std::vector<DescriptorBinding> bindings(BINDING_COUNT, DescriptorBinding{ DescriptorBindingType::STORAGE, { ShaderStage::COMPUTE } });
+	m_setLayout = DescriptorSetLayout::Create(std::move(bindings));
+
+	m_pipelineLayout = PipelineLayout::Create();
+	m_pipelineLayout->AddDescriptorSetLayout(m_setLayout.get());
+	m_pipelineLayout->AddPushConstant({ ShaderStage::COMPUTE }, sizeof(CullConstants));
+	if (!m_pipelineLayout->Build())
+		return false;
+
+	m_pipeline = Pipeline::Create(*m_shader);
+	m_pipeline->pipelineLayout = m_pipelineLayout.get();
+	if (!m_pipeline->Build())
+	{
+		m_pipeline.reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool GpuCulling::IsInitialised() const
+{
+	return m_pipeline != nullptr;
+}
+
+const DescriptorSetLayout* GpuCulling::SetLayout() const
+{
+	return m_setLayout.get();
+}
+
+void GpuCulling::Dispatch(CommandBuffer& commandBuffer, const DescriptorSet* descriptorSet, const Frustum& frustum, uint32_t objectCount) const
+{
+	CORE_ASSERT(IsInitialised(), "Gpu culling is not initialised");
+	CORE_ASSERT(descriptorSet && descriptorSet->Layout() == m_setLayout.get(), "Descriptor set needs to use the culling set layout");
+
+	CullConstants constants;
+	for (uint32_t i = 0; i < Frustum::PLANE_COUNT; ++i)
+	{
+		constants.planes[i] = frustum.Plane(i);
+	}
+	constants.objectCount = objectCount;
+
+	commandBuffer.BindPipeline(m_pipeline.get());
+	commandBuffer.BindDescriptorSet(m_pipelineLayout.get(), descriptorSet, 0);
+	commandBuffer.PushConstants(m_pipelineLayout.get(), 0, 0, sizeof(CullConstants), &constants);
+	if (objectCount > 0)
+		commandBuffer.Dispatch((objectCount + GROUP_SIZE - 1) / GROUP_SIZE);
+
+	commandBuffer.PipelineBarrier({ PipelineStage::COMPUTE_SHADER }, { PipelineStage::DRAW_INDIRECT, PipelineStage::VERTEX_SHADER });
+}
@@ -156,13 +156,18 @@ void GUI::BeginFrame()
 
 void GUI::EndFrame()
 {
-	ImGui::Render();
+	EndFrame(m_renderer->GetFrameCommandBuffer());
+}
 
-	VulkanRenderer* vulanRenderer = static_cast<VulkanRenderer*>(m_renderer);
+void GUI::EndFrame(CommandBuffer& commandBuffer)
+{
+	ImGui::Render();
 
-	VulkanCommandBuffer& cmd = static_cast<VulkanCommandBuffer&>(vulanRenderer->GetFrameCommandBuffer());
+	VulkanCommandBuffer& cmd = static_cast<VulkanCommandBuffer&>(commandBuffer);
 
 	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmd.GetCommandBuffer());
+	//ImGui binds its own pipeline, buffers and dynamic state behind the command buffer's back
+	cmd.InvalidateState();
 
 #ifdef ENABLE_VIEWPORTS
 	ImGui::UpdatePlatformWindows();
@@ -205,79 +205,100 @@ std::shared_ptr<SC::Material> MaterialSystem::BuildMaterial(const std::string& m
 		//	newMat->parameters.Finalise();
 		//}
 
-		//if (!info.textures.empty()) 
-		{
-			ShaderPass* forwadPass = newMat->original->passShaders[MeshpassType::Forward];
-			ShaderPass* transparancyPass = newMat->original->passShaders[MeshpassType::Transparency];
+		if (!WriteTextureSets(*newMat))
+			return nullptr;
 
-			CORE_ASSERT(forwadPass || transparancyPass, "pass shaders must be set");
-			if (!forwadPass && !transparancyPass) return nullptr;
+		Log::Print(string_format("Built New Material {0}", materialName));
+		//add material to cache
+		m_materialCache[info] = (newMat);
+		mat = newMat;
+		m_materials[materialName] = mat;
+	}
 
-			DescriptorSetLayout* forwardLayout{ nullptr };
-			DescriptorSetLayout* transparancyLayout{ nullptr };
-			if (forwadPass)
-			{
-				if (auto effect = forwadPass->GetShaderEffect())
-					forwardLayout = effect->GetDescriptorSetLayout(effect->GetTextureSetIndex());
-			}
-			if (transparancyPass)
-			{
-				if (auto effect = transparancyPass->GetShaderEffect())
-					transparancyLayout = effect->GetDescriptorSetLayout(effect->GetTextureSetIndex());
-			}
+	return mat;
+}
 
+bool MaterialSystem::WriteTextureSets(Material& material)
+{
+	ShaderPass* forwadPass = material.original->passShaders[MeshpassType::Forward];
+	ShaderPass* transparancyPass = material.original->passShaders[MeshpassType::Transparency];
 
-			if (forwardLayout)
-			{
-				auto& forwardDescriptor = newMat->passSets[MeshpassType::Forward];
-				forwardDescriptor = forwardDescriptor.Create(forwardLayout);
-
-				for (int i = 0; i < forwardLayout->Bindings().size(); ++i)
-				{
-					//Only set texture if the type is a sampler
-					if (forwardLayout->Bindings()[i].type != DescriptorBindingType::SAMPLER)
-					{
-						forwardDescriptor.ForEach([=](DescriptorSet* set, uint8_t index)
-							{ set->SetBuffer(newMat->parameters.GetBuffer(index), i); });
-
-						continue;
-					}
-
-					if (i < info.textures.size())
-						forwardDescriptor.ForEach([=](DescriptorSet* set, uint8_t index)
-							{ set->SetTexture(info.textures[i], i); });
-					else
-						forwardDescriptor.ForEach([=](DescriptorSet* set, uint8_t index)
-							{ set->SetTexture(App::Instance()->GetRenderer()->WhiteTexture(), i); });
-				}
+	CORE_ASSERT(forwadPass || transparancyPass, "pass shaders must be set");
+	if (!forwadPass && !transparancyPass) return false;
 
-			}
+	DescriptorSetLayout* forwardLayout{ nullptr };
+	DescriptorSetLayout* transparancyLayout{ nullptr };
+	if (forwadPass)
+	{
+		if (auto effect = forwadPass->GetShaderEffect())
+			forwardLayout = effect->GetDescriptorSetLayout(effect->GetTextureSetIndex());
+	}
+	if (transparancyPass)
+	{
+		if (auto effect = transparancyPass->GetShaderEffect())
+			transparancyLayout = effect->GetDescriptorSetLayout(effect->GetTextureSetIndex());
+	}
 
-			if (transparancyLayout)
+
+	if (forwardLayout)
+	{
+		auto& forwardDescriptor = material.passSets[MeshpassType::Forward];
+		forwardDescriptor = DescriptorSet::Create(forwardLayout);
+
+		for (int i = 0; i < forwardLayout->Bindings().size(); ++i)
+		{
+			//Only set texture if the type is a sampler
+			if (forwardLayout->Bindings()[i].type != DescriptorBindingType::SAMPLER)
 			{
-				auto& transparancyDescriptor = newMat->passSets[MeshpassType::Transparency];
-				transparancyDescriptor = transparancyDescriptor.Create(transparancyLayout); 
-
-				for (int i = 0; i < transparancyLayout->Bindings().size(); ++i)
-				{
-					if (i < info.textures.size())
-						transparancyDescriptor.ForEach([=](DescriptorSet* set, uint8_t index)
-							{ set->SetTexture(info.textures[i], i); });
-					else
-						transparancyDescriptor.ForEach([=](DescriptorSet* set, uint8_t index)
-							{ set->SetTexture(App::Instance()->GetRenderer()->WhiteTexture(), i); });
-				}
+				CORE_ASSERT(forwardLayout->Bindings()[i].type == DescriptorBindingType::UNIFORM_DYNAMIC, "Material parameters need a UNIFORM_DYNAMIC binding");
+				const PerFrameBuffer& parameterBuffer = material.parameters.GetBuffer();
+				forwardDescriptor->SetBuffer(parameterBuffer.GetBuffer(), i, 0, parameterBuffer.Size());
+
+				continue;
 			}
+
+			if (i < material.textures.size())
+				forwardDescriptor->SetTexture(material.textures[i], i);
+			else
+				forwardDescriptor->SetTexture(App::Instance()->GetRenderer()->WhiteTexture(), i);
 		}
 
-		Log::Print(string_format("Built New Material {0}", materialName));
-		//add material to cache
-		m_materialCache[info] = (newMat);
-		mat = newMat;
-		m_materials[materialName] = mat;
 	}
 
-	return mat;
+	if (transparancyLayout)
+	{
+		auto& transparancyDescriptor = material.passSets[MeshpassType::Transparency];
+		transparancyDescriptor = DescriptorSet::Create(transparancyLayout);
+
+		for (int i = 0; i < transparancyLayout->Bindings().size(); ++i)
+		{
+			if (i < material.textures.size())
+				transparancyDescriptor->SetTexture(material.textures[i], i);
+			else
+				transparancyDescriptor->SetTexture(App::Instance()->GetRenderer()->WhiteTexture(), i);
+		}
+	}
+
+	material.textureVersions.resize(material.textures.size());
+	for (size_t i = 0; i < material.textures.size(); ++i)
+		material.textureVersions[i] = material.textures[i]->GetImageVersion();
+
+	return true;
+}
+
+uint32_t MaterialSystem::UpdateTextureSets()
+{
+	uint32_t updated = 0;
+	for (auto& [data, material] : m_materialCache)
+	{
+		bool changed = false;
+		for (size_t i = 0; i < material->textures.size(); ++i)
+			changed |= material->textures[i]->GetImageVersion() != material->textureVersions[i];
+
+		if (changed && WriteTextureSets(*material))
+			++updated;
+	}
+	return updated;
 }
 
 std::shared_ptr<SC::Material> MaterialSystem::GetMaterial(const std::string& materialName)
@@ -475,14 +496,7 @@ void ShaderParameters::CreateBuffers()
 	BufferUsageSet uboUsage;
 	uboUsage.set(BufferUsage::UNIFORM_BUFFER);
 	uboUsage.set(BufferUsage::MAP);
-	const auto& matData = m_data;
-	m_parameterBuffers = SC::FrameData<SC::Buffer>::Create(matData.size(), uboUsage, SC::AllocationUsage::HOST);
-
-	m_parameterBuffers.ForEach([&matData](Buffer* buffer, uint8_t index)
-		{
-			auto mapped = buffer->Map();
-			memcpy(mapped.Data(), matData.data(), matData.size());
-		});
+	m_parameterBuffer = PerFrameBuffer(m_data.size(), uboUsage, m_data.data());
 
 	m_created = true;
 }
@@ -491,25 +505,22 @@ void ShaderParameters::Update(uint8_t frameIndex)
 {
 	if (!IsValid(true, false)) return;
 
-	auto mapped = m_parameterBuffers.GetFrameData(frameIndex)->Map();
-	memcpy(mapped.Data(), m_data.data(), m_data.size());
+	memcpy(m_parameterBuffer.GetFrameData(frameIndex), m_data.data(), m_data.size());
 }
 
 void ShaderParameters::UpdateAll()
 {
 	if (!IsValid(true, false)) return;
 
-	const auto& matData = m_data;
-	m_parameterBuffers.ForEach([&matData](Buffer* buffer, uint8_t index)
-		{
-			auto mapped = buffer->Map();
-			memcpy(mapped.Data(), matData.data(), matData.size());
-		});
+	for (uint8_t i = 0; i < m_parameterBuffer.FrameCount(); ++i)
+	{
+		memcpy(m_parameterBuffer.GetFrameData(i), m_data.data(), m_data.size());
+	}
 }
 
-Buffer* ShaderParameters::GetBuffer(uint8_t frameIndex)
+const PerFrameBuffer& ShaderParameters::GetBuffer() const
 {
-	return m_parameterBuffers.GetFrameData(frameIndex);
+	return m_parameterBuffer;
 }
 
 bool ShaderParameters::IsValid(bool validateCreated, bool validateNotCreated,
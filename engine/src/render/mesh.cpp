@@ -5,10 +5,12 @@
 #include "render/texture.h"
 #include "render/renderer.h"
 #include "render/buffer.h"
+#include "core/bvh.h"
+#include "render/geometryPool.h"
 
 using namespace SC;
 
-RenderObject::RenderObject() : mesh(nullptr), material(nullptr)
+RenderObject::RenderObject() : mesh(nullptr), material(nullptr), transform(nullptr)
 {
 
 }
@@ -18,34 +20,56 @@ uint32_t Mesh::VertexCount() const
 	return static_cast<uint32_t>(vertices.size());
 }
 
-Mesh::Mesh() : vertexBuffer(nullptr), indexBuffer(nullptr)
+Mesh::Mesh() : vertexBuffer(nullptr), indexBuffer(nullptr),
+	vertexOffset(0),
+	firstIndex(0),
+	m_geometryPool(nullptr)
 {
 
 }
 
 Mesh::~Mesh()
 {
-	vertexBuffer.reset();
-	indexBuffer.reset();
+	ReleaseBuffers();
 }
 
-Mesh::Mesh(Mesh&& other)
+Mesh::Mesh(Mesh&& other) : Mesh()
 {
 	vertexBuffer = std::move(other.vertexBuffer);
 	indexBuffer = std::move(other.indexBuffer);
+	vertexOffset = other.vertexOffset;
+	firstIndex = other.firstIndex;
+	m_geometryPool = other.m_geometryPool;
+	m_geometryAllocation = other.m_geometryAllocation;
+	other.m_geometryAllocation = GeometryAllocation();
 
 	vertices = std::move(other.vertices);
 	indices = std::move(other.indices);
+
+	bounds = other.bounds;
+	boundingSphere = other.boundingSphere;
+	triangleBvh = std::move(other.triangleBvh);
 }
 
 Mesh& Mesh::operator=(Mesh&& other)
 {
+	ReleaseBuffers();
+
 	vertexBuffer = std::move(other.vertexBuffer);
 	indexBuffer = std::move(other.indexBuffer);
+	vertexOffset = other.vertexOffset;
+	firstIndex = other.firstIndex;
+	m_geometryPool = other.m_geometryPool;
+	m_geometryAllocation = other.m_geometryAllocation;
+	other.m_geometryAllocation = GeometryAllocation();
 
 	vertices = std::move(other.vertices);
 	indices = std::move(other.indices);
 
+	bounds = other.bounds;
+	boundingSphere = other.boundingSphere;
+	triangleBvh = std::move(other.triangleBvh);
+
 	return *this;
 }
 
@@ -56,10 +80,30 @@ uint32_t SC::Mesh::VertexSize() const
 
 bool Mesh::Build()
 {
-	if(vertexBuffer)
+	if(vertexBuffer || IsPooled())
 		Log::PrintCore("Mesh::Build: Vertex buffer already created, this will overwrite the existing buffer", LogSeverity::LogWarning);
-	if (indexBuffer)
+	if (indexBuffer || IsPooled())
 		Log::PrintCore("Mesh::Build: Index buffer already created, this will overwrite the existing buffer", LogSeverity::LogWarning);
+	ReleaseBuffers();
+
+	ComputeBounds();
+
+	const App* app = App::Instance();
+	CORE_ASSERT(app, "App instance is null");
+	GeometryPool* geometryPool = app && app->GetRenderer() ? app->GetRenderer()->GetGeometryPool() : nullptr;
+	if (geometryPool && HasGeometry())
+	{
+		m_geometryAllocation = geometryPool->Allocate(vertices.data(), VertexCount(), indices.data(), IndexCount());
+		if (m_geometryAllocation.IsValid())
+		{
+			m_geometryPool = geometryPool;
+			vertexOffset = m_geometryAllocation.vertexOffset;
+			firstIndex = m_geometryAllocation.firstIndex;
+			return true;
+		}
+
+		Log::PrintCore(string_format("Mesh::Build: Geometry pool is full, creating buffers for {} vertices", VertexCount()), LogSeverity::LogWarning);
+	}
 
 	SC::BufferUsageSet vertexBufferUsage;
 	vertexBufferUsage.set(SC::BufferUsage::VERTEX_BUFFER);
@@ -76,6 +120,53 @@ bool Mesh::Build()
 	return vertexBuffer && indexBuffer;
 }
 
+Buffer* Mesh::GetVertexBuffer() const
+{
+	return IsPooled() ? m_geometryPool->GetVertexBuffer() : vertexBuffer.get();
+}
+
+Buffer* Mesh::GetIndexBuffer() const
+{
+	return IsPooled() ? m_geometryPool->GetIndexBuffer() : indexBuffer.get();
+}
+
+bool Mesh::IsPooled() const
+{
+	return m_geometryAllocation.IsValid();
+}
+
+void Mesh::ReleaseBuffers()
+{
+	vertexBuffer.reset();
+	indexBuffer.reset();
+
+	if (IsPooled())
+		m_geometryPool->Free(m_geometryAllocation);
+	m_geometryPool = nullptr;
+	m_geometryAllocation = GeometryAllocation();
+
+	vertexOffset = 0;
+	firstIndex = 0;
+}
+
+void Mesh::ComputeBounds()
+{
+	bounds = AABB();
+	for (const Vertex& vertex : vertices)
+	{
+		bounds.Expand(vertex.position);
+	}
+
+	//Centered on the box, which is close enough to the minimal sphere for culling and much cheaper to find
+	boundingSphere.center = bounds.IsEmpty() ? glm::vec3(0.0f) : bounds.Center();
+	float radiusSquared = 0.0f;
+	for (const Vertex& vertex : vertices)
+	{
+		radiusSquared = std::max(radiusSquared, glm::distance2(boundingSphere.center, vertex.position));
+	}
+	boundingSphere.radius = std::sqrt(radiusSquared);
+}
+
 uint32_t Mesh::IndexCount() const
 {
 	return static_cast<uint32_t>(indices.size());
@@ -85,3 +176,71 @@ uint32_t Mesh::IndexSize() const
 {
 	return static_cast<uint32_t>(indices.size() * sizeof(VertexIndexType));
 }
+
+void Mesh::BuildTriangleBvh()
+{
+	CORE_ASSERT(HasGeometry(), "Mesh::BuildTriangleBvh: The vertices and indices have been released");
+
+	const uint32_t triangleCount = IndexCount() / 3;
+	std::vector<AABB> triangleBounds(triangleCount);
+	for (uint32_t i = 0; i < triangleCount; ++i)
+	{
+		glm::vec3 v0, v1, v2;
+		Triangle(i, v0, v1, v2);
+		triangleBounds[i].Expand(v0);
+		triangleBounds[i].Expand(v1);
+		triangleBounds[i].Expand(v2);
+	}
+
+	triangleBvh = std::make_unique<BVH>();
+	triangleBvh->Build(triangleBounds.data(), triangleCount);
+}
+
+bool Mesh::HasGeometry() const
+{
+	return !vertices.empty() && !indices.empty();
+}
+
+bool Mesh::Raycast(const Ray& ray, float maxDistance, float& distance, uint32_t& triangle) const
+{
+	if (!HasGeometry()) return false;
+
+	bool hit = false;
+	const auto TestTriangle = [&](uint32_t i, float currentMaxDistance)
+	{
+		glm::vec3 v0, v1, v2;
+		Triangle(i, v0, v1, v2);
+
+		float triangleDistance;
+		glm::vec2 barycentric;
+		if (!IntersectRayTriangle(ray, v0, v1, v2, triangleDistance, barycentric) || triangleDistance > currentMaxDistance)
+			return currentMaxDistance;
+
+		hit = true;
+		distance = triangleDistance;
+		triangle = i;
+		return triangleDistance;
+	};
+
+	if (triangleBvh)
+	{
+		triangleBvh->Raycast(ray, maxDistance, TestTriangle);
+	}
+	else
+	{
+		const uint32_t triangleCount = IndexCount() / 3;
+		for (uint32_t i = 0; i < triangleCount; ++i)
+		{
+			maxDistance = TestTriangle(i, maxDistance);
+		}
+	}
+
+	return hit;
+}
+
+void Mesh::Triangle(uint32_t triangle, glm::vec3& v0, glm::vec3& v1, glm::vec3& v2) const
+{
+	v0 = vertices[indices[triangle * 3]].position;
+	v1 = vertices[indices[triangle * 3 + 1]].position;
+	v2 = vertices[indices[triangle * 3 + 2]].position;
+}
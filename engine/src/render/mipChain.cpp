@@ -0,0 +1,186 @@
+#include "pch.h"
+#include "render/mipChain.h"
+#include <cmath>
+#include <cstring>
+
+using namespace SC;
+
+namespace
+{
+	constexpr uint32_t CHANNELS = 4;
+	constexpr uint32_t ALPHA_CHANNEL = 3;
+
+	//Taps either side of a destination texel in source texels, wider keeps more detail but costs more and rings more
+	constexpr int KAISER_RADIUS = 3;
+	constexpr float KAISER_BETA = 4.0f;
+	constexpr float PI = 3.14159265358979f;
+
+	struct FilterKernel
+	{
+		int firstTap; //Of destination texel x the taps read source texels 2x + firstTap onwards
+		std::vector<float> weights;
+	};
+
+	//Zeroth order modified Bessel function of the first kind, used by the Kaiser window
+	float BesselI0(float x)
+	{
+		float sum = 1.0f;
+		float term = 1.0f;
+		for (int k = 1; k < 20; ++k)
+		{
+			const float factor = x / (2.0f * k);
+			term *= factor * factor;
+			sum += term;
+		}
+		return sum;
+	}
+
+	FilterKernel MakeKernel(MipFilter filter)
+	{
+		FilterKernel kernel;
+		if (filter == MipFilter::BOX)
+		{
+			kernel.firstTap = 0;
+			kernel.weights = { 0.5f, 0.5f };
+			return kernel;
+		}
+
+		kernel.firstTap = 1 - KAISER_RADIUS;
+		float weightSum = 0.0f;
+		for (int tap = kernel.firstTap; tap <= KAISER_RADIUS; ++tap)
+		{
+			//Distance from the centre of the destination texel in source texels, the sinc is in destination texels
+			const float distance = tap - 0.5f;
+			const float x = distance * 0.5f;
+			const float sinc = std::sin(PI * x) / (PI * x);
+
+			const float r = distance / KAISER_RADIUS;
+			const float window = BesselI0(KAISER_BETA * std::sqrt(std::max(0.0f, 1.0f - r * r))) / BesselI0(KAISER_BETA);
+
+			kernel.weights.push_back(sinc * window);
+			weightSum += kernel.weights.back();
+		}
+
+		for (float& weight : kernel.weights)
+			weight /= weightSum;
+		return kernel;
+	}
+
+	//Halves one axis, the other is left as it is. Texels along the axis are axisStride texels apart and lines are lineStride
+	//texels apart, so the same code filters rows and columns
+	void DownsampleAxis(const float* src, float* dst, uint32_t srcLength, uint32_t dstLength, uint32_t lineCount,
+		uint32_t srcAxisStride, uint32_t srcLineStride, uint32_t dstAxisStride, uint32_t dstLineStride, const FilterKernel& kernel)
+	{
+		for (uint32_t line = 0; line < lineCount; ++line)
+		{
+			const float* srcLine = src + static_cast<size_t>(line) * srcLineStride * CHANNELS;
+			float* dstLine = dst + static_cast<size_t>(line) * dstLineStride * CHANNELS;
+
+			for (uint32_t i = 0; i < dstLength; ++i)
+			{
+				float sum[CHANNELS] = {};
+				for (size_t tap = 0; tap < kernel.weights.size(); ++tap)
+				{
+					//Clamp to the edge so borders don't darken
+					const int srcIndex = std::clamp(static_cast<int>(i * 2) + kernel.firstTap + static_cast<int>(tap), 0, static_cast<int>(srcLength) - 1);
+					const float* texel = srcLine + static_cast<size_t>(srcIndex) * srcAxisStride * CHANNELS;
+					for (uint32_t c = 0; c < CHANNELS; ++c)
+						sum[c] += texel[c] * kernel.weights[tap];
+				}
+
+				float* texel = dstLine + static_cast<size_t>(i) * dstAxisStride * CHANNELS;
+				memcpy(texel, sum, sizeof(sum));
+			}
+		}
+	}
+
+	uint8_t EncodeChannel(float value, bool srgb)
+	{
+		value = std::clamp(value, 0.0f, 1.0f);
+		if (srgb)
+			value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+		return static_cast<uint8_t>(value * 255.0f + 0.5f);
+	}
+}
+
+uint32_t SC::MipLevelCount(uint32_t width, uint32_t height)
+{
+	return static_cast<uint32_t>(std::floor(std::log2(std::max(std::max(width, height), 1u)))) + 1;
+}
+
+size_t SC::MipChainSize(Format format, uint32_t width, uint32_t height, uint32_t levelCount)
+{
+	size_t size = 0;
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		size += ImageSize(format, width, height);
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+	}
+	return size;
+}
+
+MipChain SC::GenerateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, bool srgb, MipFilter filter)
+{
+	MipChain chain;
+	CORE_ASSERT(pixels && width > 0 && height > 0, "No pixels to generate mips from");
+	if (!pixels || width == 0 || height == 0) return chain;
+
+	const uint32_t levelCount = MipLevelCount(width, height);
+	chain.pixels.resize(MipChainSize(Format::R8G8B8A8_SRGB, width, height, levelCount));
+	chain.levels.reserve(levelCount);
+
+	//Level 0 is copied as it is
+	const size_t baseSize = static_cast<size_t>(width) * height * CHANNELS;
+	memcpy(chain.pixels.data(), pixels, baseSize);
+	chain.levels.push_back({ 0, baseSize, width, height });
+
+	//Filtering happens in linear float so rounding errors don't build up from level to level
+	std::array<float, 256> decode;
+	for (uint32_t i = 0; i < decode.size(); ++i)
+	{
+		const float value = i / 255.0f;
+		decode[i] = srgb ? (value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f)) : value;
+	}
+
+	std::vector<float> level(baseSize);
+	for (size_t i = 0; i < baseSize; ++i)
+		level[i] = i % CHANNELS == ALPHA_CHANNEL ? pixels[i] / 255.0f : decode[pixels[i]];
+
+	const FilterKernel kernel = MakeKernel(filter);
+	std::vector<float> halfWidth;
+	std::vector<float> next;
+	size_t offset = baseSize;
+
+	for (uint32_t mip = 1; mip < levelCount; ++mip)
+	{
+		const uint32_t dstWidth = std::max(width / 2, 1u);
+		const uint32_t dstHeight = std::max(height / 2, 1u);
+
+		//Rows then columns, an axis that is already 1 texel is copied
+		halfWidth.resize(static_cast<size_t>(dstWidth) * height * CHANNELS);
+		if (dstWidth == width)
+			halfWidth.assign(level.begin(), level.end());
+		else
+			DownsampleAxis(level.data(), halfWidth.data(), width, dstWidth, height, 1, width, 1, dstWidth, kernel);
+
+		next.resize(static_cast<size_t>(dstWidth) * dstHeight * CHANNELS);
+		if (dstHeight == height)
+			next.assign(halfWidth.begin(), halfWidth.end());
+		else
+			DownsampleAxis(halfWidth.data(), next.data(), height, dstHeight, dstWidth, dstWidth, 1, dstWidth, 1, kernel);
+
+		const size_t size = next.size();
+		uint8_t* dst = chain.pixels.data() + offset;
+		for (size_t i = 0; i < size; ++i)
+			dst[i] = EncodeChannel(next[i], srgb && i % CHANNELS != ALPHA_CHANNEL);
+		chain.levels.push_back({ offset, size, dstWidth, dstHeight });
+
+		offset += size;
+		level.swap(next);
+		width = dstWidth;
+		height = dstHeight;
+	}
+
+	return chain;
+}
@@ -0,0 +1,77 @@
+#include "pch.h"
+#include "render/perFrameBuffer.h"
+#include "render/renderer.h"
+#include "core/utils.h"
+#include <cstring>
+
+using namespace SC;
+
+PerFrameBuffer::PerFrameBuffer() :
+	m_mapped(nullptr),
+	m_size(0),
+	m_stride(0),
+	m_frameCount(0)
+{
+
+}
+
+PerFrameBuffer::PerFrameBuffer(size_t size, const BufferUsageSet& bufferUsage, const void* data) : PerFrameBuffer()
+{
+	CORE_ASSERT(bufferUsage.test(BufferUsage::MAP), "Per frame buffers need the MAP usage");
+
+	const App* app = App::Instance();
+	CORE_ASSERT(app, "App instance is null");
+	if (!app) return;
+
+	const Renderer* renderer = app->GetRenderer();
+	CORE_ASSERT(renderer, "renderer is null");
+	if (!renderer) return;
+
+	m_size = size;
+	m_stride = AlignUp(size, std::max(renderer->UniformBufferAlignment(), renderer->StorageBufferAlignment()));
+	m_frameCount = renderer->FrameDataIndexCount();
+	m_buffer = Buffer::Create(m_stride * m_frameCount, bufferUsage, AllocationUsage::HOST);
+
+	//Mapped buffers stay mapped for their lifetime so the pointer can be kept
+	m_mapped = static_cast<uint8_t*>(m_buffer->Map().Data());
+
+	if (data)
+	{
+		for (uint8_t i = 0; i < m_frameCount; ++i)
+		{
+			memcpy(GetFrameData(i), data, size);
+		}
+	}
+}
+
+void* PerFrameBuffer::GetFrameData(uint8_t frameIndex) const
+{
+	CORE_ASSERT(frameIndex < m_frameCount, "Invalid frame index");
+	return m_mapped + m_stride * frameIndex;
+}
+
+uint32_t PerFrameBuffer::FrameOffset(uint8_t frameIndex) const
+{
+	CORE_ASSERT(frameIndex < m_frameCount, "Invalid frame index");
+	return static_cast<uint32_t>(m_stride * frameIndex);
+}
+
+Buffer* PerFrameBuffer::GetBuffer() const
+{
+	return m_buffer.get();
+}
+
+size_t PerFrameBuffer::Size() const
+{
+	return m_size;
+}
+
+uint8_t PerFrameBuffer::FrameCount() const
+{
+	return m_frameCount;
+}
+
+bool PerFrameBuffer::IsValid() const
+{
+	return m_buffer != nullptr;
+}
@@ -39,6 +39,37 @@ uint32_t SC::ConvertFormatSize(Format format)
 	return 0;
 }
 
+bool SC::IsBlockCompressed(Format format)
+{
+	return FormatBlockSize(format) != 0;
+}
+
+uint32_t SC::FormatBlockSize(Format format)
+{
+	switch (format)
+	{
+	case Format::BC1_RGB_UNORM:
+	case Format::BC1_RGB_SRGB:
+		return 8;
+	case Format::BC3_UNORM:
+	case Format::BC3_SRGB:
+	case Format::BC5_UNORM:
+	case Format::BC7_UNORM:
+	case Format::BC7_SRGB:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+size_t SC::ImageSize(Format format, uint32_t width, uint32_t height)
+{
+	if (IsBlockCompressed(format))
+		return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * FormatBlockSize(format);
+
+	return static_cast<size_t>(width) * height * ConvertFormatSize(format);
+}
+
 VertexInputDescription::VertexInputDescription(VertexInputRate inputRate) :
 	m_inputRate(inputRate)
 {
@@ -207,3 +238,8 @@ Pipeline::~Pipeline()
 {
 
 }
+
+bool Pipeline::IsCompute() const
+{
+	return shaderModule->IsCompute();
+}
@@ -0,0 +1,112 @@
+#include "pch.h"
+#include "render/renderQueue.h"
+#include <cstring>
+
+using namespace SC;
+
+namespace
+{
+	constexpr uint32_t RADIX_BITS = 8;
+	constexpr uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+	constexpr uint32_t RADIX_PASSES = 64 / RADIX_BITS;
+
+	constexpr uint32_t PASS_SHIFT = 60;
+	constexpr uint32_t PIPELINE_SHIFT = 48;
+	constexpr uint32_t MATERIAL_SHIFT = 32;
+	constexpr uint32_t MESH_SHIFT = 16;
+
+	constexpr uint64_t PASS_MASK = 0xF;
+	constexpr uint64_t PIPELINE_MASK = 0xFFF;
+	constexpr uint64_t MATERIAL_MASK = 0xFFFF;
+	constexpr uint64_t MESH_MASK = 0xFFFF;
+
+	//The bits of a positive float sort the same way as its value, the top 16 bits keep the exponent and 7 bits of mantissa
+	//which is a precision of about 1% at any distance
+	uint16_t QuantizeDistance(float distance)
+	{
+		uint32_t bits;
+		const float clamped = std::max(distance, 0.0f);
+		std::memcpy(&bits, &clamped, sizeof(bits));
+		return static_cast<uint16_t>(bits >> 16);
+	}
+}
+
+uint64_t RenderQueue::MakeKey(MeshpassType pass, uint32_t pipelineId, uint32_t materialId, uint32_t meshId, float viewDistance)
+{
+	uint16_t depth = QuantizeDistance(viewDistance);
+	if (pass == MeshpassType::Transparency)
+		depth = static_cast<uint16_t>(~depth);
+
+	return (static_cast<uint64_t>(pass) & PASS_MASK) << PASS_SHIFT |
+		(pipelineId & PIPELINE_MASK) << PIPELINE_SHIFT |
+		(materialId & MATERIAL_MASK) << MATERIAL_SHIFT |
+		(meshId & MESH_MASK) << MESH_SHIFT |
+		depth;
+}
+
+uint32_t RenderQueue::SortId(const void* object)
+{
+	//0 is left for null
+	if (!object) return 0;
+	return m_sortIds.try_emplace(object, static_cast<uint32_t>(m_sortIds.size()) + 1).first->second;
+}
+
+void RenderQueue::ResetSortIds()
+{
+	m_sortIds.clear();
+}
+
+void RenderQueue::Clear()
+{
+	m_items.clear();
+}
+
+void RenderQueue::Add(uint64_t key, uint32_t object)
+{
+	m_items.push_back({ key, object });
+}
+
+void RenderQueue::Sort()
+{
+	const uint32_t count = static_cast<uint32_t>(m_items.size());
+	if (count < 2) return;
+
+	//One read of the keys builds the histograms of every pass
+	std::array<std::array<uint32_t, RADIX_SIZE>, RADIX_PASSES> histograms{};
+	for (const Item& item : m_items)
+	{
+		for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+		{
+			++histograms[pass][(item.key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)];
+		}
+	}
+
+	m_sortScratch.resize(count);
+	for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+	{
+		const uint32_t shift = pass * RADIX_BITS;
+		std::array<uint32_t, RADIX_SIZE>& histogram = histograms[pass];
+
+		//Every key has the same digit so this pass wouldn't move anything
+		if (histogram[(m_items[0].key >> shift) & (RADIX_SIZE - 1)] == count) continue;
+
+		uint32_t offset = 0;
+		for (uint32_t& bucket : histogram)
+		{
+			const uint32_t bucketCount = bucket;
+			bucket = offset;
+			offset += bucketCount;
+		}
+
+		for (const Item& item : m_items)
+		{
+			m_sortScratch[histogram[(item.key >> shift) & (RADIX_SIZE - 1)]++] = item;
+		}
+		m_items.swap(m_sortScratch);
+	}
+}
+
+const std::vector<RenderQueue::Item>& RenderQueue::Items() const
+{
+	return m_items;
+}
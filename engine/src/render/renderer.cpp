@@ -1,6 +1,9 @@
 #include "pch.h"
 #include "render/renderer.h"
 #include "vk/vulkanRenderer.h"
+#include "render/frameAllocator.h"
+#include "render/geometryPool.h"
+#include "render/buffer.h"
 
 using namespace SC;
 
@@ -23,7 +26,9 @@ std::unique_ptr<Renderer> Renderer::Create(GraphicsAPI api)
 	}
 }
 
-Renderer::Renderer(GraphicsAPI api) : m_api(api), m_currentFrame(0)
+Renderer::Renderer(GraphicsAPI api) : m_api(api), m_currentFrame(0), m_supportsMultiDrawIndirect(false), m_supportsDrawIndirectCount(false), m_supportsBlockCompression(false),
+	m_uniformBufferAlignment(FrameAllocator::MAX_ALIGNMENT),
+	m_storageBufferAlignment(FrameAllocator::MAX_ALIGNMENT)
 {
 
 }
@@ -38,6 +43,42 @@ GraphicsAPI Renderer::GetApi() const
 	return m_api;
 }
 
+bool Renderer::SupportsMultiDrawIndirect() const
+{
+	return m_supportsMultiDrawIndirect;
+}
+
+bool Renderer::SupportsDrawIndirectCount() const
+{
+	return m_supportsDrawIndirectCount;
+}
+
+bool Renderer::SupportsBlockCompression() const
+{
+	return m_supportsBlockCompression;
+}
+
+size_t Renderer::UniformBufferAlignment() const
+{
+	return m_uniformBufferAlignment;
+}
+
+size_t Renderer::StorageBufferAlignment() const
+{
+	return m_storageBufferAlignment;
+}
+
+FrameAllocator& Renderer::GetFrameAllocator() const
+{
+	CORE_ASSERT(m_frameAllocator, "Frame allocator is created in Init");
+	return *m_frameAllocator;
+}
+
+GeometryPool* Renderer::GetGeometryPool() const
+{
+	return m_geometryPool.get();
+}
+
 uint8_t Renderer::FrameDataIndex() const
 {
 	switch (m_api)
@@ -62,6 +103,20 @@ uint8_t Renderer::FrameDataIndexCount() const
 
 void Renderer::Init()
 {
+	BufferUsageSet frameAllocatorUsage;
+	frameAllocatorUsage.set(BufferUsage::VERTEX_BUFFER);
+	frameAllocatorUsage.set(BufferUsage::INDEX_BUFFER);
+	frameAllocatorUsage.set(BufferUsage::UNIFORM_BUFFER);
+	frameAllocatorUsage.set(BufferUsage::STORAGE_BUFFER);
+	frameAllocatorUsage.set(BufferUsage::INDIRECT_BUFFER);
+	frameAllocatorUsage.set(BufferUsage::TRANSFER_SRC);
+	frameAllocatorUsage.set(BufferUsage::MAP);
+	m_frameAllocator = std::make_unique<FrameAllocator>(FRAME_ALLOCATOR_CAPACITY, FrameDataIndexCount(), frameAllocatorUsage);
+	m_frameAllocator->BeginFrame(FrameDataIndex());
+
+	m_geometryPool = std::make_unique<GeometryPool>(GEOMETRY_POOL_VERTEX_CAPACITY, GEOMETRY_POOL_INDEX_CAPACITY, FrameDataIndexCount());
+	m_geometryPool->BeginFrame(FrameDataIndex());
+
 	if (!gWhiteTexture)
 	{
 		gWhiteTexture = Texture::Create(TextureType::TEXTURE2D, TextureUsage::COLOUR, Format::R8G8B8A8_SRGB);
@@ -83,6 +138,8 @@ void Renderer::Init()
 
 void Renderer::Cleanup()
 {
+	m_frameAllocator.reset();
+	m_geometryPool.reset();
 	gWhiteTexture.reset();
 	gBlackTexture.reset();
 }
@@ -4,10 +4,17 @@
 #include "render/pipeline.h"
 #include "render/mesh.h"
 #include "render/buffer.h"
+#include "render/frameAllocator.h"
 #include "render/texture.h"
+#include "render/mipChain.h"
+#include "render/textureCompression.h"
 #include "assetModel.h"
 #include "jaam.h"
 #include "render/commandbuffer.h"
+#include "render/descriptorSet.h"
+#include "core/threadPool.h"
+#include <numeric>
+#include <filesystem>
 
 using namespace SC;
 
@@ -31,9 +38,112 @@ namespace
 	Asset::TextureManager<TextureUserData> gTextureManager;
 	Asset::ModelManager<ModelUserData> gModelManager;
 	Asset::MaterialManager<MaterialUserData> gMaterialManager;
+
+	//Below this a linear SIMD test of every object is cheaper than walking the BVH
+	constexpr uint32_t BVH_CULLING_MIN_OBJECTS = 2048;
+
+	constexpr const char* COMPRESSED_TEXTURE_CACHE = "data/cache/textures";
+
+	//FNV-1a of the pixels and size, textures are cached by content so an edited source texture is compressed again
+	uint64_t HashPixels(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		auto add = [&hash](uint8_t byte)
+		{
+			hash ^= byte;
+			hash *= 1099511628211ull;
+		};
+
+		for (uint8_t byte : pixels)
+			add(byte);
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			add(static_cast<uint8_t>(width >> (i * 8)));
+			add(static_cast<uint8_t>(height >> (i * 8)));
+		}
+		return hash;
+	}
+
+	//Largest side of the bounds on screen in pixels, 0 when they are off screen. Bounds crossing the near plane could cover
+	//any amount of the screen so they count as covering all of it
+	float ScreenSize(const AABB& bounds, const glm::mat4& viewProjection, float viewportWidth, float viewportHeight)
+	{
+		glm::vec2 ndcMin(std::numeric_limits<float>::max());
+		glm::vec2 ndcMax(std::numeric_limits<float>::lowest());
+		uint32_t behind = 0;
+		for (uint32_t corner = 0; corner < 8; ++corner)
+		{
+			const glm::vec3 point(corner & 1 ? bounds.max.x : bounds.min.x, corner & 2 ? bounds.max.y : bounds.min.y, corner & 4 ? bounds.max.z : bounds.min.z);
+			const glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+			if (clip.w <= 0.0001f)
+			{
+				++behind;
+				continue;
+			}
+
+			const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+			ndcMin = glm::min(ndcMin, ndc);
+			ndcMax = glm::max(ndcMax, ndc);
+		}
+
+		if (behind == 8)
+			return 0.0f;
+		if (behind > 0)
+			return std::max(viewportWidth, viewportHeight);
+
+		ndcMin = glm::max(ndcMin, glm::vec2(-1.0f));
+		ndcMax = glm::min(ndcMax, glm::vec2(1.0f));
+		if (ndcMin.x >= ndcMax.x || ndcMin.y >= ndcMax.y)
+			return 0.0f;
+
+		return std::max((ndcMax.x - ndcMin.x) * 0.5f * viewportWidth, (ndcMax.y - ndcMin.y) * 0.5f * viewportHeight);
+	}
+
+	std::string TextureCachePath(const Asset::TextureInfo& textureInfo, const char* suffix)
+	{
+		return string_format("{0}/{1}{2}.sctex", COMPRESSED_TEXTURE_CACHE, HashPixels(textureInfo.data, textureInfo.pixelsize[0], textureInfo.pixelsize[1]), suffix);
+	}
+
+	bool WriteTextureCache(const std::string& cachePath, const CompressedTexture& texture)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(COMPRESSED_TEXTURE_CACHE, error);
+		if (WriteCompressedTexture(cachePath, texture))
+			return true;
+
+		Log::PrintCore(string_format("Failed to cache texture {0}", cachePath), LogSeverity::LogWarning);
+		return false;
+	}
+
+	//Reads the BC7 chain from the cache or compresses and caches it, cached is false when the file couldn't be written
+	CompressedTexture LoadCompressedTexture(const Asset::TextureInfo& textureInfo, ThreadPool* threadPool, const std::string& cachePath, bool& cached)
+	{
+		const uint32_t width = textureInfo.pixelsize[0];
+		const uint32_t height = textureInfo.pixelsize[1];
+
+		CompressedTexture compressed;
+		cached = true;
+		if (ReadCompressedTexture(cachePath, compressed) && compressed.format == Format::BC7_SRGB &&
+			compressed.width == width && compressed.height == height && compressed.levels.size() == MipLevelCount(width, height))
+			return compressed;
+
+		const MipChain mipChain = GenerateMipChain(textureInfo.data.data(), width, height, true);
+		compressed = CompressMipChain(mipChain, Format::BC7_SRGB, threadPool);
+		cached = WriteTextureCache(cachePath, compressed);
+		return compressed;
+	}
 }
 
-Scene::Scene()
+Scene::Scene() :
+	m_instanceCapacity(MIN_INSTANCE_CAPACITY),
+	m_instanceBufferVersion(0),
+	m_indirectDraws(false),
+	m_gpuCullingEnabled(false),
+	m_cullingDispatched(false),
+	m_frustumCulling(true),
+	m_textureStreaming(true),
+	m_bvhStructureVersion(std::numeric_limits<uint32_t>::max()),
+	m_bvhUpdateVersion(0)
 {
 	m_sceneUbo.Lights[0].position = glm::vec4(0.44f, 0.89f, 0.22f, 0);
 	m_sceneUbo.Lights[0].intensities = glm::vec4(1, 1, 1, 1.2f);
@@ -41,7 +151,7 @@ Scene::Scene()
 	m_sceneUbo.ViewMatrix = glm::mat4(1.0f);
 	m_sceneUbo.EyePos = glm::vec4(0.0f);
 
-	CreateSceneUniformBuffers();
+	CreateInstanceBuffer();
 }
 
 Scene::~Scene()
@@ -49,55 +159,411 @@ Scene::~Scene()
 	Reset();
 }
 
-void Scene::DrawObjects(Renderer* renderer,
-	std::function<void(const RenderObject& renderObject, bool pipelineChanged)> PerRenderObjectFunc)
+void Scene::Update(ThreadPool* threadPool)
+{
+	m_graph.Root().UpdateSelfAndChildren(threadPool);
+	SyncBvh(threadPool);
+}
+
+void Scene::UpdateTextureStreaming(uint32_t viewportWidth, uint32_t viewportHeight)
+{
+	//Render nodes of removed nodes are only dropped when the BVH is rebuilt, it also catches transforms updated without Update
+	SyncBvh(nullptr);
+
+	//Objects off screen don't request anything so their textures drop to the smallest levels after a while
+	for (uint32_t renderNode = 0; renderNode < m_renderNodes.size(); ++renderNode)
+	{
+		const Material* material = m_renderNodes[renderNode]->GetRenderObject().material;
+		if (!material)
+			continue;
+
+		const float screenSize = ScreenSize(m_renderBounds[renderNode], m_sceneUbo.ViewMatrix, static_cast<float>(viewportWidth), static_cast<float>(viewportHeight));
+		if (screenSize <= 0.0f)
+			continue;
+
+		for (const Texture* texture : material->textures)
+			m_textureStreamer.Request(texture, screenSize);
+	}
+
+	m_textureStreamer.Update();
+}
+
+void Scene::DispatchCulling(Renderer* renderer)
+{
+	CORE_ASSERT(renderer, "Renderer can't be null");
+	if (!m_gpuCullingEnabled)
+		return;
+
+	const uint8_t frameIndex = renderer->FrameDataIndex();
+
+	//Catches transforms that were updated without going through Update
+	SyncBvh(nullptr);
+
+	//Every object is batched, the shader leaves out the ones outside the frustum
+	const uint32_t objectCount = static_cast<uint32_t>(m_renderNodes.size());
+	CORE_ASSERT(objectCount <= m_instanceCapacity, "Culling buffers are too small for the render objects");
+	m_visibleNodes.resize(objectCount);
+	std::iota(m_visibleNodes.begin(), m_visibleNodes.end(), 0);
+
+	ScopedMapData mappedCommands = m_indirectBuffers.GetFrameData(frameIndex)->Map();
+	DrawIndexedIndirectCommand* commands = static_cast<DrawIndexedIndirectCommand*>(mappedCommands.Data());
+
+	//The frame fence has been waited on so the results of the last culling that used this frame's buffers can be read back
+	GpuCullingFrame& frame = m_gpuCullingFrames[frameIndex];
+	uint32_t visibleCount = 0;
+	for (uint32_t i = 0; i < frame.batches; ++i)
+	{
+		visibleCount += commands[i].instanceCount;
+	}
+	m_cullingStats.objects = frame.objects;
+	m_cullingStats.culled = frame.objects - visibleCount;
+	m_cullingStats.tested = frame.objects;
+
+	{
+		ScopedMapData mappedTransforms = m_objectTransformBuffers.GetFrameData(frameIndex)->Map();
+		BuildBatches(static_cast<glm::mat4*>(mappedTransforms.Data()));
+	}
+
+	ScopedMapData mappedObjects = m_cullObjectBuffers.GetFrameData(frameIndex)->Map();
+	GpuCulling::Object* objects = static_cast<GpuCulling::Object*>(mappedObjects.Data());
+
+	const std::vector<RenderQueue::Item>& items = m_renderQueue.Items();
+	for (uint32_t batch = 0; batch < static_cast<uint32_t>(m_batches.size()); ++batch)
+	{
+		const DrawBatch& drawBatch = m_batches[batch];
+		for (uint32_t instance = drawBatch.first; instance < drawBatch.first + drawBatch.count; ++instance)
+		{
+			const AABB& bounds = m_renderBounds[items[instance].object];
+			objects[instance] = GpuCulling::Object{ bounds.min, batch, bounds.max, 0 };
+		}
+
+		const Mesh* mesh = m_renderNodes[items[drawBatch.first].object]->GetRenderObject().mesh;
+		CORE_ASSERT(mesh, "Mesh can't be null");
+
+		DrawIndexedIndirectCommand& command = commands[batch];
+		command.indexCount = mesh->IndexCount();
+		command.instanceCount = 0;
+		command.firstIndex = mesh->firstIndex;
+		command.vertexOffset = mesh->vertexOffset;
+		command.firstInstance = drawBatch.first;
+	}
+
+	frame.objects = m_drawStats.instances;
+	frame.batches = static_cast<uint32_t>(m_batches.size());
+
+	const Frustum frustum = m_frustumCulling ? Frustum(m_sceneUbo.ViewMatrix) : Frustum();
+	m_gpuCulling->Dispatch(renderer->GetFrameCommandBuffer(), m_cullDescriptorSets.GetFrameData(frameIndex), frustum, m_drawStats.instances);
+	m_cullingDispatched = true;
+}
+
+void Scene::DrawObjects(Renderer* renderer, PerRenderObjectFunc perRenderObjectFunc)
 {
 	CORE_ASSERT(renderer, "Renderer can't be null");
+	if (!PrepareDraws(renderer))
+		return;
+
+	const IndirectCommands indirect = FrameIndirectCommands(renderer);
+
+	RecordBatches(renderer->GetFrameCommandBuffer(), 0, static_cast<uint32_t>(m_batches.size()), indirect, m_drawStats, perRenderObjectFunc);
+}
+
+void Scene::DrawObjectsParallel(Renderer* renderer, const Renderpass* renderPass, const RenderTarget* renderTarget, ThreadPool& threadPool,
+	PerRenderObjectFunc perRenderObjectFunc)
+{
+	CORE_ASSERT(renderer, "Renderer can't be null");
+	if (!PrepareDraws(renderer))
+		return;
+
+	const IndirectCommands indirect = FrameIndirectCommands(renderer);
+
+	//Contiguous chunks keep the sort order, each chunk only rebinds the state its first batch needs
+	const uint32_t batchCount = static_cast<uint32_t>(m_batches.size());
+	const uint32_t chunkCount = std::clamp(batchCount / MIN_BATCHES_PER_CHUNK, 1u, threadPool.ThreadCount());
+	renderer->ReserveSecondaryCommandBuffers(chunkCount);
+
+	m_chunkDrawStats.assign(chunkCount, DrawStats());
+	threadPool.ParallelFor(chunkCount, [&](uint32_t chunk)
+		{
+			const uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(batchCount) * chunk / chunkCount);
+			const uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(batchCount) * (chunk + 1) / chunkCount);
 
-	SC::CommandBuffer& commandBuffer = renderer->GetFrameCommandBuffer();
+			CommandBuffer& commandBuffer = renderer->GetFrameSecondaryCommandBuffer(chunk);
+			commandBuffer.BeginRecording(renderPass, renderTarget);
+			RecordBatches(commandBuffer, begin, end, indirect, m_chunkDrawStats[chunk], perRenderObjectFunc);
+			commandBuffer.EndRecording();
+		});
 
+	m_chunkCommandBuffers.clear();
+	for (uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+	{
+		const DrawStats& stats = m_chunkDrawStats[chunk];
+		m_drawStats.draws += stats.draws;
+		m_drawStats.drawCalls += stats.drawCalls;
+		m_drawStats.pipelineBinds += stats.pipelineBinds;
+		m_drawStats.materialBinds += stats.materialBinds;
+		m_drawStats.meshBinds += stats.meshBinds;
+		m_drawStats.commandsRecorded += stats.commandsRecorded;
+		m_drawStats.commandsFiltered += stats.commandsFiltered;
 
-	//update current frames scene ubo
-	UpdateSceneUniformBuffers(renderer->FrameDataIndex());
+		m_chunkCommandBuffers.push_back(&renderer->GetFrameSecondaryCommandBuffer(chunk));
+	}
 
-	PipelineLayout* lastLayout{ nullptr };
-	m_root.TraverseTree([=, &lastLayout, &commandBuffer](SceneNode& node)
+	renderer->GetFrameCommandBuffer().ExecuteCommands(m_chunkCommandBuffers.data(), chunkCount);
+}
+
+bool Scene::PrepareDraws(Renderer* renderer)
+{
+	if (!UpdateSceneUniforms(renderer))
+		return false;
+
+	if (m_gpuCullingEnabled)
+	{
+		//The batches and their commands were written by DispatchCulling
+		CORE_ASSERT(m_cullingDispatched, "DispatchCulling has to be called before DrawObjects when gpu culling is enabled");
+		if (!m_cullingDispatched)
+			return false;
+		m_cullingDispatched = false;
+	}
+	else
 	{
-		RenderObject& renderable = node.GetRenderObject();
+		//Catches transforms that were updated without going through Update
+		const uint32_t instanceBufferVersion = m_instanceBufferVersion;
+		SyncBvh(nullptr);
+
+		//The caller's descriptor sets still point at the old instance buffer, which is already queued for destruction, so
+		//drawing with them would read freed memory. Nothing is drawn until they are recreated
+		CORE_ASSERT(instanceBufferVersion == m_instanceBufferVersion, "Instance buffer grew while drawing, call Update after adding nodes");
+		if (instanceBufferVersion != m_instanceBufferVersion)
+		{
+			m_drawStats = DrawStats();
+			m_batches.clear();
+			return false;
+		}
+
+		CullObjects();
 
-		if (!renderable.mesh) return;
+		//Every visible object's transform goes in this frame's instance buffer in draw order, the vertex shader reads its
+		//transform with gl_InstanceIndex which starts at the draw's firstInstance
+		BuildBatches(static_cast<glm::mat4*>(m_instanceBuffer.GetFrameData(renderer->FrameDataIndex())));
+	}
 
-		auto* material = renderable.material;
-		bool pipelineChanged = !lastLayout;
-		if (material)
+	return !m_batches.empty();
+}
+
+Scene::IndirectCommands Scene::FrameIndirectCommands(Renderer* renderer)
+{
+	IndirectCommands indirect;
+	if (m_gpuCullingEnabled)
+	{
+		//Gpu culling always draws indirectly since only the GPU knows the instance counts
+		indirect.buffer = m_indirectBuffers.GetFrameData(renderer->FrameDataIndex());
+	}
+	else if (m_indirectDraws && renderer->SupportsMultiDrawIndirect())
+	{
+		//The commands only live for this frame, when the frame allocator is full the batches are drawn directly instead
+		const FrameAllocation allocation = renderer->GetFrameAllocator().Allocate<DrawIndexedIndirectCommand>(m_batches.size());
+		if (allocation.IsValid())
 		{
-			auto forwardEffect = material->original->passShaders[MeshpassType::Forward];
-			pipelineChanged |= lastLayout != forwardEffect->GetShaderEffect()->GetPipelineLayout();
+			indirect.buffer = allocation.buffer;
+			indirect.offset = allocation.offset;
+			indirect.commands = static_cast<DrawIndexedIndirectCommand*>(allocation.data);
+		}
+	}
+	return indirect;
+}
 
-			if (pipelineChanged)
-				commandBuffer.BindPipeline(forwardEffect->GetPipeline());
+void Scene::RecordBatches(CommandBuffer& commandBuffer, uint32_t begin, uint32_t end, const IndirectCommands& indirect,
+	DrawStats& stats, PerRenderObjectFunc perRenderObjectFunc)
+{
+	//In indirect mode consecutive commands that share the pipeline, material and geometry buffers are submitted together
+	//with one indirect draw
+	const bool indirectDraws = indirect.buffer != nullptr;
+	uint32_t runBegin = begin;
+	const CommandBufferStats commandStatsBegin = commandBuffer.GetStats();
+
+	const auto SubmitRun = [&](uint32_t runEnd)
+	{
+		if (runBegin == runEnd) return;
+		commandBuffer.DrawIndexedIndirect(indirect.buffer, indirect.offset + runBegin * sizeof(DrawIndexedIndirectCommand), runEnd - runBegin);
+		++stats.drawCalls;
+		runBegin = runEnd;
+	};
+
+	const std::vector<RenderQueue::Item>& items = m_renderQueue.Items();
+	const Pipeline* lastPipeline{ nullptr };
+	const Material* lastMaterial{ nullptr };
+	const Buffer* lastVertexBuffer{ nullptr };
+	const Buffer* lastIndexBuffer{ nullptr };
+	for (uint32_t i = begin; i < end; ++i)
+	{
+		const DrawBatch& batch = m_batches[i];
+		const RenderObject& renderable = m_renderNodes[items[batch.first].object]->GetRenderObject();
+		const Material* material = renderable.material;
+		const Mesh* mesh = renderable.mesh;
+
+		//Nothing is bound at the start of a command buffer
+		const bool first = i == begin;
+		const ShaderPass* forwardPass = material ? material->original->passShaders[MeshpassType::Forward] : nullptr;
+		const Pipeline* pipeline = forwardPass ? forwardPass->GetPipeline() : lastPipeline;
+
+		CORE_ASSERT(mesh, "Mesh can't be null");
+		Buffer* vertexBuffer = mesh->GetVertexBuffer();
+		Buffer* indexBuffer = mesh->GetIndexBuffer();
+		CORE_ASSERT(vertexBuffer, "Mesh vertex buffer can't be null, is it built?");
+		CORE_ASSERT(indexBuffer, "Mesh index buffer can't be null, is it built?");
+
+		const bool pipelineChanged = first || pipeline != lastPipeline;
+		const bool materialChanged = pipelineChanged || material != lastMaterial;
+		//Meshes in the geometry pool share buffers so this only changes for meshes that didn't fit in it
+		const bool geometryChanged = first || vertexBuffer != lastVertexBuffer || indexBuffer != lastIndexBuffer;
 
-			lastLayout = forwardEffect->GetShaderEffect()->GetPipelineLayout();
+		//Pending indirect commands have to be submitted with the state they were written for
+		if (indirectDraws && (materialChanged || geometryChanged))
+			SubmitRun(i);
+
+		if (pipelineChanged && pipeline)
+		{
+			commandBuffer.BindPipeline(pipeline);
+			++stats.pipelineBinds;
 		}
 
-		CORE_ASSERT(renderable.mesh, "Mesh can't be null");
-		CORE_ASSERT(renderable.mesh->vertexBuffer, "Mesh vertex buffer can't be null, is it built?");
-		CORE_ASSERT(renderable.mesh->vertexBuffer, "Mesh index buffer can't be null, is it built?");
+		stats.materialBinds += materialChanged;
 
-		commandBuffer.BindVertexBuffer(renderable.mesh->vertexBuffer.get());
-		commandBuffer.BindIndexBuffer(renderable.mesh->indexBuffer.get());
+		if (geometryChanged)
+		{
+			commandBuffer.BindVertexBuffer(vertexBuffer);
+			commandBuffer.BindIndexBuffer(indexBuffer);
+			++stats.meshBinds;
+		}
 
-		PerRenderObjectFunc(renderable, pipelineChanged);
+		if (indirectDraws)
+		{
+			if (materialChanged || geometryChanged)
+				perRenderObjectFunc(commandBuffer, renderable, pipelineChanged, materialChanged);
 
-		commandBuffer.DrawIndexed(renderable.mesh->IndexCount(), 1, 0, 0, 0);
-	});
+			if (indirect.commands)
+			{
+				DrawIndexedIndirectCommand& command = indirect.commands[i];
+				command.indexCount = mesh->IndexCount();
+				command.instanceCount = batch.count;
+				command.firstIndex = mesh->firstIndex;
+				command.vertexOffset = mesh->vertexOffset;
+				command.firstInstance = batch.first;
+			}
+		}
+		else
+		{
+			perRenderObjectFunc(commandBuffer, renderable, pipelineChanged, materialChanged);
+
+			commandBuffer.DrawIndexed(mesh->IndexCount(), batch.count, mesh->firstIndex, mesh->vertexOffset, batch.first);
+			++stats.drawCalls;
+		}
+		++stats.draws;
+
+		lastPipeline = pipeline;
+		lastMaterial = material;
+		lastVertexBuffer = vertexBuffer;
+		lastIndexBuffer = indexBuffer;
+	}
+
+	if (indirectDraws)
+		SubmitRun(end);
+
+	stats.commandsRecorded += commandBuffer.GetStats().recorded - commandStatsBegin.recorded;
+	stats.commandsFiltered += commandBuffer.GetStats().filtered - commandStatsBegin.filtered;
+}
+
+void Scene::CullObjects()
+{
+	const uint32_t objectCount = static_cast<uint32_t>(m_renderNodes.size());
+	m_cullingStats.objects = objectCount;
+	m_cullingStats.tested = 0;
+
+	if (!m_frustumCulling)
+	{
+		m_visibleNodes.resize(objectCount);
+		std::iota(m_visibleNodes.begin(), m_visibleNodes.end(), 0);
+	}
+	else if (objectCount >= BVH_CULLING_MIN_OBJECTS)
+	{
+		m_visibleNodes.clear();
+		m_cullingStats.tested = m_bvh.Query(Frustum(m_sceneUbo.ViewMatrix), m_visibleNodes);
+
+		//Render nodes are in traversal order, sorting keeps the draw order the same as without culling
+		std::sort(m_visibleNodes.begin(), m_visibleNodes.end());
+	}
+	else
+	{
+		m_visibleNodes.resize(objectCount);
+		m_visibleNodes.resize(Frustum(m_sceneUbo.ViewMatrix).Cull(m_renderBoundsArrays, m_visibleNodes.data()));
+		m_cullingStats.tested = objectCount;
+	}
+
+	m_cullingStats.culled = objectCount - static_cast<uint32_t>(m_visibleNodes.size());
+}
+
+void Scene::BuildBatches(glm::mat4* instanceTransforms)
+{
+	//Sort the visible objects by state so each pipeline, material and mesh is bound once per run of objects using it
+	const glm::vec3 eyePosition = glm::vec3(m_sceneUbo.EyePos);
+	m_renderQueue.Clear();
+	for (uint32_t renderNode : m_visibleNodes)
+	{
+		const RenderObject& renderable = m_renderNodes[renderNode]->GetRenderObject();
+		const ShaderPass* forwardPass = renderable.material ? renderable.material->original->passShaders[MeshpassType::Forward] : nullptr;
+
+		const uint64_t key = RenderQueue::MakeKey(MeshpassType::Forward,
+			m_renderQueue.SortId(forwardPass ? forwardPass->GetPipeline() : nullptr),
+			m_renderQueue.SortId(renderable.material),
+			m_renderQueue.SortId(renderable.mesh),
+			glm::distance(eyePosition, m_renderBounds[renderNode].Center()));
+		m_renderQueue.Add(key, renderNode);
+	}
+	m_renderQueue.Sort();
+
+	//The instance buffer always has room for every render object, see ReserveInstances
+	const std::vector<RenderQueue::Item>& items = m_renderQueue.Items();
+	const uint32_t instanceCount = static_cast<uint32_t>(items.size());
+	CORE_ASSERT(instanceCount <= m_instanceCapacity, "Instance buffer is too small for the visible objects");
+
+	m_drawStats = DrawStats();
+	m_drawStats.instances = instanceCount;
+
+	m_batches.clear();
+	for (uint32_t batchBegin = 0; batchBegin < instanceCount;)
+	{
+		const RenderObject& renderable = m_renderNodes[items[batchBegin].object]->GetRenderObject();
+
+		//Objects are sorted by material then mesh, so each run sharing both becomes one instanced draw
+		uint32_t batchEnd = batchBegin + 1;
+		while (batchEnd < instanceCount)
+		{
+			const RenderObject& next = m_renderNodes[items[batchEnd].object]->GetRenderObject();
+			if (next.material != renderable.material || next.mesh != renderable.mesh) break;
+			++batchEnd;
+		}
+
+		for (uint32_t instance = batchBegin; instance < batchEnd; ++instance)
+		{
+			SceneNode& node = *m_renderNodes[items[instance].object];
+
+			//World matrices live in the scene's transform hierarchy and can move when nodes are added/removed, so refresh the pointer each draw
+			node.GetRenderObject().transform = &node.ModelMatrix();
+			instanceTransforms[instance] = node.ModelMatrix();
+		}
+
+		m_batches.push_back({ batchBegin, batchEnd - batchBegin });
+		batchBegin = batchEnd;
+	}
 }
 
 void Scene::Reset()
 {
-	m_root.Remove();
+	m_graph.Root().Remove();
 
 	m_meshes.clear();
+	m_renderQueue.ResetSortIds();
+	m_batches.clear();
 
 	m_loadedModels.clear();
 	m_loadedMaterial.clear();
@@ -106,23 +572,61 @@ void Scene::Reset()
 
 SceneNode& Scene::Root()
 {
-	return m_root;
+	return m_graph.Root();
 }
 
-SceneNode* Scene::LoadModel(const std::string& path, MaterialSystem* materialSystem)
+SceneNode* Scene::LoadModel(const std::string& path, MaterialSystem* materialSystem, bool keepGeometry, ThreadPool* threadPool)
 {
-	//SceneNode sceneNode;
-	std::shared_ptr<SceneNode> modelRoot = m_root.AddChild();
+	SceneNode* modelRoot = &m_graph.Root().AddChild();
 
 	gTextureManager.SetOnLoadCallback([=](const Asset::TextureInfo& textureInfo, auto& userData)
 		{
+			//BC7 is a quarter of the size of RGBA8 so it takes less memory and bandwidth to sample
+			if (App::Instance()->GetRenderer()->SupportsBlockCompression())
+			{
+				const std::string cachePath = TextureCachePath(textureInfo, "");
+				bool cached = false;
+				CompressedTexture compressed = LoadCompressedTexture(textureInfo, threadPool, cachePath, cached);
+				userData.texture = SC::Texture::Create(SC::TextureType::TEXTURE2D, SC::TextureUsage::COLOUR, compressed.format);
+				//Streamed levels are read back from the cache, without it the texture is loaded whole
+				if (m_textureStreaming && cached)
+				{
+					userData.texture->BuildStreamed(compressed.width, compressed.height);
+					m_textureStreamer.Add(userData.texture.get(), cachePath, compressed.data);
+					return;
+				}
+
+				userData.texture->Build(compressed.width, compressed.height, true);
+				userData.texture->CopyData(compressed.data.data(), compressed.data.size(), static_cast<uint32_t>(compressed.levels.size()));
+				return;
+			}
+
 			userData.texture = SC::Texture::Create(SC::TextureType::TEXTURE2D, SC::TextureUsage::COLOUR, SC::Format::R8G8B8A8_SRGB);
+
+			//The whole chain is built on the loading thread and uploaded by one copy instead of blitting each level on the GPU
+			MipChain mipChain = GenerateMipChain(textureInfo.data.data(), textureInfo.pixelsize[0], textureInfo.pixelsize[1], true);
+			if (m_textureStreaming)
+			{
+				//Generating the chain is quick, it is only cached so the streamer can read levels back
+				const std::string cachePath = TextureCachePath(textureInfo, "_rgba");
+				CompressedTexture cache{ SC::Format::R8G8B8A8_SRGB, textureInfo.pixelsize[0], textureInfo.pixelsize[1], std::move(mipChain.pixels), std::move(mipChain.levels) };
+				if (WriteTextureCache(cachePath, cache))
+				{
+					userData.texture->BuildStreamed(cache.width, cache.height);
+					m_textureStreamer.Add(userData.texture.get(), cachePath, cache.data);
+					return;
+				}
+
+				mipChain = { std::move(cache.data), std::move(cache.levels) };
+			}
+
 			userData.texture->Build(textureInfo.pixelsize[0], textureInfo.pixelsize[1], true);
-			userData.texture->CopyData(textureInfo.data.data(), textureInfo.data.size());
+			userData.texture->CopyData(mipChain.pixels.data(), mipChain.pixels.size(), static_cast<uint32_t>(mipChain.levels.size()));
 		});
 
 	gTextureManager.SetOnUnloadCallback([=](auto& userData)
 		{
+			m_textureStreamer.Remove(userData.texture.get());
 			userData.texture.reset();
 		});
 
@@ -217,12 +721,15 @@ SceneNode* Scene::LoadModel(const std::string& path, MaterialSystem* materialSys
 
 				mesh->Build();
 
-				mesh->vertices.resize(0);
+				if (keepGeometry)
+					mesh->BuildTriangleBvh();
+				else
+					mesh->vertices.resize(0);
 			}
 
-			std::shared_ptr<SceneNode> child = modelRoot->AddChild();
-			child->GetRenderObject().mesh = mesh.get();
-			child->GetRenderObject().transform = &child->ModelMatrix();
+			SceneNode& child = modelRoot->AddChild();
+			child.GetRenderObject().mesh = mesh.get();
+			child.SetLocalBounds(mesh->bounds);
 
 			//also load mat
 			auto matHandle = gMaterialManager.Load(modelInfo.meshMaterials.at(i));
@@ -231,7 +738,7 @@ SceneNode* Scene::LoadModel(const std::string& path, MaterialSystem* materialSys
 			CORE_ASSERT(mat, "Failed to get mat user data");
 			CORE_ASSERT(mat->material, "Material is null");
 
-			child->GetRenderObject().material = mat->material.get();
+			child.GetRenderObject().material = mat->material.get();
 			m_loadedMaterial.insert(matHandle);
 		}
 		});
@@ -250,32 +757,340 @@ SceneNode* Scene::LoadModel(const std::string& path, MaterialSystem* materialSys
 	if (m_loadedModels.find(modelHandle) == m_loadedModels.end())
 		m_loadedModels.insert(modelHandle);
 
+	return modelRoot;
+}
 
-	std::map<uint64_t, std::vector<uint64_t>> nodeChildren;
+bool Scene::UpdateSceneUniforms(Renderer* renderer)
+{
+	//Only lives for this frame so it is rewritten every frame rather than kept in a buffer of its own
+	m_sceneUniforms = renderer->GetFrameAllocator().Allocate(sizeof(SceneUbo), renderer->UniformBufferAlignment());
+	CORE_ASSERT(m_sceneUniforms.IsValid(), "Frame allocator is full, the scene uniforms don't fit");
+	if (!m_sceneUniforms.IsValid())
+		return false;
 
-	return modelRoot.get();
+	memcpy(m_sceneUniforms.data, &m_sceneUbo, sizeof(SceneUbo));
+	return true;
 }
 
-void Scene::CreateSceneUniformBuffers()
+const FrameAllocation& Scene::GetSceneUniforms() const
 {
-	SC::BufferUsageSet uboUsage;
-	uboUsage.set(SC::BufferUsage::UNIFORM_BUFFER);
-	uboUsage.set(SC::BufferUsage::MAP);
-	m_sceneUniformBuffers = SC::FrameData<SC::Buffer>::Create(sizeof(SceneUbo), uboUsage, SC::AllocationUsage::HOST);
+	return m_sceneUniforms;
 }
 
-void Scene::UpdateSceneUniformBuffers(uint8_t frameDataIndex)
+void Scene::CreateInstanceBuffer()
 {
-	auto mappedData = m_sceneUniformBuffers.GetFrameData(frameDataIndex)->Map();
-	memcpy(mappedData.Data(), &m_sceneUbo, sizeof(SceneUbo));
+	SC::BufferUsageSet instanceUsage;
+	instanceUsage.set(SC::BufferUsage::STORAGE_BUFFER);
+	instanceUsage.set(SC::BufferUsage::MAP);
+	m_instanceBuffer = PerFrameBuffer(sizeof(glm::mat4) * m_instanceCapacity, instanceUsage);
 }
 
-Buffer* Scene::GetSceneUniformBuffer(uint8_t frameDataIndex)
+void Scene::ReserveInstances(uint32_t count)
 {
-	return m_sceneUniformBuffers.GetFrameData(frameDataIndex);
+	if (count <= m_instanceCapacity)
+		return;
+
+	//Doubling keeps the number of reallocations low while a scene is filled, the old buffer is only destroyed once the
+	//frames using it have retired
+	m_instanceCapacity = std::max(count, m_instanceCapacity * 2);
+	CreateInstanceBuffer();
+	++m_instanceBufferVersion;
+
+	//Culling batches every render object so its buffers grow with the instance buffer. The sets of frames in flight can't
+	//be updated, new ones are made that point at the new buffers
+	if (m_gpuCulling)
+		CreateCullingBuffers();
+
+	Log::PrintCore(string_format("Instance buffer grown to {0} objects", m_instanceCapacity));
+}
+
+const PerFrameBuffer& Scene::GetInstanceBuffer() const
+{
+	return m_instanceBuffer;
+}
+
+uint32_t Scene::GetInstanceBufferVersion() const
+{
+	return m_instanceBufferVersion;
+}
+
+void Scene::CreateIndirectBuffers()
+{
+	SC::BufferUsageSet indirectUsage;
+	indirectUsage.set(SC::BufferUsage::INDIRECT_BUFFER);
+	indirectUsage.set(SC::BufferUsage::STORAGE_BUFFER);
+	indirectUsage.set(SC::BufferUsage::MAP);
+	m_indirectBuffers = SC::FrameData<SC::Buffer>::Create(sizeof(DrawIndexedIndirectCommand) * m_instanceCapacity, indirectUsage, SC::AllocationUsage::HOST);
+}
+
+bool Scene::InitGpuCulling(const std::string& cullShaderPath)
+{
+	//Each batch's indirect command is drawn from its own firstInstance
+	if (!App::Instance()->GetRenderer()->SupportsMultiDrawIndirect())
+	{
+		Log::PrintCore("Gpu culling needs multi draw indirect and draw indirect first instance", LogSeverity::LogWarning);
+		return false;
+	}
+
+	std::unique_ptr<GpuCulling> gpuCulling = std::make_unique<GpuCulling>();
+	if (!gpuCulling->Init(cullShaderPath))
+		return false;
+
+	m_gpuCulling = std::move(gpuCulling);
+	CreateCullingBuffers();
+	return true;
+}
+
+void Scene::CreateCullingBuffers()
+{
+	CreateIndirectBuffers();
+
+	SC::BufferUsageSet cullUsage;
+	cullUsage.set(SC::BufferUsage::STORAGE_BUFFER);
+	cullUsage.set(SC::BufferUsage::MAP);
+	m_cullObjectBuffers = SC::FrameData<SC::Buffer>::Create(sizeof(GpuCulling::Object) * m_instanceCapacity, cullUsage, SC::AllocationUsage::HOST);
+	m_objectTransformBuffers = SC::FrameData<SC::Buffer>::Create(sizeof(glm::mat4) * m_instanceCapacity, cullUsage, SC::AllocationUsage::HOST);
+
+	CreateCullingDescriptorSets();
+
+	//The new indirect buffers haven't been culled into yet so there is nothing to read back
+	m_gpuCullingFrames.assign(m_cullDescriptorSets.FrameCount(), GpuCullingFrame());
+}
+
+void Scene::CreateCullingDescriptorSets()
+{
+	m_cullDescriptorSets = SC::FrameData<SC::DescriptorSet>::Create(m_gpuCulling->SetLayout());
+	for (uint8_t i = 0; i < m_cullDescriptorSets.FrameCount(); ++i)
+	{
+		DescriptorSet* descriptorSet = m_cullDescriptorSets.GetFrameData(i);
+		descriptorSet->SetBuffer(m_cullObjectBuffers.GetFrameData(i), GpuCulling::OBJECTS);
+		descriptorSet->SetBuffer(m_objectTransformBuffers.GetFrameData(i), GpuCulling::TRANSFORMS);
+		descriptorSet->SetBuffer(m_instanceBuffer.GetBuffer(), GpuCulling::INSTANCES, m_instanceBuffer.FrameOffset(i), m_instanceBuffer.Size());
+		descriptorSet->SetBuffer(m_indirectBuffers.GetFrameData(i), GpuCulling::COMMANDS);
+	}
+}
+
+void Scene::SetGpuCulling(bool enabled)
+{
+	CORE_ASSERT(!enabled || m_gpuCulling, "InitGpuCulling has to succeed before gpu culling can be enabled");
+	m_gpuCullingEnabled = enabled && m_gpuCulling;
+	m_cullingDispatched = false;
+
+	//The indirect buffers may have been written by the CPU since, there is nothing to read back until they are culled again
+	m_gpuCullingFrames.assign(m_gpuCullingFrames.size(), GpuCullingFrame());
+}
+
+bool Scene::GpuCullingEnabled() const
+{
+	return m_gpuCullingEnabled;
 }
 
 SceneUbo& Scene::GetSceneData()
 {
 	return m_sceneUbo;
 }
+
+void Scene::SetTextureStreaming(bool enabled)
+{
+	m_textureStreaming = enabled;
+}
+
+bool Scene::TextureStreamingEnabled() const
+{
+	return m_textureStreaming;
+}
+
+TextureStreamer& Scene::GetTextureStreamer()
+{
+	return m_textureStreamer;
+}
+
+void Scene::SetFrustumCulling(bool enabled)
+{
+	m_frustumCulling = enabled;
+}
+
+bool Scene::FrustumCullingEnabled() const
+{
+	return m_frustumCulling;
+}
+
+void Scene::SetIndirectDraws(bool enabled)
+{
+	m_indirectDraws = enabled;
+}
+
+bool Scene::IndirectDrawsEnabled() const
+{
+	return m_indirectDraws;
+}
+
+const CullingStats& Scene::GetCullingStats() const
+{
+	return m_cullingStats;
+}
+
+const DrawStats& Scene::GetDrawStats() const
+{
+	return m_drawStats;
+}
+
+const BVH& Scene::GetBvh() const
+{
+	return m_bvh;
+}
+
+const std::vector<SceneNode*>& Scene::GetRenderNodes() const
+{
+	return m_renderNodes;
+}
+
+void Scene::SyncBvh(ThreadPool* threadPool)
+{
+	const TransformHierarchy& hierarchy = m_graph.Hierarchy();
+	if (hierarchy.StructureVersion() != m_bvhStructureVersion)
+	{
+		RebuildBvh(threadPool);
+	}
+	else if (hierarchy.UpdateVersion() == m_bvhUpdateVersion + 1)
+	{
+		//A single update since the last sync, so its ranges contain every node that moved
+		m_refitNodes.clear();
+		for (const auto& [begin, end] : hierarchy.UpdatedRanges())
+		{
+			for (uint32_t index = begin; index < end; ++index)
+			{
+				const TransformHierarchy::NodeId id = hierarchy.IdAt(index);
+				if (id >= m_renderNodeOfId.size() || m_renderNodeOfId[id] == BVH::INVALID_INDEX) continue;
+
+				const uint32_t renderNode = m_renderNodeOfId[id];
+				SetRenderBounds(renderNode, m_renderNodes[renderNode]->WorldBounds());
+				m_refitNodes.push_back(renderNode);
+			}
+		}
+
+		m_bvh.Refit(m_renderBounds.data(), m_refitNodes.data(), static_cast<uint32_t>(m_refitNodes.size()));
+	}
+	else if (hierarchy.UpdateVersion() != m_bvhUpdateVersion)
+	{
+		//Missed updates, anything could have moved
+		for (uint32_t renderNode = 0; renderNode < m_renderNodes.size(); ++renderNode)
+		{
+			SetRenderBounds(renderNode, m_renderNodes[renderNode]->WorldBounds());
+		}
+
+		m_bvh.Refit(m_renderBounds.data());
+	}
+
+	m_bvhUpdateVersion = hierarchy.UpdateVersion();
+}
+
+void Scene::RebuildBvh(ThreadPool* threadPool)
+{
+	m_renderNodes.clear();
+	m_renderBounds.clear();
+	m_renderBoundsArrays.Clear();
+	std::fill(m_renderNodeOfId.begin(), m_renderNodeOfId.end(), BVH::INVALID_INDEX);
+
+	m_graph.Root().TraverseTree([&](SceneNode& node)
+	{
+		if (!node.GetRenderObject().mesh) return;
+
+		if (node.Id() >= m_renderNodeOfId.size())
+			m_renderNodeOfId.resize(node.Id() + 1, BVH::INVALID_INDEX);
+		m_renderNodeOfId[node.Id()] = static_cast<uint32_t>(m_renderNodes.size());
+
+		const AABB bounds = node.WorldBounds();
+		m_renderNodes.push_back(&node);
+		m_renderBounds.push_back(bounds);
+		m_renderBoundsArrays.Add(bounds);
+	});
+
+	m_bvh.Build(m_renderBounds.data(), static_cast<uint32_t>(m_renderBounds.size()), threadPool);
+
+	//Every render object could be visible at once
+	ReserveInstances(static_cast<uint32_t>(m_renderNodes.size()));
+
+	m_bvhStructureVersion = m_graph.Hierarchy().StructureVersion();
+}
+
+void Scene::SetRenderBounds(uint32_t renderNode, const AABB& bounds)
+{
+	m_renderBounds[renderNode] = bounds;
+	m_renderBoundsArrays.Set(renderNode, bounds);
+}
+
+bool Scene::Raycast(const Ray& ray, RaycastHit& hit, float maxDistance)
+{
+	SyncBvh(nullptr);
+
+	bool found = false;
+	m_bvh.Raycast(ray, maxDistance, [&](uint32_t renderNode, float currentMaxDistance)
+	{
+		if (!RaycastObject(renderNode, ray, currentMaxDistance, hit))
+			return currentMaxDistance;
+
+		found = true;
+		return hit.distance;
+	});
+
+	return found;
+}
+
+uint32_t Scene::RaycastAll(const Ray& ray, std::vector<RaycastHit>& hits, float maxDistance)
+{
+	SyncBvh(nullptr);
+
+	hits.clear();
+	m_bvh.Raycast(ray, maxDistance, [&](uint32_t renderNode, float currentMaxDistance)
+	{
+		RaycastHit hit;
+		if (RaycastObject(renderNode, ray, currentMaxDistance, hit))
+			hits.push_back(hit);
+		return currentMaxDistance;
+	});
+
+	std::sort(hits.begin(), hits.end(), [](const RaycastHit& a, const RaycastHit& b) { return a.distance < b.distance; });
+	return static_cast<uint32_t>(hits.size());
+}
+
+bool Scene::RaycastObject(uint32_t renderNode, const Ray& ray, float maxDistance, RaycastHit& hit)
+{
+	SceneNode& node = *m_renderNodes[renderNode];
+	const Mesh* mesh = node.GetRenderObject().mesh;
+
+	if (!mesh->HasGeometry())
+	{
+		//The BVH already found the ray hits these bounds but not how far along
+		const float distance = IntersectRayAABB(ray.origin, 1.0f / ray.direction, m_renderBounds[renderNode], maxDistance);
+		if (distance < 0.0f) return false;
+
+		hit.node = &node;
+		hit.distance = distance;
+		hit.point = ray.At(distance);
+		hit.normal = -glm::normalize(ray.direction);
+		hit.triangle = std::numeric_limits<uint32_t>::max();
+		return true;
+	}
+
+	//Transforming the ray into the mesh's space keeps distances along it the same
+	const glm::mat4& world = node.ModelMatrix();
+	float distance;
+	uint32_t triangle;
+	if (!mesh->Raycast(ray.Transformed(glm::inverse(world)), maxDistance, distance, triangle))
+		return false;
+
+	glm::vec3 v0, v1, v2;
+	mesh->Triangle(triangle, v0, v1, v2);
+	v0 = glm::vec3(world * glm::vec4(v0, 1.0f));
+	v1 = glm::vec3(world * glm::vec4(v1, 1.0f));
+	v2 = glm::vec3(world * glm::vec4(v2, 1.0f));
+	const glm::vec3 normal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
+
+	hit.node = &node;
+	hit.distance = distance;
+	hit.point = ray.At(distance);
+	hit.normal = glm::dot(normal, ray.direction) > 0.0f ? -normal : normal;
+	hit.triangle = triangle;
+	return true;
+}
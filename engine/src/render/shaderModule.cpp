@@ -16,12 +16,26 @@ ShaderModuleBuilder& ShaderModuleBuilder::SetFragmentModulePath(const std::strin
 	return *this;
 }
 
+ShaderModuleBuilder& ShaderModuleBuilder::SetComputeModulePath(const std::string& path)
+{
+	m_computeModulePath = path;
+	return *this;
+}
+
 std::unique_ptr<ShaderModule> ShaderModuleBuilder::Build()
 {
 	std::unique_ptr<ShaderModule> shader = std::unique_ptr<ShaderModule>(new ShaderModule());
 	
 	//TODO multithread reads
 	bool result = false;
+	if (!m_computeModulePath.empty())
+	{
+		CORE_ASSERT(m_vertexModulePath.empty() && m_fragmentModulePath.empty(), "Compute modules can't be combined with graphics modules");
+		result = shader->LoadModule(ShaderStage::COMPUTE, m_computeModulePath);
+		CORE_ASSERT(result, string_format("Failed to load compute module: {0}", m_computeModulePath.c_str()));
+		return std::move(shader);
+	}
+
 	if (!m_vertexModulePath.empty())
 		result = shader->LoadModule(ShaderStage::VERTEX, m_vertexModulePath);
 	CORE_ASSERT(result, string_format("Failed to load vertex module: {0}", m_vertexModulePath.c_str()));
@@ -77,3 +91,8 @@ const ShaderBufferType& ShaderModule::GetModule(ShaderStage stage) const
 {
 	return m_modules.at(to_underlying(stage));
 }
+
+bool ShaderModule::IsCompute() const
+{
+	return !GetModule(ShaderStage::COMPUTE).empty();
+}
@@ -22,7 +22,11 @@ Texture::Texture(TextureType type, TextureUsage usage, Format format) :
 	m_usage(usage),
 	m_format(format),
 	m_width(0),
-	m_height(0)
+	m_height(0),
+	m_mipLevels(0),
+	m_residentMip(0),
+	m_streamed(false),
+	m_imageVersion(0)
 {
 
 }
@@ -53,6 +57,36 @@ Format Texture::GetFormat() const
 	return m_format;
 }
 
+uint32_t Texture::GetWidth() const
+{
+	return m_width;
+}
+
+uint32_t Texture::GetHeight() const
+{
+	return m_height;
+}
+
+uint32_t Texture::GetMipLevelCount() const
+{
+	return m_mipLevels;
+}
+
+uint32_t Texture::GetResidentMip() const
+{
+	return m_residentMip;
+}
+
+bool Texture::IsStreamed() const
+{
+	return m_streamed;
+}
+
+uint32_t Texture::GetImageVersion() const
+{
+	return m_imageVersion;
+}
+
 
 std::unique_ptr<SC::RenderTarget> RenderTarget::Create(std::vector<Format>&& attachmentFormats, uint32_t width, uint32_t height)
 {
@@ -0,0 +1,517 @@
+#include "pch.h"
+#include "render/textureCompression.h"
+#include "core/threadPool.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+using namespace SC;
+
+namespace
+{
+	constexpr uint32_t CHANNELS = 4;
+	constexpr uint32_t BLOCK_DIM = 4;
+	constexpr uint32_t BLOCK_TEXELS = BLOCK_DIM * BLOCK_DIM;
+
+	constexpr uint32_t FILE_MAGIC = 0x58544353; //"SCTX"
+	constexpr uint32_t FILE_VERSION = 1;
+
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t levelCount;
+		uint64_t dataSize;
+	};
+
+	//BC7 mode 6 interpolation weights of the 4 bit indices, out of 64
+	constexpr std::array<int, 16> BC7_WEIGHTS = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	using Block = std::array<std::array<uint8_t, CHANNELS>, BLOCK_TEXELS>;
+
+	Block LoadBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY)
+	{
+		Block block;
+		for (uint32_t y = 0; y < BLOCK_DIM; ++y)
+		{
+			const uint32_t texelY = std::min(blockY * BLOCK_DIM + y, height - 1);
+			for (uint32_t x = 0; x < BLOCK_DIM; ++x)
+			{
+				const uint32_t texelX = std::min(blockX * BLOCK_DIM + x, width - 1);
+				memcpy(block[y * BLOCK_DIM + x].data(), pixels + (static_cast<size_t>(texelY) * width + texelX) * CHANNELS, CHANNELS);
+			}
+		}
+		return block;
+	}
+
+	//Mean and direction of largest variance of the first channelCount channels, found by power iteration on the covariance
+	void PrincipalAxis(const Block& block, uint32_t channelCount, std::array<float, CHANNELS>& mean, std::array<float, CHANNELS>& axis)
+	{
+		mean.fill(0.0f);
+		for (const auto& texel : block)
+			for (uint32_t c = 0; c < channelCount; ++c)
+				mean[c] += texel[c];
+		for (uint32_t c = 0; c < channelCount; ++c)
+			mean[c] /= BLOCK_TEXELS;
+
+		float covariance[CHANNELS][CHANNELS] = {};
+		for (const auto& texel : block)
+		{
+			for (uint32_t i = 0; i < channelCount; ++i)
+				for (uint32_t j = 0; j < channelCount; ++j)
+					covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+		}
+
+		axis.fill(0.0f);
+		for (uint32_t c = 0; c < channelCount; ++c)
+			axis[c] = 1.0f;
+
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			std::array<float, CHANNELS> next{};
+			float length = 0.0f;
+			for (uint32_t i = 0; i < channelCount; ++i)
+			{
+				for (uint32_t j = 0; j < channelCount; ++j)
+					next[i] += covariance[i][j] * axis[j];
+				length = std::max(length, std::abs(next[i]));
+			}
+
+			//Flat blocks have no variance, any axis works
+			if (length == 0.0f)
+				return;
+
+			for (uint32_t c = 0; c < channelCount; ++c)
+				axis[c] = next[c] / length;
+		}
+	}
+
+	//Texels projected onto the principal axis give the endpoints, both are moved in by 1/16 of the range as the extremes
+	//are rarely worth an index of their own
+	void AxisEndpoints(const Block& block, uint32_t channelCount, std::array<float, CHANNELS>& low, std::array<float, CHANNELS>& high)
+	{
+		std::array<float, CHANNELS> mean;
+		std::array<float, CHANNELS> axis;
+		PrincipalAxis(block, channelCount, mean, axis);
+
+		float minProjection = std::numeric_limits<float>::max();
+		float maxProjection = std::numeric_limits<float>::lowest();
+		for (const auto& texel : block)
+		{
+			float projection = 0.0f;
+			for (uint32_t c = 0; c < channelCount; ++c)
+				projection += (texel[c] - mean[c]) * axis[c];
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		const float inset = (maxProjection - minProjection) / 16.0f;
+		minProjection += inset;
+		maxProjection -= inset;
+
+		float axisLengthSq = 0.0f;
+		for (uint32_t c = 0; c < channelCount; ++c)
+			axisLengthSq += axis[c] * axis[c];
+		if (axisLengthSq > 0.0f)
+		{
+			minProjection /= axisLengthSq;
+			maxProjection /= axisLengthSq;
+		}
+
+		low.fill(0.0f);
+		high.fill(0.0f);
+		for (uint32_t c = 0; c < channelCount; ++c)
+		{
+			low[c] = std::clamp(mean[c] + axis[c] * minProjection, 0.0f, 255.0f);
+			high[c] = std::clamp(mean[c] + axis[c] * maxProjection, 0.0f, 255.0f);
+		}
+	}
+
+	int Distance(const uint8_t* a, const int* b, uint32_t channelCount)
+	{
+		int distance = 0;
+		for (uint32_t c = 0; c < channelCount; ++c)
+		{
+			const int difference = a[c] - b[c];
+			distance += difference * difference;
+		}
+		return distance;
+	}
+
+	uint16_t PackRGB565(const std::array<float, CHANNELS>& colour)
+	{
+		const uint16_t r = static_cast<uint16_t>(colour[0] * 31.0f / 255.0f + 0.5f);
+		const uint16_t g = static_cast<uint16_t>(colour[1] * 63.0f / 255.0f + 0.5f);
+		const uint16_t b = static_cast<uint16_t>(colour[2] * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	void UnpackRGB565(uint16_t packed, int* colour)
+	{
+		const int r = (packed >> 11) & 31;
+		const int g = (packed >> 5) & 63;
+		const int b = packed & 31;
+		colour[0] = (r << 3) | (r >> 2);
+		colour[1] = (g << 2) | (g >> 4);
+		colour[2] = (b << 3) | (b >> 2);
+	}
+
+	//Always in four colour mode, which BC3 requires and BC1 gets by keeping the first endpoint the larger one
+	void EncodeBC1(const Block& block, uint8_t* output)
+	{
+		std::array<float, CHANNELS> low;
+		std::array<float, CHANNELS> high;
+		AxisEndpoints(block, 3, low, high);
+
+		uint16_t colour0 = PackRGB565(high);
+		uint16_t colour1 = PackRGB565(low);
+		if (colour0 < colour1)
+			std::swap(colour0, colour1);
+
+		uint32_t indices = 0;
+		if (colour0 != colour1)
+		{
+			int palette[4][3];
+			UnpackRGB565(colour0, palette[0]);
+			UnpackRGB565(colour1, palette[1]);
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				uint32_t bestIndex = 0;
+				int bestDistance = std::numeric_limits<int>::max();
+				for (uint32_t index = 0; index < 4; ++index)
+				{
+					const int distance = Distance(block[i].data(), palette[index], 3);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = index;
+					}
+				}
+				indices |= bestIndex << (i * 2);
+			}
+		}
+
+		memcpy(output, &colour0, sizeof(colour0));
+		memcpy(output + 2, &colour1, sizeof(colour1));
+		memcpy(output + 4, &indices, sizeof(indices));
+	}
+
+	//One channel with 8 interpolated values, used for BC3 alpha and both BC5 channels
+	void EncodeBC4(const Block& block, uint32_t channel, uint8_t* output)
+	{
+		uint8_t low = 255;
+		uint8_t high = 0;
+		for (const auto& texel : block)
+		{
+			low = std::min(low, texel[channel]);
+			high = std::max(high, texel[channel]);
+		}
+
+		uint64_t indices = 0;
+		if (high != low)
+		{
+			const float range = static_cast<float>(high - low);
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				//Steps from low to high, index 0 is high, 1 is low and 2-7 are the values in between from high to low
+				const uint64_t step = static_cast<uint64_t>((block[i][channel] - low) * 7.0f / range + 0.5f);
+				const uint64_t index = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+				indices |= index << (i * 3);
+			}
+		}
+
+		output[0] = high;
+		output[1] = low;
+		for (uint32_t i = 0; i < 6; ++i)
+			output[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+	}
+
+	//Writes fields from the lowest bit up like the BC7 block layout
+	class BitWriter
+	{
+	public:
+		BitWriter(uint8_t* output) : m_output(output), m_position(0)
+		{
+			memset(m_output, 0, 16);
+		}
+
+		void Write(uint32_t value, uint32_t bitCount)
+		{
+			for (uint32_t bit = 0; bit < bitCount; ++bit, ++m_position)
+				m_output[m_position / 8] |= static_cast<uint8_t>(((value >> bit) & 1) << (m_position % 8));
+		}
+	private:
+		uint8_t* m_output;
+		uint32_t m_position;
+	};
+
+	//Quantises an endpoint to 7 bits per channel plus a p-bit shared by the channels, the p-bit with less error is kept
+	void QuantiseBC7Endpoint(const std::array<float, CHANNELS>& endpoint, std::array<uint32_t, CHANNELS>& quantised, uint32_t& pBit)
+	{
+		float bestError = std::numeric_limits<float>::max();
+		for (uint32_t p = 0; p < 2; ++p)
+		{
+			std::array<uint32_t, CHANNELS> candidate;
+			float error = 0.0f;
+			for (uint32_t c = 0; c < CHANNELS; ++c)
+			{
+				candidate[c] = static_cast<uint32_t>(std::clamp(std::round((endpoint[c] - p) / 2.0f), 0.0f, 127.0f));
+				const float difference = static_cast<float>((candidate[c] << 1) | p) - endpoint[c];
+				error += difference * difference;
+			}
+
+			if (error < bestError)
+			{
+				bestError = error;
+				quantised = candidate;
+				pBit = p;
+			}
+		}
+	}
+
+	void EncodeBC7(const Block& block, uint8_t* output)
+	{
+		std::array<float, CHANNELS> low;
+		std::array<float, CHANNELS> high;
+		AxisEndpoints(block, CHANNELS, low, high);
+
+		std::array<std::array<uint32_t, CHANNELS>, 2> endpoints;
+		std::array<uint32_t, 2> pBits;
+		QuantiseBC7Endpoint(low, endpoints[0], pBits[0]);
+		QuantiseBC7Endpoint(high, endpoints[1], pBits[1]);
+
+		int palette[16][CHANNELS];
+		for (uint32_t c = 0; c < CHANNELS; ++c)
+		{
+			const int endpoint0 = static_cast<int>((endpoints[0][c] << 1) | pBits[0]);
+			const int endpoint1 = static_cast<int>((endpoints[1][c] << 1) | pBits[1]);
+			for (uint32_t index = 0; index < BC7_WEIGHTS.size(); ++index)
+				palette[index][c] = ((64 - BC7_WEIGHTS[index]) * endpoint0 + BC7_WEIGHTS[index] * endpoint1 + 32) >> 6;
+		}
+
+		std::array<uint32_t, BLOCK_TEXELS> indices;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			int bestDistance = std::numeric_limits<int>::max();
+			for (uint32_t index = 0; index < BC7_WEIGHTS.size(); ++index)
+			{
+				const int distance = Distance(block[i].data(), palette[index], CHANNELS);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					indices[i] = index;
+				}
+			}
+		}
+
+		//The first index is stored without its top bit so it has to be below 8, the weights are symmetric so swapping the
+		//endpoints and flipping the indices gives the same colours
+		if (indices[0] >= 8)
+		{
+			std::swap(endpoints[0], endpoints[1]);
+			std::swap(pBits[0], pBits[1]);
+			for (uint32_t& index : indices)
+				index = 15 - index;
+		}
+
+		BitWriter writer(output);
+		writer.Write(1u << 6, 7); //Mode 6
+		for (uint32_t c = 0; c < CHANNELS; ++c)
+		{
+			writer.Write(endpoints[0][c], 7);
+			writer.Write(endpoints[1][c], 7);
+		}
+		writer.Write(pBits[0], 1);
+		writer.Write(pBits[1], 1);
+		writer.Write(indices[0], 3);
+		for (uint32_t i = 1; i < BLOCK_TEXELS; ++i)
+			writer.Write(indices[i], 4);
+	}
+
+	void EncodeBlock(Format format, const Block& block, uint8_t* output)
+	{
+		switch (format)
+		{
+		case Format::BC1_RGB_UNORM:
+		case Format::BC1_RGB_SRGB:
+			EncodeBC1(block, output);
+			break;
+		case Format::BC3_UNORM:
+		case Format::BC3_SRGB:
+			EncodeBC4(block, 3, output);
+			EncodeBC1(block, output + 8);
+			break;
+		case Format::BC5_UNORM:
+			EncodeBC4(block, 0, output);
+			EncodeBC4(block, 1, output + 8);
+			break;
+		case Format::BC7_UNORM:
+		case Format::BC7_SRGB:
+			EncodeBC7(block, output);
+			break;
+		default:
+			CORE_ASSERT(false, "Format is not block compressed");
+			break;
+		}
+	}
+
+	std::vector<MipLevel> CompressedLevels(Format format, uint32_t width, uint32_t height, uint32_t levelCount)
+	{
+		std::vector<MipLevel> levels;
+		levels.reserve(levelCount);
+
+		size_t offset = 0;
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			const size_t size = ImageSize(format, width, height);
+			levels.push_back({ offset, size, width, height });
+			offset += size;
+			width = std::max(width / 2, 1u);
+			height = std::max(height / 2, 1u);
+		}
+		return levels;
+	}
+
+	//Checks the header and leaves the file at the start of the data
+	bool OpenCacheFile(const std::string& path, std::ifstream& file, FileHeader& header)
+	{
+		file.open(path, std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+			return false;
+
+		if (header.magic != FILE_MAGIC || header.version != FILE_VERSION)
+			return false;
+
+		const Format format = static_cast<Format>(header.format);
+		if ((!IsBlockCompressed(format) && format != Format::R8G8B8A8_SRGB) || header.width == 0 || header.height == 0 || header.levelCount == 0 ||
+			header.levelCount > MipLevelCount(header.width, header.height) ||
+			header.dataSize != MipChainSize(format, header.width, header.height, header.levelCount))
+		{
+			Log::PrintCore(string_format("Compressed texture {0} is invalid", path), LogSeverity::LogWarning);
+			return false;
+		}
+		return true;
+	}
+}
+
+CompressedTexture SC::CompressMipChain(const MipChain& chain, Format format, ThreadPool* threadPool)
+{
+	CompressedTexture texture;
+	CORE_ASSERT(IsBlockCompressed(format), "Format is not block compressed");
+	CORE_ASSERT(!chain.levels.empty(), "No mip levels to compress");
+	if (!IsBlockCompressed(format) || chain.levels.empty()) return texture;
+
+	texture.format = format;
+	texture.width = chain.levels.front().width;
+	texture.height = chain.levels.front().height;
+	texture.levels = CompressedLevels(format, texture.width, texture.height, static_cast<uint32_t>(chain.levels.size()));
+	texture.data.resize(texture.levels.back().offset + texture.levels.back().size);
+
+	//Rows of blocks of every level are the jobs so small levels don't leave threads idle at the end
+	struct BlockRow
+	{
+		uint32_t level;
+		uint32_t row;
+	};
+	std::vector<BlockRow> rows;
+	for (uint32_t level = 0; level < chain.levels.size(); ++level)
+	{
+		const uint32_t rowCount = (chain.levels[level].height + BLOCK_DIM - 1) / BLOCK_DIM;
+		for (uint32_t row = 0; row < rowCount; ++row)
+			rows.push_back({ level, row });
+	}
+
+	const uint32_t blockSize = FormatBlockSize(format);
+	auto encodeRow = [&](uint32_t index)
+	{
+		const MipLevel& source = chain.levels[rows[index].level];
+		const MipLevel& destination = texture.levels[rows[index].level];
+		const uint32_t blocksPerRow = (source.width + BLOCK_DIM - 1) / BLOCK_DIM;
+
+		uint8_t* output = texture.data.data() + destination.offset + static_cast<size_t>(rows[index].row) * blocksPerRow * blockSize;
+		for (uint32_t blockX = 0; blockX < blocksPerRow; ++blockX, output += blockSize)
+		{
+			const Block block = LoadBlock(chain.pixels.data() + source.offset, source.width, source.height, blockX, rows[index].row);
+			EncodeBlock(format, block, output);
+		}
+	};
+
+	if (threadPool)
+		threadPool->ParallelFor(static_cast<uint32_t>(rows.size()), encodeRow);
+	else
+	{
+		for (uint32_t i = 0; i < rows.size(); ++i)
+			encodeRow(i);
+	}
+
+	return texture;
+}
+
+bool SC::WriteCompressedTexture(const std::string& path, const CompressedTexture& texture)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	FileHeader header;
+	header.magic = FILE_MAGIC;
+	header.version = FILE_VERSION;
+	header.format = static_cast<uint32_t>(to_underlying(texture.format));
+	header.width = texture.width;
+	header.height = texture.height;
+	header.levelCount = static_cast<uint32_t>(texture.levels.size());
+	header.dataSize = texture.data.size();
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(texture.data.data()), texture.data.size());
+	return file.good();
+}
+
+bool SC::ReadCompressedTexture(const std::string& path, CompressedTexture& texture)
+{
+	std::ifstream file;
+	FileHeader header;
+	if (!OpenCacheFile(path, file, header))
+		return false;
+
+	const Format format = static_cast<Format>(header.format);
+	texture.format = format;
+	texture.width = header.width;
+	texture.height = header.height;
+	texture.levels = CompressedLevels(format, header.width, header.height, header.levelCount);
+	texture.data.resize(header.dataSize);
+	return static_cast<bool>(file.read(reinterpret_cast<char*>(texture.data.data()), texture.data.size()));
+}
+
+bool SC::ReadCompressedTextureLevels(const std::string& path, uint32_t firstLevel, uint32_t levelCount, std::vector<uint8_t>& data)
+{
+	std::ifstream file;
+	FileHeader header;
+	if (!OpenCacheFile(path, file, header))
+		return false;
+
+	if (levelCount == 0 || firstLevel + levelCount > header.levelCount)
+	{
+		Log::PrintCore(string_format("Cached texture {0} doesn't have levels {1} to {2}", path, firstLevel, firstLevel + levelCount), LogSeverity::LogWarning);
+		return false;
+	}
+
+	const std::vector<MipLevel> levels = CompressedLevels(static_cast<Format>(header.format), header.width, header.height, firstLevel + levelCount);
+	const MipLevel& first = levels[firstLevel];
+	data.resize(levels.back().offset + levels.back().size - first.offset);
+
+	file.seekg(first.offset, std::ios::cur);
+	return static_cast<bool>(file.read(reinterpret_cast<char*>(data.data()), data.size()));
+}
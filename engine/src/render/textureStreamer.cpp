@@ -0,0 +1,218 @@
+#include "pch.h"
+#include "render/textureStreamer.h"
+#include "render/texture.h"
+#include "render/mipChain.h"
+#include "render/textureCompression.h"
+#include <cmath>
+#include <queue>
+
+using namespace SC;
+
+TextureStreamer::TextureStreamer() :
+	m_memoryBudget(DEFAULT_MEMORY_BUDGET),
+	m_mipBias(0),
+	m_frame(0)
+{
+
+}
+
+void TextureStreamer::Add(Texture* texture, const std::string& cachePath, const std::vector<uint8_t>& mipChain)
+{
+	CORE_ASSERT(texture && texture->IsStreamed(), "Texture has to be built with BuildStreamed");
+	CORE_ASSERT(!Contains(texture), "Texture is already streamed");
+	if (!texture || !texture->IsStreamed() || Contains(texture)) return;
+
+	const uint32_t mipLevels = texture->GetMipLevelCount();
+	uint32_t minimumMip = 0;
+	while (minimumMip + 1 < mipLevels && std::max(texture->GetWidth() >> minimumMip, texture->GetHeight() >> minimumMip) > MIN_RESIDENT_SIZE)
+		++minimumMip;
+
+	StreamedTexture& streamed = m_textures[texture];
+	streamed.texture = texture;
+	streamed.cachePath = cachePath;
+	streamed.minimumMip = minimumMip;
+	streamed.requestedMip = minimumMip;
+	streamed.lastRequestedMip = minimumMip;
+	streamed.targetMip = minimumMip;
+	streamed.lastUsedFrame = m_frame;
+
+	const size_t offset = MipChainSize(texture->GetFormat(), texture->GetWidth(), texture->GetHeight(), minimumMip);
+	CORE_ASSERT(mipChain.size() >= offset, "Not enough data for the mip levels");
+	if (mipChain.size() < offset) return;
+
+	texture->SetResidentMip(mipChain.data() + offset, mipChain.size() - offset, minimumMip);
+}
+
+void TextureStreamer::Remove(const Texture* texture)
+{
+	m_textures.erase(texture);
+}
+
+bool TextureStreamer::Contains(const Texture* texture) const
+{
+	return m_textures.find(texture) != m_textures.end();
+}
+
+void TextureStreamer::Request(const Texture* texture, float screenSize)
+{
+	auto it = m_textures.find(texture);
+	if (it == m_textures.end() || screenSize <= 0.0f)
+		return;
+
+	StreamedTexture& streamed = it->second;
+	const float textureSize = static_cast<float>(std::max(texture->GetWidth(), texture->GetHeight()));
+	const int mip = static_cast<int>(std::floor(std::log2(textureSize / screenSize))) + m_mipBias;
+
+	const uint32_t requestedMip = static_cast<uint32_t>(std::clamp(mip, 0, static_cast<int>(streamed.minimumMip)));
+	streamed.requestedMip = std::min(streamed.requestedMip, requestedMip);
+}
+
+void TextureStreamer::Update()
+{
+	++m_frame;
+
+	m_stats = TextureStreamingStats();
+	m_stats.textures = static_cast<uint32_t>(m_textures.size());
+
+	//Targets from the requests, keeping levels that were used recently
+	size_t targetBytes = 0;
+	for (auto& [key, streamed] : m_textures)
+	{
+		const uint32_t residentMip = streamed.texture->GetResidentMip();
+		const uint32_t mipLevels = streamed.texture->GetMipLevelCount();
+
+		m_stats.requestedMips += mipLevels - streamed.requestedMip;
+		m_stats.requestedBytes += ResidentSize(*streamed.texture, streamed.requestedMip);
+
+		if (streamed.requestedMip <= residentMip)
+			streamed.lastUsedFrame = m_frame;
+
+		if (streamed.requestedMip > residentMip && m_frame - streamed.lastUsedFrame < EVICT_DELAY_FRAMES)
+			streamed.targetMip = residentMip;
+		else
+			streamed.targetMip = streamed.requestedMip;
+
+		//Without its cache levels can't be read back, only dropped
+		if (streamed.cachePath.empty())
+			streamed.targetMip = std::max(streamed.targetMip, residentMip);
+
+		targetBytes += ResidentSize(*streamed.texture, streamed.targetMip);
+		streamed.lastRequestedMip = streamed.requestedMip;
+		streamed.requestedMip = streamed.minimumMip;
+	}
+
+	//Over budget the largest top levels are dropped first, they save the most memory for the least detail
+	if (targetBytes > m_memoryBudget)
+	{
+		using Candidate = std::pair<size_t, StreamedTexture*>;
+		std::priority_queue<Candidate> candidates;
+		for (auto& [key, streamed] : m_textures)
+		{
+			if (streamed.targetMip < streamed.minimumMip)
+				candidates.push({ ResidentSize(*streamed.texture, streamed.targetMip) - ResidentSize(*streamed.texture, streamed.targetMip + 1), &streamed });
+		}
+
+		while (targetBytes > m_memoryBudget && !candidates.empty())
+		{
+			const auto [levelSize, streamed] = candidates.top();
+			candidates.pop();
+
+			targetBytes -= levelSize;
+			++streamed->targetMip;
+			if (streamed->targetMip < streamed->minimumMip)
+				candidates.push({ ResidentSize(*streamed->texture, streamed->targetMip) - ResidentSize(*streamed->texture, streamed->targetMip + 1), streamed });
+		}
+	}
+
+	//Evicting frees memory so it always happens, the levels kept are copied on the GPU. Streaming in is limited to a number
+	//of bytes per update
+	m_streamIn.clear();
+	for (auto& [key, streamed] : m_textures)
+	{
+		if (streamed.targetMip > streamed.texture->GetResidentMip())
+		{
+			streamed.texture->SetResidentMip(nullptr, 0, streamed.targetMip);
+			++m_stats.evicted;
+		}
+		else if (streamed.targetMip < streamed.texture->GetResidentMip())
+		{
+			m_streamIn.push_back(&streamed);
+		}
+	}
+
+	//Textures missing the most levels first
+	std::sort(m_streamIn.begin(), m_streamIn.end(), [](const StreamedTexture* a, const StreamedTexture* b)
+		{
+			return a->texture->GetResidentMip() - a->targetMip > b->texture->GetResidentMip() - b->targetMip;
+		});
+
+	size_t streamInBytes = 0;
+	for (StreamedTexture* streamed : m_streamIn)
+	{
+		//Only the levels more detailed than the resident ones are read and uploaded
+		const uint32_t residentMip = streamed->texture->GetResidentMip();
+		const size_t size = ResidentSize(*streamed->texture, streamed->targetMip) - ResidentSize(*streamed->texture, residentMip);
+		if (m_stats.streamedIn > 0 && streamInBytes + size > MAX_UPLOAD_BYTES_PER_UPDATE)
+			continue;
+
+		if (!ReadCompressedTextureLevels(streamed->cachePath, streamed->targetMip, residentMip - streamed->targetMip, m_levelData))
+		{
+			Log::PrintCore(string_format("Failed to read texture levels from {0}, the texture won't stream in", streamed->cachePath), LogSeverity::LogWarning);
+			streamed->cachePath.clear();
+			continue;
+		}
+
+		streamed->texture->SetResidentMip(m_levelData.data(), m_levelData.size(), streamed->targetMip);
+		streamInBytes += size;
+		++m_stats.streamedIn;
+	}
+	m_stats.uploadedBytes += streamInBytes;
+
+	for (const auto& [key, streamed] : m_textures)
+	{
+		m_stats.residentMips += streamed.texture->GetMipLevelCount() - streamed.texture->GetResidentMip();
+		m_stats.residentBytes += ResidentSize(*streamed.texture, streamed.texture->GetResidentMip());
+	}
+}
+
+void TextureStreamer::SetMemoryBudget(size_t bytes)
+{
+	m_memoryBudget = bytes;
+}
+
+size_t TextureStreamer::GetMemoryBudget() const
+{
+	return m_memoryBudget;
+}
+
+void TextureStreamer::SetMipBias(int bias)
+{
+	m_mipBias = bias;
+}
+
+int TextureStreamer::GetMipBias() const
+{
+	return m_mipBias;
+}
+
+const TextureStreamingStats& TextureStreamer::GetStats() const
+{
+	return m_stats;
+}
+
+void TextureStreamer::GetTextureStates(std::vector<StreamedTextureState>& states) const
+{
+	states.clear();
+	states.reserve(m_textures.size());
+	for (const auto& [key, streamed] : m_textures)
+		states.push_back({ streamed.texture, streamed.texture->GetMipLevelCount(), streamed.texture->GetResidentMip(), streamed.lastRequestedMip });
+}
+
+size_t TextureStreamer::ResidentSize(const Texture& texture, uint32_t residentMip)
+{
+	const uint32_t mipLevels = texture.GetMipLevelCount();
+	if (residentMip >= mipLevels)
+		return 0;
+
+	return MipChainSize(texture.GetFormat(), std::max(texture.GetWidth() >> residentMip, 1u), std::max(texture.GetHeight() >> residentMip, 1u), mipLevels - residentMip);
+}
@@ -2,12 +2,15 @@
 #include "vk/vulkanBuffer.h"
 #include "core/app.h"
 #include "vk/vulkanRenderer.h"
+#include "vk/vulkanUploadManager.h"
+#include <cstring>
 
 using namespace SC;
 
 VulkanBuffer::VulkanBuffer(size_t size, const BufferUsageSet& bufferUsage, AllocationUsage allocationUsage, const void* dataPtr) : Buffer(size, bufferUsage,allocationUsage),
 m_buffer(VK_NULL_HANDLE),
-m_allocation(VK_NULL_HANDLE)
+m_allocation(VK_NULL_HANDLE),
+m_mapped(nullptr)
 {
 	const App* app = App::Instance();
 	CORE_ASSERT(app, "App instance is null");
@@ -25,6 +28,10 @@ m_allocation(VK_NULL_HANDLE)
 		bufferInfo.usage |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
 	if (m_bufferUsage.test(BufferUsage::UNIFORM_BUFFER))
 		bufferInfo.usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+	if (m_bufferUsage.test(BufferUsage::STORAGE_BUFFER))
+		bufferInfo.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	if (m_bufferUsage.test(BufferUsage::INDIRECT_BUFFER))
+		bufferInfo.usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
 	if (m_bufferUsage.test(BufferUsage::TRANSFER_SRC))
 		bufferInfo.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 	if (m_bufferUsage.test(BufferUsage::TRANSFER_DST))
@@ -47,38 +54,32 @@ m_allocation(VK_NULL_HANDLE)
 		break;
 	}
 
-	//If we have the map usage make sure we set VMA to allow mapping to this buffer
+	//Uploads can be copied on the transfer queue, sharing the buffer between both families avoids transferring ownership back
+	const std::array<uint32_t, 2> queueFamilies = { renderer->m_graphicsQueueFamily, renderer->m_transferQueueFamily };
+	if ((bufferInfo.usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) && queueFamilies[0] != queueFamilies[1])
+	{
+		bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+		bufferInfo.pQueueFamilyIndices = queueFamilies.data();
+	}
+
+	//If we have the map usage make sure we set VMA to allow mapping to this buffer, it is mapped once here instead of on every Map
 	if (m_bufferUsage.test(BufferUsage::MAP))
-		allocInfo.flags |= VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+		allocInfo.flags |= VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
 
-	VK_CHECK(vmaCreateBuffer(renderer->m_allocator, &bufferInfo, &allocInfo, &m_buffer, &m_allocation, nullptr));
+	VmaAllocationInfo allocationInfo = {};
+	VK_CHECK(vmaCreateBuffer(renderer->m_allocator, &bufferInfo, &allocInfo, &m_buffer, &m_allocation, &allocationInfo));
+	m_mapped = allocationInfo.pMappedData;
 
 	m_deletionQueue.push_function([=]() {
-		renderer->WaitOnFences();
-		vmaDestroyBuffer(renderer->m_allocator, m_buffer, m_allocation);
-		vmaFlushAllocation(renderer->m_allocator, m_allocation, 0, size);
-
+		renderer->DeferDestroy([renderer, buffer = m_buffer, allocation = m_allocation]() {
+			vmaDestroyBuffer(renderer->m_allocator, buffer, allocation);
+			});
 		});
 
 	//upload data if we have set the dataPtr
 	if (dataPtr)
-	{
-		if (m_bufferUsage.test(BufferUsage::MAP))
-		{
-			auto mappedData = Map();
-			memcpy(mappedData.Data(), dataPtr, m_size);
-		}
-		else if (m_allocationUsage == AllocationUsage::DEVICE)
-		{
-			//Create a staging buffer and copy data to GPU
-			BufferUsageSet stagingUsage = bufferUsage;
-			stagingUsage.set(BufferUsage::TRANSFER_SRC);
-			stagingUsage.set(BufferUsage::MAP);
-			VulkanBuffer stagingBuffer(size, stagingUsage, AllocationUsage::HOST, dataPtr);
-
-			CopyFrom(&stagingBuffer);
-		}
-	}
+		CopyData(dataPtr, m_size);
 }
 
 VulkanBuffer::~VulkanBuffer()
@@ -100,26 +101,20 @@ ScopedMapData VulkanBuffer::Map()
 		return ScopedMapData();
 	}
 
-	const App* app = App::Instance();
-	CORE_ASSERT(app, "App instance is null");
-	if (!app) return ScopedMapData();
+	//Persistently mapped so there is nothing to unmap
+	CORE_ASSERT(m_mapped, "Failed to map buffer data");
+	return ScopedMapData(m_mapped, nullptr);
+}
 
-	void* mapped{ nullptr };
-	if (const VulkanRenderer* renderer = app->GetVulkanRenderer())
-	{
-		vmaMapMemory(renderer->m_allocator, m_allocation, &mapped);
-		CORE_ASSERT(mapped, "Failed to map buffer data");
+void VulkanBuffer::CopyFrom(Buffer* src)
+{
+	CORE_ASSERT(src, "src buffer cant be null");
+	if (!src) return;
 
-		return ScopedMapData(mapped, [=]() 
-			{
-				vmaUnmapMemory(renderer->m_allocator, m_allocation);
-			});
-	}
-	CORE_ASSERT(false, "Failed to map buffer data");
-	return ScopedMapData();
+	CopyFrom(src, 0, 0, src->GetSize());
 }
 
-void VulkanBuffer::CopyFrom(Buffer* src)
+void VulkanBuffer::CopyFrom(Buffer* src, size_t srcOffset, size_t dstOffset, size_t size)
 {
 	CORE_ASSERT(src, "src buffer cant be null");
 	if (!src) return;
@@ -136,9 +131,9 @@ void VulkanBuffer::CopyFrom(Buffer* src)
 		return;
 	}
 
-	if (src->GetSize() > GetSize())
+	if (srcOffset + size > src->GetSize() || dstOffset + size > GetSize())
 	{
-		CORE_ASSERT(false, "Src is larger than dst");
+		CORE_ASSERT(false, "Copy range is out of bounds");
 		return;
 	}
 
@@ -149,13 +144,58 @@ void VulkanBuffer::CopyFrom(Buffer* src)
 	const VulkanRenderer* renderer = app->GetVulkanRenderer();
 	if (!renderer) return;
 
-	renderer->ImmediateSubmit([=](VkCommandBuffer cmd) {
+	//src may only be owned by the graphics queue family so it isn't copied on the transfer queue
+	VulkanUploadManager& uploadManager = renderer->GetUploadManager();
+	uploadManager.Record(UploadQueue::GRAPHICS, [&](VkCommandBuffer cmd) {
 		VkBufferCopy copy;
-		copy.dstOffset = 0;
-		copy.srcOffset = 0;
-		copy.size = m_size;
+		copy.dstOffset = dstOffset;
+		copy.srcOffset = srcOffset;
+		copy.size = size;
 		vkCmdCopyBuffer(cmd, *static_cast<VulkanBuffer*>(src)->GetBuffer(), *GetBuffer(), 1, &copy);
 		});
+
+	//The caller owns src and can change or destroy it as soon as this returns
+	uploadManager.WaitIdle();
+}
+
+void VulkanBuffer::CopyData(const void* data, size_t size, size_t offset)
+{
+	CORE_ASSERT(data, "data cant be null");
+	if (!data || size == 0) return;
+
+	if (offset + size > GetSize())
+	{
+		CORE_ASSERT(false, "Copy range is out of bounds");
+		return;
+	}
+
+	if (HasUsage(BufferUsage::MAP))
+	{
+		memcpy(static_cast<uint8_t*>(m_mapped) + offset, data, size);
+		return;
+	}
+
+	if (m_allocationUsage != AllocationUsage::DEVICE && !HasUsage(BufferUsage::TRANSFER_DST))
+	{
+		CORE_ASSERT(false, "Buffer must have BufferUsage::MAP or BufferUsage::TRANSFER_DST");
+		return;
+	}
+
+	const App* app = App::Instance();
+	CORE_ASSERT(app, "App instance is null");
+	if (!app) return;
+
+	const VulkanRenderer* renderer = app->GetVulkanRenderer();
+	if (!renderer) return;
+
+	//Staged and copied in the upload manager's next batch instead of submitting and waiting for this buffer alone
+	renderer->GetUploadManager().Upload(UploadQueue::TRANSFER, data, size, 16, [&](VkCommandBuffer cmd, VkBuffer stagingBuffer, VkDeviceSize stagingOffset) {
+		VkBufferCopy copy;
+		copy.srcOffset = stagingOffset;
+		copy.dstOffset = offset;
+		copy.size = size;
+		vkCmdCopyBuffer(cmd, stagingBuffer, m_buffer, 1, &copy);
+		});
 }
 
 const VkBuffer* VulkanBuffer::GetBuffer() const
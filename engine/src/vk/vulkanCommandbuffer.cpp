@@ -7,6 +7,7 @@
 #include "vk/vulkanTexture.h"
 #include "vk/vulkanPipeline.h"
 #include "vk/vulkanBuffer.h"
+#include "vk/vulkanUtils.h"
 #include "render/mesh.h"
 #include "../../include/scorch/vk/vulkanDescriptorSet.h"
 
@@ -46,7 +47,7 @@ void VulkanCommandPool::Init()
 		});
 }
 
-std::unique_ptr<SC::CommandBuffer> VulkanCommandPool::CreateCommandBuffer()
+std::unique_ptr<SC::CommandBuffer> VulkanCommandPool::CreateCommandBuffer(CommandBufferLevel level)
 {
 	const App* app = App::Instance();
 	CORE_ASSERT(app, "App instance is null");
@@ -56,8 +57,9 @@ std::unique_ptr<SC::CommandBuffer> VulkanCommandPool::CreateCommandBuffer()
 	if (!renderer) return nullptr;
 
 	//Create a raw pointer object and create the command buffer and populate the free command queue so the buffer get deleted after use
-	VulkanCommandBuffer* vkCommandBuffer = new VulkanCommandBuffer();
-	VkCommandBufferAllocateInfo cmdAllocInfo = vkinit::CommandBufferAllocateInfo(m_commandPool, 1);
+	VulkanCommandBuffer* vkCommandBuffer = new VulkanCommandBuffer(level);
+	VkCommandBufferAllocateInfo cmdAllocInfo = vkinit::CommandBufferAllocateInfo(m_commandPool, 1,
+		level == CommandBufferLevel::SECONDARY ? VK_COMMAND_BUFFER_LEVEL_SECONDARY : VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 	VK_CHECK(vkAllocateCommandBuffers(renderer->m_device, &cmdAllocInfo, &vkCommandBuffer->m_commandBuffer));
 
 	vkCommandBuffer->m_freeCommandQueue.push_function([=]() {
@@ -67,7 +69,23 @@ std::unique_ptr<SC::CommandBuffer> VulkanCommandPool::CreateCommandBuffer()
 	return std::unique_ptr<VulkanCommandBuffer>(vkCommandBuffer);
 }
 
-VulkanCommandBuffer::VulkanCommandBuffer() : m_commandBuffer(VK_NULL_HANDLE)
+void VulkanCommandPool::Reset()
+{
+	const App* app = App::Instance();
+	CORE_ASSERT(app, "App instance is null");
+	if (!app) return;
+
+	const VulkanRenderer* renderer = app->GetVulkanRenderer();
+	if (!renderer) return;
+
+	VK_CHECK(vkResetCommandPool(renderer->m_device, m_commandPool, 0));
+}
+
+VulkanCommandBuffer::VulkanCommandBuffer(CommandBufferLevel level) : m_commandBuffer(VK_NULL_HANDLE),
+	m_level(level),
+	m_bindPoint(VK_PIPELINE_BIND_POINT_GRAPHICS),
+	m_boundState(),
+	m_stats()
 {
 }
 
@@ -76,11 +94,34 @@ VulkanCommandBuffer::~VulkanCommandBuffer()
 	m_freeCommandQueue.flush();
 }
 
-void VulkanCommandBuffer::BeginRecording() const
+void VulkanCommandBuffer::BeginRecording()
 {
 	//begin the command buffer recording. We will use this command buffer exactly once, so we want to let Vulkan know that
 	VkCommandBufferBeginInfo cmdBeginInfo = vkinit::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 	VK_CHECK(vkBeginCommandBuffer(m_commandBuffer, &cmdBeginInfo));
+
+	InvalidateState();
+	m_stats = CommandBufferStats();
+}
+
+void VulkanCommandBuffer::BeginRecording(const Renderpass* renderPass, const RenderTarget* renderTarget)
+{
+	CORE_ASSERT(m_level == CommandBufferLevel::SECONDARY, "Only secondary command buffers continue a render pass");
+	CORE_ASSERT(renderPass && renderTarget, "Render pass and target can't be null");
+
+	VkCommandBufferInheritanceInfo inheritanceInfo = {};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.pNext = nullptr;
+	inheritanceInfo.renderPass = static_cast<const VulkanRenderpass*>(renderPass)->GetRenderPass();
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = static_cast<const VulkanRenderTarget*>(renderTarget)->m_framebuffer;
+
+	VkCommandBufferBeginInfo cmdBeginInfo = vkinit::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
+	cmdBeginInfo.pInheritanceInfo = &inheritanceInfo;
+	VK_CHECK(vkBeginCommandBuffer(m_commandBuffer, &cmdBeginInfo));
+
+	InvalidateState();
+	m_stats = CommandBufferStats();
 }
 
 void VulkanCommandBuffer::EndRecording() const
@@ -89,7 +130,8 @@ void VulkanCommandBuffer::EndRecording() const
 	VK_CHECK(vkEndCommandBuffer(m_commandBuffer));
 }
 
-void VulkanCommandBuffer::BeginRenderPass(const Renderpass* renderPass, const RenderTarget* renderTarget, float clearR /*= 0*/, float clearG /*= 0*/, float clearB /*= 0*/, float clearDepth /*= 1.0f*/)
+void VulkanCommandBuffer::BeginRenderPass(const Renderpass* renderPass, const RenderTarget* renderTarget, float clearR /*= 0*/, float clearG /*= 0*/, float clearB /*= 0*/, float clearDepth /*= 1.0f*/,
+	SubpassContents contents /*= SubpassContents::INLINE*/)
 {
 	VkClearValue clearValue;
 	clearValue.color = { { clearR, clearG, clearB, 1.0f } };
@@ -112,33 +154,66 @@ void VulkanCommandBuffer::BeginRenderPass(const Renderpass* renderPass, const Re
 	VkClearValue clearValues[] = { clearValue, depthClear };
 	rpInfo.pClearValues = &clearValues[0];
 
-	vkCmdBeginRenderPass(m_commandBuffer, &rpInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(m_commandBuffer, &rpInfo, contents == SubpassContents::SECONDARY_COMMAND_BUFFERS ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+	++m_stats.recorded;
 }
 
 void VulkanCommandBuffer::EndRenderPass()
 {
 	//finalize the render pass
 	vkCmdEndRenderPass(m_commandBuffer);
+	++m_stats.recorded;
 }
 
 void VulkanCommandBuffer::SetViewport(const Viewport& viewport)
 {
 	//VkViewport and viewport use the same memory layout so just reinterpret_cast
 	const VkViewport& vkViewport = reinterpret_cast<const VkViewport&>(viewport);
+	if (m_boundState.viewportSet && memcmp(&m_boundState.viewport, &vkViewport, sizeof(VkViewport)) == 0)
+	{
+		++m_stats.filtered;
+		return;
+	}
+
+	m_boundState.viewport = vkViewport;
+	m_boundState.viewportSet = true;
 	vkCmdSetViewport(m_commandBuffer, 0, 1, &vkViewport);
+	++m_stats.recorded;
 }
 
 void VulkanCommandBuffer::SetScissor(const Scissor& scissor)
 {
 	//VkRect2D and Scissor use the same memory layout so just reinterpret_cast
 	const VkRect2D& vkScissor = reinterpret_cast<const VkRect2D&>(scissor);
+	if (m_boundState.scissorSet && memcmp(&m_boundState.scissor, &vkScissor, sizeof(VkRect2D)) == 0)
+	{
+		++m_stats.filtered;
+		return;
+	}
+
+	m_boundState.scissor = vkScissor;
+	m_boundState.scissorSet = true;
 	vkCmdSetScissor(m_commandBuffer, 0, 1, &vkScissor);
+	++m_stats.recorded;
 }
 
 void VulkanCommandBuffer::BindPipeline(const Pipeline* pipeline)
 {
 	CORE_ASSERT(pipeline, "Pipline can't be null");
-	vkCmdBindPipeline(m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, static_cast<const VulkanPipeline*>(pipeline)->GetPipeline());
+	const VulkanPipeline* vulkanPipeline = static_cast<const VulkanPipeline*>(pipeline);
+	m_bindPoint = vulkanPipeline->GetBindPoint();
+	CORE_ASSERT(m_bindPoint < m_boundState.bindPoints.size(), "Bind point isn't tracked");
+
+	BindPointState& bindPointState = m_boundState.bindPoints[m_bindPoint];
+	if (bindPointState.pipeline == vulkanPipeline->GetPipeline())
+	{
+		++m_stats.filtered;
+		return;
+	}
+
+	bindPointState.pipeline = vulkanPipeline->GetPipeline();
+	vkCmdBindPipeline(m_commandBuffer, m_bindPoint, vulkanPipeline->GetPipeline());
+	++m_stats.recorded;
 }
 
 void VulkanCommandBuffer::BindVertexBuffer(const Buffer* buffer)
@@ -150,8 +225,17 @@ void VulkanCommandBuffer::BindVertexBuffer(const Buffer* buffer)
 		return;
 	}
 
+	const VkBuffer vkBuffer = *static_cast<const VulkanBuffer*>(buffer)->GetBuffer();
+	if (m_boundState.vertexBuffer == vkBuffer)
+	{
+		++m_stats.filtered;
+		return;
+	}
+
+	m_boundState.vertexBuffer = vkBuffer;
 	VkDeviceSize offset = 0;
-	vkCmdBindVertexBuffers(m_commandBuffer, 0, 1, static_cast<const VulkanBuffer*>(buffer)->GetBuffer(), &offset);
+	vkCmdBindVertexBuffers(m_commandBuffer, 0, 1, &vkBuffer, &offset);
+	++m_stats.recorded;
 }
 
 void VulkanCommandBuffer::BindIndexBuffer(const Buffer* buffer)
@@ -163,18 +247,59 @@ void VulkanCommandBuffer::BindIndexBuffer(const Buffer* buffer)
 		return;
 	}
 
+	const VkBuffer vkBuffer = *static_cast<const VulkanBuffer*>(buffer)->GetBuffer();
+	if (m_boundState.indexBuffer == vkBuffer)
+	{
+		++m_stats.filtered;
+		return;
+	}
+
+	m_boundState.indexBuffer = vkBuffer;
 	VkDeviceSize offset = 0;
-	vkCmdBindIndexBuffer(m_commandBuffer, *static_cast<const VulkanBuffer*>(buffer)->GetBuffer(), offset, sizeof(VertexIndexType) == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+	vkCmdBindIndexBuffer(m_commandBuffer, vkBuffer, offset, sizeof(VertexIndexType) == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+	++m_stats.recorded;
 }
 
-void VulkanCommandBuffer::BindDescriptorSet(const PipelineLayout* pipelineLayout, const DescriptorSet* descriptorSet, int set /*= 0*/)
+void VulkanCommandBuffer::BindDescriptorSet(const PipelineLayout* pipelineLayout, const DescriptorSet* descriptorSet, int set /*= 0*/,
+	const uint32_t* dynamicOffsets /*= nullptr*/, uint32_t dynamicOffsetCount /*= 0*/)
 {
 	CORE_ASSERT(descriptorSet, "descriptorSet can't be null");
+	CORE_ASSERT(dynamicOffsetCount == descriptorSet->Layout()->DynamicBindingCount(), "Every dynamic binding needs a dynamic offset");
 
 	const VulkanDescriptorSet* vulkanDescriptorSet = static_cast<const VulkanDescriptorSet*>(descriptorSet);
 	VkPipelineLayout layout = static_cast<const VulkanPipelineLayout*>(pipelineLayout)->GetPipelineLayout();
 
-	vkCmdBindDescriptorSets(m_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, set, 1, &vulkanDescriptorSet->m_descriptorSet, 0, nullptr);
+	BindPointState& bindPointState = m_boundState.bindPoints[m_bindPoint];
+	//Binding with another layout can disturb the sets bound with the previous one, so none of them are trusted
+	if (bindPointState.layout != layout)
+	{
+		bindPointState.layout = layout;
+		bindPointState.descriptorSets = {};
+	}
+
+	if (set >= 0 && static_cast<uint32_t>(set) < MAX_TRACKED_SETS)
+	{
+		BoundDescriptorSet& bound = bindPointState.descriptorSets[set];
+		if (dynamicOffsetCount > MAX_TRACKED_DYNAMIC_OFFSETS)
+		{
+			bound = BoundDescriptorSet();
+		}
+		else if (bound.set == vulkanDescriptorSet->m_descriptorSet && bound.dynamicOffsetCount == dynamicOffsetCount &&
+			std::equal(dynamicOffsets, dynamicOffsets + dynamicOffsetCount, bound.dynamicOffsets.begin()))
+		{
+			++m_stats.filtered;
+			return;
+		}
+		else
+		{
+			bound.set = vulkanDescriptorSet->m_descriptorSet;
+			bound.dynamicOffsetCount = dynamicOffsetCount;
+			std::copy_n(dynamicOffsets, dynamicOffsetCount, bound.dynamicOffsets.begin());
+		}
+	}
+
+	vkCmdBindDescriptorSets(m_commandBuffer, m_bindPoint, layout, set, 1, &vulkanDescriptorSet->m_descriptorSet, dynamicOffsetCount, dynamicOffsets);
+	++m_stats.recorded;
 }
 
 void VulkanCommandBuffer::PushConstants(const PipelineLayout* pipelineLayout, uint32_t rangeIndex, uint32_t offset, uint32_t size, void* data)
@@ -188,28 +313,133 @@ void VulkanCommandBuffer::PushConstants(const PipelineLayout* pipelineLayout, ui
 		return;
 	}
 
-	uint32_t shaderStages = 0;
-	if (pipelineLayout->PushConstants()[rangeIndex].shaderStages.test(ShaderStage::VERTEX))
-		shaderStages |= VK_SHADER_STAGE_VERTEX_BIT;
-	if (pipelineLayout->PushConstants()[rangeIndex].shaderStages.test(ShaderStage::FRAGMENT))
-		shaderStages |= VK_SHADER_STAGE_FRAGMENT_BIT;
+	const VkShaderStageFlags shaderStages = vkutils::ConvertShaderStages(pipelineLayout->PushConstants()[rangeIndex].shaderStages);
 
 	vkCmdPushConstants(m_commandBuffer, layout, shaderStages, offset, pipelineLayout->PushConstants()[rangeIndex].size, data);
+	++m_stats.recorded;
 }
 
 void VulkanCommandBuffer::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
 {
 	vkCmdDraw(m_commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+	++m_stats.recorded;
 }
 
 void VulkanCommandBuffer::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, uint32_t vertexOffset, uint32_t firstInstance)
 {
 	vkCmdDrawIndexed(m_commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+	++m_stats.recorded;
+}
+
+void VulkanCommandBuffer::DrawIndexedIndirect(const Buffer* buffer, size_t offset, uint32_t drawCount, uint32_t stride)
+{
+	CORE_ASSERT(buffer, "Buffer can't be null");
+	CORE_ASSERT(buffer->HasUsage(BufferUsage::INDIRECT_BUFFER), "Buffer needs the indirect buffer usage");
+
+	vkCmdDrawIndexedIndirect(m_commandBuffer, *static_cast<const VulkanBuffer*>(buffer)->GetBuffer(), offset, drawCount, stride);
+	++m_stats.recorded;
+}
+
+void VulkanCommandBuffer::DrawIndexedIndirectCount(const Buffer* buffer, size_t offset, const Buffer* countBuffer, size_t countOffset, uint32_t maxDrawCount, uint32_t stride)
+{
+	CORE_ASSERT(buffer && countBuffer, "Buffers can't be null");
+	CORE_ASSERT(buffer->HasUsage(BufferUsage::INDIRECT_BUFFER) && countBuffer->HasUsage(BufferUsage::INDIRECT_BUFFER), "Buffers need the indirect buffer usage");
+	CORE_ASSERT(App::Instance()->GetRenderer()->SupportsDrawIndirectCount(), "Draw indirect count is not supported by the device");
+
+	vkCmdDrawIndexedIndirectCountKHR(m_commandBuffer, *static_cast<const VulkanBuffer*>(buffer)->GetBuffer(), offset,
+		*static_cast<const VulkanBuffer*>(countBuffer)->GetBuffer(), countOffset, maxDrawCount, stride);
+	++m_stats.recorded;
+}
+
+void VulkanCommandBuffer::ExecuteCommands(const CommandBuffer* const* commandBuffers, uint32_t count)
+{
+	CORE_ASSERT(m_level == CommandBufferLevel::PRIMARY, "Only primary command buffers can execute other command buffers");
+	if (count == 0) return;
+
+	std::vector<VkCommandBuffer> vkCommandBuffers(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const VulkanCommandBuffer* commandBuffer = static_cast<const VulkanCommandBuffer*>(commandBuffers[i]);
+		CORE_ASSERT(commandBuffer && commandBuffer->m_level == CommandBufferLevel::SECONDARY, "Only secondary command buffers can be executed");
+		vkCommandBuffers[i] = commandBuffer->m_commandBuffer;
+	}
+
+	vkCmdExecuteCommands(m_commandBuffer, count, vkCommandBuffers.data());
+	++m_stats.recorded;
+
+	//The primary command buffer's state is undefined after executing secondaries
+	InvalidateState();
+}
+
+void VulkanCommandBuffer::Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	CORE_ASSERT(m_bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE, "A compute pipeline needs to be bound before dispatching");
+	vkCmdDispatch(m_commandBuffer, groupCountX, groupCountY, groupCountZ);
+	++m_stats.recorded;
+}
+
+void VulkanCommandBuffer::PipelineBarrier(const PipelineStageFlags& srcStages, const PipelineStageFlags& dstStages)
+{
+	struct StageAccess
+	{
+		VkPipelineStageFlags stage;
+		VkAccessFlags write;
+		VkAccessFlags read;
+	};
+
+	//Indexed by PipelineStage
+	static constexpr std::array<StageAccess, to_underlying(PipelineStage::COUNT)> STAGE_ACCESS
+	{ {
+		{ VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT },
+		{ VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT },
+		{ VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, VK_ACCESS_INDIRECT_COMMAND_READ_BIT },
+		{ VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT },
+		{ VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT },
+	} };
+
+	//Writes of the source stages are made visible to reads of the destination stages
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.pNext = nullptr;
+
+	VkPipelineStageFlags srcStageMask = 0;
+	VkPipelineStageFlags dstStageMask = 0;
+	for (uint8_t i = 0; i < to_underlying(PipelineStage::COUNT); ++i)
+	{
+		const PipelineStage stage = static_cast<PipelineStage>(i);
+		if (srcStages.test(stage))
+		{
+			srcStageMask |= STAGE_ACCESS[i].stage;
+			barrier.srcAccessMask |= STAGE_ACCESS[i].write;
+		}
+		if (dstStages.test(stage))
+		{
+			dstStageMask |= STAGE_ACCESS[i].stage;
+			barrier.dstAccessMask |= STAGE_ACCESS[i].read;
+		}
+	}
+
+	CORE_ASSERT(srcStageMask && dstStageMask, "Barriers need at least one source and destination stage");
+	vkCmdPipelineBarrier(m_commandBuffer, srcStageMask, dstStageMask, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	++m_stats.recorded;
 }
 
 void VulkanCommandBuffer::ResetCommands()
 {
 	VK_CHECK(vkResetCommandBuffer(m_commandBuffer, 0));
+	m_bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	InvalidateState();
+	m_stats = CommandBufferStats();
+}
+
+void VulkanCommandBuffer::InvalidateState()
+{
+	m_boundState = BoundState();
+}
+
+const CommandBufferStats& VulkanCommandBuffer::GetStats() const
+{
+	return m_stats;
 }
 
 const VkCommandBuffer& VulkanCommandBuffer::GetCommandBuffer() const
@@ -4,6 +4,7 @@
 #include "vk/vulkanRenderer.h"
 #include "vk/vulkanBuffer.h"
 #include "vk/vulkanInitialiser.h"
+#include "vk/vulkanUtils.h"
 
 using namespace SC;
 
@@ -17,6 +18,12 @@ namespace
 			return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		case DescriptorBindingType::SAMPLER:
 			return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		case DescriptorBindingType::STORAGE:
+			return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		case DescriptorBindingType::UNIFORM_DYNAMIC:
+			return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		case DescriptorBindingType::STORAGE_DYNAMIC:
+			return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
 		}
 
 		CORE_ASSERT(false, "Type not supported");
@@ -60,10 +67,7 @@ void VulkanDescriptorSetLayout::Init()
 
 		binding.descriptorType = convertType(m_bindings[j].type);
 
-		if (m_bindings[j].shaderStages.test(ShaderStage::VERTEX))
-			binding.stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
-		if (m_bindings[j].shaderStages.test(ShaderStage::FRAGMENT))
-			binding.stageFlags |= VK_SHADER_STAGE_FRAGMENT_BIT;
+		binding.stageFlags = vkutils::ConvertShaderStages(m_bindings[j].shaderStages);
 
 		vkSetBindings.push_back(binding);
 	}
@@ -84,8 +88,9 @@ void VulkanDescriptorSetLayout::Init()
 	CORE_ASSERT(m_layout, "Failed to create layout");
 
 	m_deletionQueue.push_function([=]() {
-		renderer->WaitOnFences();
-		vkDestroyDescriptorSetLayout(renderer->m_device, m_layout, nullptr);
+		renderer->DeferDestroy([renderer, layout = m_layout]() {
+			vkDestroyDescriptorSetLayout(renderer->m_device, layout, nullptr);
+			});
 		});
 }
 
@@ -123,17 +128,19 @@ m_descriptorSet(VK_NULL_HANDLE)
 	CORE_ASSERT(m_descriptorSet, "Failed to create descriptor set");
 
 	m_deletionQueue.push_function([=]() {
-		renderer->WaitOnFences();
-		vkFreeDescriptorSets(renderer->m_device, renderer->m_descriptorPool, 1, &m_descriptorSet);
+		renderer->DeferDestroy([renderer, descriptorSet = m_descriptorSet]() {
+			vkFreeDescriptorSets(renderer->m_device, renderer->m_descriptorPool, 1, &descriptorSet);
+			});
 		});
 
 	CreateSamplers();
 }
 
-void VulkanDescriptorSet::SetBuffer(const Buffer* buffer, uint32_t binding)
+void VulkanDescriptorSet::SetBuffer(const Buffer* buffer, uint32_t binding, size_t offset, size_t range)
 {
 	CORE_ASSERT(buffer, "Buffer can't be null");
 	CORE_ASSERT(binding >= 0 && binding < m_layout->Bindings().size(), "binding index out of range");
+	CORE_ASSERT(offset + range <= buffer->GetSize(), "Buffer range out of bounds");
 
 	const App* app = App::Instance();
 	CORE_ASSERT(app, "App instance is null");
@@ -146,10 +153,8 @@ void VulkanDescriptorSet::SetBuffer(const Buffer* buffer, uint32_t binding)
 	VkDescriptorBufferInfo binfo;
 	//it will be the camera buffer
 	binfo.buffer = *static_cast<const VulkanBuffer*>(buffer)->GetBuffer();
-	//at 0 offset
-	binfo.offset = 0;
-	//of the size of a camera data struct
-	binfo.range = buffer->GetSize();
+	binfo.offset = offset;
+	binfo.range = range > 0 ? range : buffer->GetSize() - offset;
 
 	VkWriteDescriptorSet setWrite = {};
 	setWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -209,8 +214,9 @@ void VulkanDescriptorSet::CreateSamplers()
 		vkCreateSampler(renderer->m_device, &samplerInfo, nullptr, &m_samplers[i]);
 
 		m_deletionQueue.push_function([=]() {
-			renderer->WaitOnFences();
-			vkDestroySampler(renderer->m_device, m_samplers[i], nullptr);
+			renderer->DeferDestroy([renderer, sampler = m_samplers[i]]() {
+				vkDestroySampler(renderer->m_device, sampler, nullptr);
+				});
 			});
 	}
 }
@@ -196,11 +196,7 @@ bool VulkanPipelineLayout::Build()
 		//this push constant range takes up the size of a MeshPushConstants struct
 		pushConstants[i].size = m_pushConstants[i].size;
 		//this push constant range is accessible only in the vertex shader
-		pushConstants[i].stageFlags = 0;
-		if(m_pushConstants[i].shaderStages.test(ShaderStage::VERTEX))
-			pushConstants[i].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
-		if (m_pushConstants[i].shaderStages.test(ShaderStage::FRAGMENT))
-			pushConstants[i].stageFlags |= VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstants[i].stageFlags = vkutils::ConvertShaderStages(m_pushConstants[i].shaderStages);
 
 		offset += pushConstants[i].size;
 	}
@@ -220,8 +216,9 @@ bool VulkanPipelineLayout::Build()
 	VK_CHECK(vkCreatePipelineLayout(renderer->m_device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout));
 
 	m_deletionQueue.push_function([=]() {
-		renderer->WaitOnFences();
-		vkDestroyPipelineLayout(renderer->m_device, m_pipelineLayout, nullptr);
+		renderer->DeferDestroy([renderer, pipelineLayout = m_pipelineLayout]() {
+			vkDestroyPipelineLayout(renderer->m_device, pipelineLayout, nullptr);
+			});
 		});
 
 	return true;
@@ -234,7 +231,8 @@ VkPipelineLayout VulkanPipelineLayout::GetPipelineLayout() const
 
 VulkanPipeline::VulkanPipeline(const ShaderModule& module) : Pipeline(module),
 	m_pipeline(VK_NULL_HANDLE),
-	m_tempPipelineLayout(VK_NULL_HANDLE)
+	m_tempPipelineLayout(VK_NULL_HANDLE),
+	m_bindPoint(VK_PIPELINE_BIND_POINT_GRAPHICS)
 {
 	
 }
@@ -256,7 +254,7 @@ bool VulkanPipeline::Build(const Renderpass* renderpass /*= nullptr*/)
 	CORE_ASSERT(vulkanRenderpass, "renderpass is null");
 	if (!vulkanRenderpass) return false;
 
-	ShaderModuleArray<VkShaderModule> modules;
+	ShaderModuleArray<VkShaderModule> modules{};
 	LoadShaderModule(renderer->m_device, *shaderModule, modules);
 
 	//build the stage-create-info for both vertex and fragment stages. This lets the pipeline know the shader modules per stage
@@ -269,8 +267,9 @@ bool VulkanPipeline::Build(const Renderpass* renderpass /*= nullptr*/)
 		VkPipelineLayoutCreateInfo pipeline_layout_info = vkinit::PipelineLayoutCreateInfo();
 		VK_CHECK(vkCreatePipelineLayout(renderer->m_device, &pipeline_layout_info, nullptr, &m_tempPipelineLayout));
 		m_deletionQueue.push_function([=]() {
-			renderer->WaitOnFences();
-			vkDestroyPipelineLayout(renderer->m_device, m_tempPipelineLayout, nullptr);
+			renderer->DeferDestroy([renderer, pipelineLayout = m_tempPipelineLayout]() {
+				vkDestroyPipelineLayout(renderer->m_device, pipelineLayout, nullptr);
+				});
 			});
 
 		//use temp layout for nw
@@ -281,6 +280,34 @@ bool VulkanPipeline::Build(const Renderpass* renderpass /*= nullptr*/)
 		pipelineBuilder._pipelineLayout = static_cast<const VulkanPipelineLayout*>(pipelineLayout)->GetPipelineLayout();
 	}
 
+	//Compute pipelines only need the shader and layout, none of the fixed function state below applies
+	VkShaderModule& computeModule = modules.at(to_underlying(ShaderStage::COMPUTE));
+	if (computeModule != VK_NULL_HANDLE)
+	{
+		VkComputePipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.pNext = nullptr;
+		pipelineInfo.stage = vkinit::PipelineShaderStageCreateInfo(VK_SHADER_STAGE_COMPUTE_BIT, computeModule);
+		pipelineInfo.layout = pipelineBuilder._pipelineLayout;
+
+		if (vkCreateComputePipelines(renderer->m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline) != VK_SUCCESS)
+		{
+			Log::PrintCore("Failed to create compute pipeline", LogSeverity::LogError);
+			m_pipeline = VK_NULL_HANDLE;
+		}
+
+		vkDestroyShaderModule(renderer->m_device, computeModule, nullptr);
+
+		m_bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+		m_deletionQueue.push_function([=]() {
+			renderer->DeferDestroy([renderer, pipeline = m_pipeline]() {
+				vkDestroyPipeline(renderer->m_device, pipeline, nullptr);
+				});
+		});
+
+		return m_pipeline != VK_NULL_HANDLE;
+	}
+
 	VkShaderModule& vertexModule = modules.at(to_underlying(ShaderStage::VERTEX));
 	if (vertexModule != VK_NULL_HANDLE)
 	{
@@ -435,8 +462,9 @@ bool VulkanPipeline::Build(const Renderpass* renderpass /*= nullptr*/)
 
 
 	m_deletionQueue.push_function([=]() {
-		renderer->WaitOnFences();
-		vkDestroyPipeline(renderer->m_device, m_pipeline, nullptr);
+		renderer->DeferDestroy([renderer, pipeline = m_pipeline]() {
+			vkDestroyPipeline(renderer->m_device, pipeline, nullptr);
+			});
 	});
 
 	return m_pipeline != VK_NULL_HANDLE;
@@ -451,3 +479,8 @@ VkPipeline VulkanPipeline::GetPipeline() const
 {
 	return m_pipeline;
 }
+
+VkPipelineBindPoint VulkanPipeline::GetBindPoint() const
+{
+	return m_bindPoint;
+}
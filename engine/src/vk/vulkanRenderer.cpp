@@ -22,12 +22,19 @@
 #include "vk/vulkanRenderpass.h"
 #include "render/commandbuffer.h"
 #include "vk/vulkanCommandbuffer.h"
+#include "render/frameAllocator.h"
+#include "render/geometryPool.h"
+#include "vk/vulkanUploadManager.h"
+#include <cstring>
 
 using namespace SC;
 
 VulkanRenderer::VulkanRenderer() : Renderer(GraphicsAPI::VULKAN),
 	m_instance(VK_NULL_HANDLE),
-	m_descriptorPool(VK_NULL_HANDLE)
+	m_transferQueue(VK_NULL_HANDLE),
+	m_transferQueueFamily(0),
+	m_descriptorPool(VK_NULL_HANDLE),
+	m_destroyImmediately(false)
 {
 }
 
@@ -51,6 +58,8 @@ void VulkanRenderer::Init()
 
 	InitDescriptors();
 
+	InitUploads();
+
 	Renderer::Init();
 }
 
@@ -60,8 +69,16 @@ void VulkanRenderer::Cleanup()
 
 	Log::PrintCore("Cleaning up Vulkan Renderer");
 
-	//Wait for rendering to finish before cleaning up
-	VK_CHECK(vkWaitForFences(m_device, 1, &GetCurrentFrame().m_renderFence, true, 10000000));
+	//Wait for rendering and uploads to finish before cleaning up, the uploads can still use resources that were destroyed
+	m_uploadManager->WaitIdle();
+	VK_CHECK(vkDeviceWaitIdle(m_device));
+
+	//Nothing is in flight anymore so resources can be destroyed straight away
+	{
+		std::lock_guard<std::mutex> lock(m_deferredDeletorMutex);
+		m_destroyImmediately = true;
+	}
+	DestroyRetiredResources(true);
 
 	m_swapChainDeletionQueue.flush();
 	m_mainDeletionQueue.flush();
@@ -101,6 +118,13 @@ void VulkanRenderer::BeginFrame()
 	VK_CHECK(vkWaitForFences(m_device, 1, &GetCurrentFrame().m_renderFence, true, timeout));
 	VK_CHECK(vkResetFences(m_device, 1, &GetCurrentFrame().m_renderFence));
 
+	//The GPU is done with this frame's secondary command buffers and allocations
+	for (const std::unique_ptr<CommandPool>& commandPool : GetCurrentFrame().m_secondaryCommandPools)
+		commandPool->Reset();
+	m_frameAllocator->BeginFrame(FrameDataIndex());
+	m_geometryPool->BeginFrame(FrameDataIndex());
+	DestroyRetiredResources(false);
+
 	//request image from the swapchain, one second timeout
 	VK_CHECK(vkAcquireNextImageKHR(m_device, m_swapchain, timeout, GetCurrentFrame().m_presentSemaphore, nullptr, &m_swapchainImageIndex));
 
@@ -150,7 +174,10 @@ void VulkanRenderer::EndFrame()
 
 	presentInfo.pImageIndices = &m_swapchainImageIndex;
 
-	VK_CHECK(vkQueuePresentKHR(m_graphicsQueue, &presentInfo));
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		VK_CHECK(vkQueuePresentKHR(m_graphicsQueue, &presentInfo));
+	}
 
 	m_currentFrame = m_currentFrame + 1 % std::numeric_limits<uint32_t>().max();
 }
@@ -188,6 +215,7 @@ void VulkanRenderer::InitVulkan()
 	vkb::PhysicalDeviceSelector selector{ vkb_inst };
 	vkb::PhysicalDevice physicalDevice = selector
 		.set_minimum_version(1, 1)
+		.add_desired_extension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)
 		.set_surface(m_surface)
 		.require_present()
 		.prefer_gpu_device_type(vkb::PreferredDeviceType::discrete)
@@ -197,6 +225,40 @@ void VulkanRenderer::InitVulkan()
 
 	Log::PrintCore(string_format("Device: {0}", physicalDevice.name));
 
+	//Desired extensions are enabled when the device has them
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(physicalDevice.physical_device, nullptr, &extensionCount, nullptr);
+	std::vector<VkExtensionProperties> extensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(physicalDevice.physical_device, nullptr, &extensionCount, extensions.data());
+	for (const VkExtensionProperties& extension : extensions)
+	{
+		if (strcmp(extension.extensionName, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0)
+			m_supportsDrawIndirectCount = true;
+	}
+
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(physicalDevice.physical_device, &supportedFeatures);
+
+	//Indirect draws need these to submit several draws per call and to offset each draw's instance data, the scene draws
+	//directly without them
+	if (supportedFeatures.multiDrawIndirect && supportedFeatures.drawIndirectFirstInstance)
+	{
+		physicalDevice.features.multiDrawIndirect = VK_TRUE;
+		physicalDevice.features.drawIndirectFirstInstance = VK_TRUE;
+		m_supportsMultiDrawIndirect = true;
+	}
+
+	//BC textures are optional, textures fall back to uncompressed formats without them
+	if (supportedFeatures.textureCompressionBC)
+	{
+		physicalDevice.features.textureCompressionBC = VK_TRUE;
+		m_supportsBlockCompression = true;
+	}
+
+	const VkPhysicalDeviceLimits& limits = physicalDevice.properties.limits;
+	m_uniformBufferAlignment = static_cast<size_t>(limits.minUniformBufferOffsetAlignment);
+	m_storageBufferAlignment = static_cast<size_t>(limits.minStorageBufferOffsetAlignment);
+
 	//create the final Vulkan device
 	vkb::DeviceBuilder deviceBuilder{ physicalDevice };
 	vkb::Device vkbDevice = deviceBuilder.build().value();
@@ -209,6 +271,19 @@ void VulkanRenderer::InitVulkan()
 	m_graphicsQueue = vkbDevice.get_queue(vkb::QueueType::graphics).value();
 	m_graphicsQueueFamily = vkbDevice.get_queue_index(vkb::QueueType::graphics).value();
 
+	//A family without graphics or compute is usually backed by the copy engines so uploads run alongside rendering
+	auto transferQueue = vkbDevice.get_dedicated_queue(vkb::QueueType::transfer);
+	if (transferQueue.has_value())
+	{
+		m_transferQueue = transferQueue.value();
+		m_transferQueueFamily = vkbDevice.get_dedicated_queue_index(vkb::QueueType::transfer).value();
+	}
+	else
+	{
+		m_transferQueue = m_graphicsQueue;
+		m_transferQueueFamily = m_graphicsQueueFamily;
+	}
+
 	//initialize the memory allocator
 	VmaAllocatorCreateInfo allocatorInfo = {};
 	allocatorInfo.physicalDevice = m_chosenGPU;
@@ -286,6 +361,8 @@ void VulkanRenderer::InitCommands()
 		m_frames[i].m_mainCommandBuffer = m_frames[i].m_commandPool->CreateCommandBuffer();
 
 		m_mainDeletionQueue.push_function([=]() {
+			m_frames[i].m_secondaryCommandBuffers.clear();
+			m_frames[i].m_secondaryCommandPools.clear();
 			m_frames[i].m_mainCommandBuffer.reset();
 			m_frames[i].m_commandPool.reset();
 			});
@@ -395,20 +472,47 @@ const SC::VulkanFrameData& VulkanRenderer::GetCurrentFrame() const
 	return m_frames.at(m_currentFrame % m_frames.size());
 }
 
-void VulkanRenderer::WaitOnFences() const
+void VulkanRenderer::DeferDestroy(std::function<void()>&& deletor) const
+{
+	std::unique_lock<std::mutex> lock(m_deferredDeletorMutex);
+	if (m_destroyImmediately)
+	{
+		lock.unlock();
+		deletor();
+		return;
+	}
+
+	//Pending uploads are submitted before or with this frame, so they have finished once its fence has signalled too
+	m_deferredDeletors.push_back({ m_currentFrame, std::move(deletor) });
+}
+
+void VulkanRenderer::DestroyRetiredResources(bool all)
 {
-	for (int i = 0; i < m_frames.size(); ++i)
+	std::lock_guard<std::mutex> lock(m_deferredDeletorMutex);
+
+	//The current frame's fence was last signalled by the frame FRAME_OVERLAP frames ago, every frame before it has finished too
+	while (!m_deferredDeletors.empty() && (all || m_deferredDeletors.front().frame + m_frames.size() <= m_currentFrame))
 	{
-		vkWaitForFences(m_device, 1, &m_frames[i].m_renderFence, true, 10000000);
+		m_deferredDeletors.front().deletor();
+		m_deferredDeletors.pop_front();
 	}
 }
 
+VulkanUploadManager& VulkanRenderer::GetUploadManager() const
+{
+	CORE_ASSERT(m_uploadManager, "Upload manager not created");
+	return *m_uploadManager;
+}
+
 void VulkanRenderer::InitDescriptors()
 {
 	//create a descriptor pool that will hold 10 uniform buffers
 	std::vector<VkDescriptorPoolSize> sizes =
 	{
 		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 10 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 100 },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1000 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 10 },
 		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4000 }
 	};
 
@@ -427,6 +531,15 @@ void VulkanRenderer::InitDescriptors()
 		});
 }
 
+void VulkanRenderer::InitUploads()
+{
+	m_uploadManager = std::make_unique<VulkanUploadManager>(this);
+
+	m_mainDeletionQueue.push_function([=]() {
+		m_uploadManager.reset();
+		});
+}
+
 void VulkanRenderer::ImmediateSubmit(std::function<void(VkCommandBuffer cmd)>&& function) const
 {
 	VkCommandBuffer cmd = m_uploadContext.m_commandBuffer;
@@ -445,7 +558,7 @@ void VulkanRenderer::ImmediateSubmit(std::function<void(VkCommandBuffer cmd)>&&
 
 	//submit command buffer to the queue and execute it.
 	// _uploadFence will now block until the graphic commands finish execution
-	VK_CHECK(vkQueueSubmit(m_graphicsQueue, 1, &submit, m_uploadContext.m_uploadFence));
+	QueueSubmit(m_graphicsQueue, submit, m_uploadContext.m_uploadFence);
 
 	vkWaitForFences(m_device, 1, &m_uploadContext.m_uploadFence, true, 9999999999);
 	vkResetFences(m_device, 1, &m_uploadContext.m_uploadFence);
@@ -465,6 +578,30 @@ CommandBuffer& VulkanRenderer::GetFrameCommandBuffer() const
 	return *m_frames[m_currentFrame % m_frames.size()].m_mainCommandBuffer;
 }
 
+void VulkanRenderer::ReserveSecondaryCommandBuffers(uint32_t count)
+{
+	for (VulkanFrameData& frame : m_frames)
+	{
+		while (frame.m_secondaryCommandBuffers.size() < count)
+		{
+			frame.m_secondaryCommandPools.push_back(CommandPool::Create());
+			frame.m_secondaryCommandBuffers.push_back(frame.m_secondaryCommandPools.back()->CreateCommandBuffer(CommandBufferLevel::SECONDARY));
+		}
+	}
+}
+
+CommandBuffer& VulkanRenderer::GetFrameSecondaryCommandBuffer(uint32_t index) const
+{
+	const VulkanFrameData& frame = m_frames[m_currentFrame % m_frames.size()];
+	CORE_ASSERT(index < frame.m_secondaryCommandBuffers.size(), "Secondary command buffer index out of range, reserve more command buffers");
+	return *frame.m_secondaryCommandBuffers[index];
+}
+
+uint32_t VulkanRenderer::SecondaryCommandBufferCount() const
+{
+	return static_cast<uint32_t>(m_frames[0].m_secondaryCommandBuffers.size());
+}
+
 void VulkanRenderer::SubmitCommandBuffer(const CommandBuffer& commandBuffer)
 {
 	//naming it cmd for shorter writing
@@ -474,19 +611,42 @@ void VulkanRenderer::SubmitCommandBuffer(const CommandBuffer& commandBuffer)
 	//we want to wait on the _presentSemaphore, as that semaphore is signaled when the swapchain is ready
 	//we will signal the _renderSemaphore, to signal that rendering has finished
 	VkSubmitInfo submit = vkinit::SubmitInfo(&cmd.GetCommandBuffer());
-	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 
-	submit.pWaitDstStageMask = &waitStage;
+	m_submitWaitSemaphores.clear();
+	m_submitWaitSemaphores.push_back(GetCurrentFrame().m_presentSemaphore);
+	m_submitWaitStages.clear();
+	m_submitWaitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
 
-	submit.waitSemaphoreCount = 1;
-	submit.pWaitSemaphores = &GetCurrentFrame().m_presentSemaphore;
+	//Submits the uploads recorded since the last frame, the frame waits for them before any of its commands run
+	m_uploadManager->FlushForFrame(FrameDataIndex(), m_submitWaitSemaphores);
+	m_submitWaitStages.resize(m_submitWaitSemaphores.size(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+	submit.pWaitDstStageMask = m_submitWaitStages.data();
+
+	submit.waitSemaphoreCount = static_cast<uint32_t>(m_submitWaitSemaphores.size());
+	submit.pWaitSemaphores = m_submitWaitSemaphores.data();
 
 	submit.signalSemaphoreCount = 1;
 	submit.pSignalSemaphores = &GetCurrentFrame().m_renderSemaphore;
 
 	//submit command buffer to the queue and execute it.
 	// _renderFence will now block until the graphic commands finish execution
-	VK_CHECK(vkQueueSubmit(m_graphicsQueue, 1, &submit, GetCurrentFrame().m_renderFence));
+	QueueSubmit(m_graphicsQueue, submit, GetCurrentFrame().m_renderFence);
+}
+
+void VulkanRenderer::SubmitAndWait(const CommandBuffer& commandBuffer)
+{
+	const VulkanCommandBuffer& cmd = static_cast<const VulkanCommandBuffer&>(commandBuffer);
+
+	//The commands may read data that is still being uploaded
+	m_uploadManager->WaitIdle();
+
+	//Nothing to wait on or signal, the upload fence tells us when it has finished
+	VkSubmitInfo submit = vkinit::SubmitInfo(&cmd.GetCommandBuffer());
+	QueueSubmit(m_graphicsQueue, submit, m_uploadContext.m_uploadFence);
+
+	vkWaitForFences(m_device, 1, &m_uploadContext.m_uploadFence, true, 9999999999);
+	vkResetFences(m_device, 1, &m_uploadContext.m_uploadFence);
 }
 
 SC::Renderpass* VulkanRenderer::DefaultRenderPass() const
@@ -498,3 +658,14 @@ SC::RenderTarget* VulkanRenderer::DefaultRenderTarget() const
 {
 	return m_swapChainRenderTargets[m_swapchainImageIndex].get();
 }
+
+SC::UploadStats VulkanRenderer::GetUploadStats() const
+{
+	return m_uploadManager->GetStats();
+}
+
+void VulkanRenderer::QueueSubmit(VkQueue queue, const VkSubmitInfo& submit, VkFence fence) const
+{
+	std::lock_guard<std::mutex> lock(m_queueMutex);
+	VK_CHECK(vkQueueSubmit(queue, 1, &submit, fence));
+}
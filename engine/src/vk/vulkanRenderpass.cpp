@@ -95,8 +95,9 @@ bool VulkanRenderpass::Build()
 	VK_CHECK(vkCreateRenderPass(renderer->m_device, &renderPassInfo, nullptr, &m_renderpass));
 	m_deletionQueue.push_function([=]()
 		{
-			renderer->WaitOnFences();
-			vkDestroyRenderPass(renderer->m_device, m_renderpass, nullptr);
+			renderer->DeferDestroy([renderer, renderpass = m_renderpass]() {
+				vkDestroyRenderPass(renderer->m_device, renderpass, nullptr);
+				});
 		});
 
 	return m_renderpass != VK_NULL_HANDLE;
@@ -5,30 +5,22 @@
 #include "vk/vulkanUtils.h"
 #include "vk/vulkanInitialiser.h"
 #include "vk/vulkanBuffer.h"
+#include "vk/vulkanUploadManager.h"
 #include "jaam.h"
 #include "vk/vulkanRenderpass.h"
+#include "render/mipChain.h"
 
 using namespace SC;
 
 namespace
 {
-	void generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels) 
+	//Records blits from each mip into the next starting with firstLevel - 1, which has to be in the transfer dst layout. The
+	//generated levels and the source are left in the shader read layout
+	void generateMipmaps(VkCommandBuffer commandBuffer, VkImage image, int32_t texWidth, int32_t texHeight, uint32_t firstLevel, uint32_t mipLevels) 
 	{
-
 		CORE_ASSERT(image != VK_NULL_HANDLE, "Image can't be null");
 		if (image == VK_NULL_HANDLE) return;
 
-		const App* app = App::Instance();
-		CORE_ASSERT(app, "App instance is null");
-		if (!app) return;
-
-		const VulkanRenderer* renderer = app->GetVulkanRenderer();
-		if (!renderer)
-			return;
-
-		renderer->ImmediateSubmit([&](VkCommandBuffer commandBuffer)
-			{
-
 		VkImageMemoryBarrier barrier{};
 		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 		barrier.image = image;
@@ -39,10 +31,10 @@ namespace
 		barrier.subresourceRange.layerCount = 1;
 		barrier.subresourceRange.levelCount = 1;
 
-		int32_t mipWidth = texWidth;
-		int32_t mipHeight = texHeight;
+		int32_t mipWidth = std::max(texWidth >> (firstLevel - 1), 1);
+		int32_t mipHeight = std::max(texHeight >> (firstLevel - 1), 1);
 
-		for (uint32_t i = 1; i < mipLevels; i++) {
+		for (uint32_t i = firstLevel; i < mipLevels; i++) {
 			barrier.subresourceRange.baseMipLevel = i - 1;
 			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
@@ -101,14 +93,40 @@ namespace
 			0, nullptr,
 			0, nullptr,
 			1, &barrier);
+	}
 
-
-		});
+	//One region per level for levels packed one after the other from stagingOffset, the first is width x height
+	std::vector<VkBufferImageCopy> BufferCopyRegions(Format format, uint32_t width, uint32_t height, uint32_t levelCount, VkDeviceSize stagingOffset)
+	{
+		std::vector<VkBufferImageCopy> copyRegions(levelCount);
+		VkDeviceSize levelOffset = stagingOffset;
+		for (uint32_t level = 0; level < levelCount; ++level)
+		{
+			const uint32_t levelWidth = std::max(width >> level, 1u);
+			const uint32_t levelHeight = std::max(height >> level, 1u);
+
+			VkBufferImageCopy& copyRegion = copyRegions[level];
+			copyRegion.bufferOffset = levelOffset;
+			copyRegion.bufferRowLength = 0;
+			copyRegion.bufferImageHeight = 0;
+
+			copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			copyRegion.imageSubresource.mipLevel = level;
+			copyRegion.imageSubresource.baseArrayLayer = 0;
+			copyRegion.imageSubresource.layerCount = 1;
+			copyRegion.imageExtent = { levelWidth, levelHeight, 1 };
+
+			//Block compressed levels are whole 4x4 blocks, the image extent stays the level's size in texels
+			levelOffset += ImageSize(format, levelWidth, levelHeight);
+		}
+		return copyRegions;
 	}
 }
 
 VulkanTexture::VulkanTexture(TextureType type, TextureUsage usage, Format format) : Texture(type, usage, format),
-m_mipLevels(0)
+m_image(VK_NULL_HANDLE),
+m_allocation(VK_NULL_HANDLE),
+m_imageView(VK_NULL_HANDLE)
 {
 }
 
@@ -152,12 +170,18 @@ bool VulkanTexture::Build(uint32_t width, uint32_t height, bool generateMipmaps)
 		return false;
 	}
 
-	if (generateMipmaps)
+	//Block compressed images can't be rendered to or blitted to, every mip level has to be uploaded instead
+	const bool blockCompressed = IsBlockCompressed(m_format);
+	if (blockCompressed)
+	{
+		CORE_ASSERT(m_usage == TextureUsage::COLOUR, "Block compressed formats can only be used for colour textures");
+		CORE_ASSERT(renderer->SupportsBlockCompression(), "Device doesn't support block compressed textures");
+		usageFlags &= ~VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	}
+	else if (generateMipmaps)
 		usageFlags |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 
-	m_mipLevels = generateMipmaps ?
-		static_cast<uint32_t>(std::floor(std::log2(std::max(imageExtent.width, imageExtent.height)))) + 1 :
-		1;
+	m_mipLevels = generateMipmaps ? MipLevelCount(width, height) : 1;
 
 	//the image will be an image with the format we selected and Depth Attachment usage flag
 	VkImageCreateInfo img_info = vkinit::ImageCreateInfo(imageFormat, usageFlags, imageExtent, m_mipLevels);
@@ -190,9 +214,10 @@ bool VulkanTexture::Build(uint32_t width, uint32_t height, bool generateMipmaps)
 
 	//add to deletion queues
 	m_deletionQueue.push_function([=]() {
-		renderer->WaitOnFences();
-		vkDestroyImageView(renderer->m_device, m_imageView, nullptr);
-		vmaDestroyImage(renderer->m_allocator, m_image, m_allocation);
+		renderer->DeferDestroy([renderer, imageView = m_imageView, image = m_image, allocation = m_allocation]() {
+			vkDestroyImageView(renderer->m_device, imageView, nullptr);
+			vmaDestroyImage(renderer->m_allocator, image, allocation);
+			});
 		});
 
 	return true;
@@ -208,6 +233,9 @@ bool VulkanTexture::LoadFromFile(const std::string& path)
 	if (!renderer)
 		return false;
 
+	CORE_ASSERT(!IsBlockCompressed(m_format), "Images are loaded as RGBA, compress them with CompressMipChain and use CopyData");
+	if (IsBlockCompressed(m_format)) return false;
+
 	ImageData imageData;
 	if (!ReadImageFromFile(path, imageData))
 		return false;
@@ -217,9 +245,10 @@ bool VulkanTexture::LoadFromFile(const std::string& path)
 
 	VkFormat image_format = vkutils::ConvertFormat(m_format);
 	VkExtent3D imageExtent{m_width,m_height,1};
-	const uint32_t miplevels = static_cast<uint32_t>(std::floor(std::log2(std::max(imageExtent.width, imageExtent.height)))) + 1;
+	m_mipLevels = MipLevelCount(m_width, m_height);
 
-	VkImageCreateInfo dimg_info = vkinit::ImageCreateInfo(image_format, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, imageExtent, miplevels);
+	//Mips are blitted from the level above so the image is also a transfer source
+	VkImageCreateInfo dimg_info = vkinit::ImageCreateInfo(image_format, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, imageExtent, m_mipLevels);
 	VmaAllocationCreateInfo dimg_allocinfo = {};
 	dimg_allocinfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 
@@ -227,27 +256,45 @@ bool VulkanTexture::LoadFromFile(const std::string& path)
 	//allocate and create the image
 	vmaCreateImage(renderer->m_allocator, &dimg_info, &dimg_allocinfo, &m_image, &m_allocation, nullptr);
 
-	CopyData(imageData.pixels.data(), imageData.Size());
+	const MipChain mipChain = GenerateMipChain(imageData.pixels.data(), m_width, m_height, true);
+	CopyData(mipChain.pixels.data(), mipChain.pixels.size(), static_cast<uint32_t>(mipChain.levels.size()));
 
-	VkImageViewCreateInfo imageinfo = vkinit::ImageviewCreateInfo(image_format, m_image, VK_IMAGE_ASPECT_COLOR_BIT, miplevels);
+	VkImageViewCreateInfo imageinfo = vkinit::ImageviewCreateInfo(image_format, m_image, VK_IMAGE_ASPECT_COLOR_BIT, m_mipLevels);
 	vkCreateImageView(renderer->m_device, &imageinfo, nullptr, &m_imageView);
 
 	m_deletionQueue.push_function([=]() {
-		renderer->WaitOnFences();
-		vkDestroyImageView(renderer->m_device, m_imageView, nullptr);
-		vmaDestroyImage(renderer->m_allocator, m_image, m_allocation);
+		renderer->DeferDestroy([renderer, imageView = m_imageView, image = m_image, allocation = m_allocation]() {
+			vkDestroyImageView(renderer->m_device, imageView, nullptr);
+			vmaDestroyImage(renderer->m_allocator, image, allocation);
+			});
 		});
 
 	return m_image != VK_NULL_HANDLE;
 }
 
-bool VulkanTexture::CopyData(const void* data, size_t size)
+bool VulkanTexture::CopyData(const void* data, size_t size, uint32_t mipLevelCount)
 {
 	//TODO check if texture has dst flag
 
 	CORE_ASSERT(m_image != VK_NULL_HANDLE, "Image can't be null");
 	if (m_image == VK_NULL_HANDLE) return false;
 
+	CORE_ASSERT(!m_streamed, "Streamed textures are updated with SetResidentMip");
+	if (m_streamed) return false;
+
+	CORE_ASSERT(mipLevelCount > 0 && mipLevelCount <= m_mipLevels, "Texture doesn't have that many mip levels");
+	mipLevelCount = std::clamp(mipLevelCount, 1u, m_mipLevels);
+
+	//Mips can't be blitted for block compressed formats so the whole chain has to be given
+	CORE_ASSERT(!IsBlockCompressed(m_format) || mipLevelCount == m_mipLevels, "Block compressed textures need every mip level");
+	if (IsBlockCompressed(m_format) && mipLevelCount != m_mipLevels) return false;
+
+	if (size < MipChainSize(m_format, m_width, m_height, mipLevelCount))
+	{
+		CORE_ASSERT(false, "Not enough data for the mip levels");
+		return false;
+	}
+
 	const App* app = App::Instance();
 	CORE_ASSERT(app, "App instance is null");
 	if (!app) return false;
@@ -256,67 +303,249 @@ bool VulkanTexture::CopyData(const void* data, size_t size)
 	if (!renderer)
 		return false;
 
-	BufferUsageSet stagingBufferUsage;
-	stagingBufferUsage.set(BufferUsage::TRANSFER_SRC);
-	stagingBufferUsage.set(BufferUsage::MAP);
-	VulkanBuffer stagingBuffer(size, stagingBufferUsage, AllocationUsage::HOST, data);
+	//Recorded into the upload manager's next batch, it stays on the graphics queue as the mip blits and the barrier to the
+	//fragment shader aren't supported on a transfer queue
+	renderer->GetUploadManager().Upload(UploadQueue::GRAPHICS, data, size, 16, [&](VkCommandBuffer cmd, VkBuffer stagingBuffer, VkDeviceSize stagingOffset) {
+		RecordCopy(cmd, stagingBuffer, stagingOffset, m_image, m_width, m_height, m_mipLevels, mipLevelCount);
+		});
 
-	//now copy from the staging buffer into the texture
-	renderer->ImmediateSubmit([&](VkCommandBuffer cmd) {
-		VkImageSubresourceRange range;
-		range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		range.baseMipLevel = 0;
-		range.levelCount = m_mipLevels;
-		range.baseArrayLayer = 0;
-		range.layerCount = 1;
+	return true;
+}
 
-		VkImageMemoryBarrier imageBarrier_toTransfer = {};
-		imageBarrier_toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+bool VulkanTexture::BuildStreamed(uint32_t width, uint32_t height)
+{
+	CORE_ASSERT(m_usage == TextureUsage::COLOUR, "Only colour textures can be streamed");
+	CORE_ASSERT(m_image == VK_NULL_HANDLE, "Texture is already built");
+	if (m_usage != TextureUsage::COLOUR || m_image != VK_NULL_HANDLE) return false;
 
-		imageBarrier_toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		imageBarrier_toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		imageBarrier_toTransfer.image = m_image;
-		imageBarrier_toTransfer.subresourceRange = range;
+	m_width = width;
+	m_height = height;
+	m_mipLevels = MipLevelCount(width, height);
+	m_residentMip = m_mipLevels; //Nothing is resident until SetResidentMip
+	m_streamed = true;
+	return true;
+}
 
-		imageBarrier_toTransfer.srcAccessMask = 0;
-		imageBarrier_toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+bool VulkanTexture::SetResidentMip(const void* data, size_t size, uint32_t residentMip)
+{
+	CORE_ASSERT(m_streamed, "Texture wasn't built with BuildStreamed");
+	CORE_ASSERT(residentMip < m_mipLevels, "Texture doesn't have that many mip levels");
+	if (!m_streamed || residentMip >= m_mipLevels) return false;
 
-		//barrier the image into the transfer-receive layout
-		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier_toTransfer);
+	if (residentMip == m_residentMip)
+		return true;
 
-		VkBufferImageCopy copyRegion = {};
-		copyRegion.bufferOffset = 0;
-		copyRegion.bufferRowLength = 0;
-		copyRegion.bufferImageHeight = 0;
+	const uint32_t width = std::max(m_width >> residentMip, 1u);
+	const uint32_t height = std::max(m_height >> residentMip, 1u);
+	const uint32_t levelCount = m_mipLevels - residentMip;
+	//Levels more detailed than the resident ones come from data, the rest are already on the GPU
+	const uint32_t uploadLevels = residentMip < m_residentMip ? m_residentMip - residentMip : 0;
+	const size_t uploadSize = MipChainSize(m_format, width, height, uploadLevels);
 
-		copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		copyRegion.imageSubresource.mipLevel = 0;
-		copyRegion.imageSubresource.baseArrayLayer = 0;
-		copyRegion.imageSubresource.layerCount = 1;
-		copyRegion.imageExtent = { m_width , m_height, 1};
+	if (uploadLevels > 0 && (!data || size < uploadSize))
+	{
+		CORE_ASSERT(false, "Not enough data for the mip levels");
+		return false;
+	}
 
-		//copy the buffer into the image
-		vkCmdCopyBufferToImage(cmd, *stagingBuffer.GetBuffer(), m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+	const App* app = App::Instance();
+	CORE_ASSERT(app, "App instance is null");
+	if (!app) return false;
 
-		//VkImageMemoryBarrier imageBarrier_toReadable = imageBarrier_toTransfer;
+	const VulkanRenderer* renderer = app->GetVulkanRenderer();
+	if (!renderer)
+		return false;
 
-		//imageBarrier_toReadable.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		//imageBarrier_toReadable.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	const VkFormat imageFormat = vkutils::ConvertFormat(m_format);
 
-		//imageBarrier_toReadable.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		//imageBarrier_toReadable.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	VkImage image;
+	VmaAllocation allocation;
+	//Transfer src so the levels can be copied to the next image when the resident mip changes again
+	VkImageCreateInfo imageInfo = vkinit::ImageCreateInfo(imageFormat, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+		{ width, height, 1 }, levelCount);
+	VmaAllocationCreateInfo allocInfo = {};
+	allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+	VK_CHECK(vmaCreateImage(renderer->m_allocator, &imageInfo, &allocInfo, &image, &allocation, nullptr));
 
-		////barrier the image into the shader readable layout
-		//vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier_toReadable);
-		});
+	VkImageView imageView;
+	VkImageViewCreateInfo viewInfo = vkinit::ImageviewCreateInfo(imageFormat, image, VK_IMAGE_ASPECT_COLOR_BIT, levelCount);
+	VK_CHECK(vkCreateImageView(renderer->m_device, &viewInfo, nullptr, &imageView));
 
-	VkFormat imageFormat = vkutils::ConvertFormat(m_format);
-	uint32_t mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(m_width, m_height)))) + 1;
-	generateMipmaps(m_image, imageFormat, m_width, m_height, mipLevels);
+	//Both lanes record on the graphics queue the frames sampling the old image were submitted to, so the copy out of it is
+	//ordered after them by its barrier
+	if (uploadLevels > 0)
+	{
+		renderer->GetUploadManager().Upload(UploadQueue::GRAPHICS, data, uploadSize, 16, [&](VkCommandBuffer cmd, VkBuffer stagingBuffer, VkDeviceSize stagingOffset) {
+			RecordResidentCopy(cmd, stagingBuffer, stagingOffset, image, residentMip);
+			});
+	}
+	else
+	{
+		renderer->GetUploadManager().Record(UploadQueue::GRAPHICS, [&](VkCommandBuffer cmd) {
+			RecordResidentCopy(cmd, VK_NULL_HANDLE, 0, image, residentMip);
+			});
+	}
+
+	if (m_image != VK_NULL_HANDLE)
+	{
+		renderer->DeferDestroy([renderer, imageView = m_imageView, image = m_image, allocation = m_allocation]() {
+			vkDestroyImageView(renderer->m_device, imageView, nullptr);
+			vmaDestroyImage(renderer->m_allocator, image, allocation);
+			});
+	}
+	else
+	{
+		//Destroys whichever image is resident when the texture is
+		m_deletionQueue.push_function([=]() {
+			renderer->DeferDestroy([renderer, imageView = m_imageView, image = m_image, allocation = m_allocation]() {
+				vkDestroyImageView(renderer->m_device, imageView, nullptr);
+				vmaDestroyImage(renderer->m_allocator, image, allocation);
+				});
+			});
+	}
 
+	m_image = image;
+	m_allocation = allocation;
+	m_imageView = imageView;
+	m_residentMip = residentMip;
+	++m_imageVersion;
 	return true;
 }
 
+void VulkanTexture::RecordResidentCopy(VkCommandBuffer cmd, VkBuffer stagingBuffer, VkDeviceSize stagingOffset, VkImage image, uint32_t residentMip) const
+{
+	const uint32_t width = std::max(m_width >> residentMip, 1u);
+	const uint32_t height = std::max(m_height >> residentMip, 1u);
+	const uint32_t levelCount = m_mipLevels - residentMip;
+	const uint32_t uploadLevels = residentMip < m_residentMip ? m_residentMip - residentMip : 0;
+	//First level of the texture that is copied from the old image
+	const uint32_t firstKeptLevel = std::max(residentMip, m_residentMip);
+
+	VkImageMemoryBarrier imageBarrier = {};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarrier.subresourceRange.baseArrayLayer = 0;
+	imageBarrier.subresourceRange.layerCount = 1;
+
+	std::array<VkImageMemoryBarrier, 2> toTransfer = { imageBarrier, imageBarrier };
+	toTransfer[0].image = image;
+	toTransfer[0].subresourceRange.baseMipLevel = 0;
+	toTransfer[0].subresourceRange.levelCount = levelCount;
+	toTransfer[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	toTransfer[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	toTransfer[0].srcAccessMask = 0;
+	toTransfer[0].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+	//The old image is only read, the fragment shader reads of earlier frames just have to finish before its layout changes
+	const bool copyKept = m_image != VK_NULL_HANDLE && firstKeptLevel < m_mipLevels;
+	toTransfer[1].image = m_image;
+	toTransfer[1].subresourceRange.baseMipLevel = firstKeptLevel - m_residentMip;
+	toTransfer[1].subresourceRange.levelCount = m_mipLevels - firstKeptLevel;
+	toTransfer[1].oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	toTransfer[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	toTransfer[1].srcAccessMask = 0;
+	toTransfer[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+		copyKept ? 2 : 1, toTransfer.data());
+
+	if (uploadLevels > 0)
+	{
+		const std::vector<VkBufferImageCopy> copyRegions = BufferCopyRegions(m_format, width, height, uploadLevels, stagingOffset);
+		vkCmdCopyBufferToImage(cmd, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, uploadLevels, copyRegions.data());
+	}
+
+	if (copyKept)
+	{
+		std::vector<VkImageCopy> copyRegions(m_mipLevels - firstKeptLevel);
+		for (uint32_t level = firstKeptLevel; level < m_mipLevels; ++level)
+		{
+			VkImageCopy& copyRegion = copyRegions[level - firstKeptLevel];
+			copyRegion.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - m_residentMip, 0, 1 };
+			copyRegion.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - residentMip, 0, 1 };
+			copyRegion.extent = { std::max(m_width >> level, 1u), std::max(m_height >> level, 1u), 1 };
+		}
+		vkCmdCopyImage(cmd, m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+	}
+
+	//Both images are left readable, the old one can still be bound by descriptor sets that haven't been written again
+	std::array<VkImageMemoryBarrier, 2> toReadable = toTransfer;
+	toReadable[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	toReadable[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	toReadable[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	toReadable[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	toReadable[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	toReadable[1].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	toReadable[1].srcAccessMask = 0;
+	toReadable[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+		copyKept ? 2 : 1, toReadable.data());
+}
+
+void VulkanTexture::RecordCopy(VkCommandBuffer cmd, VkBuffer stagingBuffer, VkDeviceSize stagingOffset, VkImage image,
+	uint32_t width, uint32_t height, uint32_t imageLevels, uint32_t mipLevelCount) const
+{
+	VkImageSubresourceRange range;
+	range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	range.baseMipLevel = 0;
+	range.levelCount = imageLevels;
+	range.baseArrayLayer = 0;
+	range.layerCount = 1;
+
+	VkImageMemoryBarrier imageBarrier_toTransfer = {};
+	imageBarrier_toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+
+	imageBarrier_toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageBarrier_toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	imageBarrier_toTransfer.image = image;
+	imageBarrier_toTransfer.subresourceRange = range;
+
+	imageBarrier_toTransfer.srcAccessMask = 0;
+	imageBarrier_toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+	//barrier the image into the transfer-receive layout
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier_toTransfer);
+
+	//Every level given is copied by one command, the levels are packed one after the other in the staging memory
+	const std::vector<VkBufferImageCopy> copyRegions = BufferCopyRegions(m_format, width, height, mipLevelCount, stagingOffset);
+
+	//copy the buffer into the image
+	vkCmdCopyBufferToImage(cmd, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevelCount, copyRegions.data());
+
+	if (mipLevelCount < imageLevels)
+	{
+		//The levels before the last one given aren't read by the blits
+		if (mipLevelCount > 1)
+		{
+			VkImageMemoryBarrier imageBarrier_toReadable = imageBarrier_toTransfer;
+			imageBarrier_toReadable.subresourceRange.levelCount = mipLevelCount - 1;
+			imageBarrier_toReadable.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			imageBarrier_toReadable.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			imageBarrier_toReadable.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			imageBarrier_toReadable.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier_toReadable);
+		}
+
+		generateMipmaps(cmd, image, width, height, mipLevelCount, imageLevels);
+		return;
+	}
+
+	VkImageMemoryBarrier imageBarrier_toReadable = imageBarrier_toTransfer;
+
+	imageBarrier_toReadable.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	imageBarrier_toReadable.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	imageBarrier_toReadable.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	imageBarrier_toReadable.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	//barrier the image into the shader readable layout
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier_toReadable);
+}
+
 VulkanRenderTarget::VulkanRenderTarget(std::vector<Format>&& attachmentFormats, uint32_t width, uint32_t height) : 
 	RenderTarget(std::move(attachmentFormats), width, height)
 {
@@ -355,8 +584,9 @@ bool VulkanRenderTarget::Build(Renderpass* renderPass)
 	VK_CHECK(vkCreateFramebuffer(renderer->m_device, &fb_info, nullptr, &m_framebuffer));
 
 	m_deletionQueue.push_function([=]() {
-		renderer->WaitOnFences();
-		vkDestroyFramebuffer(renderer->m_device, m_framebuffer, nullptr);
+		renderer->DeferDestroy([renderer, framebuffer = m_framebuffer]() {
+			vkDestroyFramebuffer(renderer->m_device, framebuffer, nullptr);
+			});
 		});
 
 	return true;
@@ -0,0 +1,405 @@
+#include "pch.h"
+#include "vk/vulkanUploadManager.h"
+#include "vk/vulkanRenderer.h"
+#include "vk/vulkanInitialiser.h"
+#include "core/log.h"
+#include <cstring>
+
+using namespace SC;
+
+namespace
+{
+	VkDeviceSize NextPowerOfTwo(VkDeviceSize value)
+	{
+		VkDeviceSize result = 1;
+		while (result < value)
+			result <<= 1;
+		return result;
+	}
+}
+
+VulkanUploadManager::VulkanUploadManager(const VulkanRenderer* renderer) :
+	m_renderer(renderer),
+	m_laneIndices{ 0, 0 },
+	m_pooledStagingInUse(0)
+{
+	CORE_ASSERT(m_renderer, "Renderer can't be null");
+
+	const bool hasTransferQueue = m_renderer->m_transferQueueFamily != m_renderer->m_graphicsQueueFamily;
+	m_lanes.resize(hasTransferQueue ? 2 : 1);
+
+	CreateLane(m_lanes[0], m_renderer->m_graphicsQueue, m_renderer->m_graphicsQueueFamily);
+	m_laneIndices[to_underlying(UploadQueue::GRAPHICS)] = 0;
+	m_laneIndices[to_underlying(UploadQueue::TRANSFER)] = 0;
+
+	if (hasTransferQueue)
+	{
+		CreateLane(m_lanes[1], m_renderer->m_transferQueue, m_renderer->m_transferQueueFamily);
+		m_laneIndices[to_underlying(UploadQueue::TRANSFER)] = 1;
+	}
+
+	Log::PrintCore(string_format("Uploads use {0}", hasTransferQueue ? "a dedicated transfer queue" : "the graphics queue"));
+}
+
+VulkanUploadManager::~VulkanUploadManager()
+{
+	WaitIdle();
+
+	for (Lane& lane : m_lanes)
+		DestroyLane(lane);
+}
+
+void VulkanUploadManager::Upload(UploadQueue queue, const void* data, VkDeviceSize size, VkDeviceSize alignment, RecordFunc record)
+{
+	CORE_ASSERT(data && size > 0, "Nothing to upload");
+	CORE_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0, "Alignment must be a power of two");
+	if (!data || size == 0) return;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Lane& lane = GetLane(queue);
+
+	++m_stats.uploads;
+	m_stats.bytes += size;
+
+	if (size > STAGING_RING_CAPACITY)
+	{
+		//Too large for the ring, the staging buffer goes back to the pool once the batch has finished
+		StagingBuffer stagingBuffer = AcquirePooledStaging(lane, size);
+		memcpy(stagingBuffer.data, data, size);
+		VK_CHECK(vmaFlushAllocation(m_renderer->m_allocator, stagingBuffer.allocation, 0, size));
+
+		VkCommandBuffer cmd = BeginBatch(lane);
+		record(cmd, stagingBuffer.buffer, 0);
+		lane.batches[lane.currentBatch].pooledStaging.push_back(stagingBuffer);
+		UpdateStagingPeak();
+		return;
+	}
+
+	uint64_t position = 0;
+	while (!TryAllocateStaging(lane, size, alignment, position))
+	{
+		//The ring is full of data the GPU hasn't copied yet, submit what is recorded and wait for the oldest batch
+		if (lane.batches[lane.currentBatch].recording)
+		{
+			SubmitBatch(lane, VK_NULL_HANDLE);
+		}
+		else if (!lane.submittedBatches.empty())
+		{
+			++m_stats.stalls;
+			RetireOldestBatch(lane);
+		}
+		else
+		{
+			//Nothing in flight, start from the beginning so an allocation as large as the ring fits
+			lane.ringHead = 0;
+			lane.ringTail = 0;
+		}
+	}
+
+	const VkDeviceSize offset = position % STAGING_RING_CAPACITY;
+	memcpy(lane.ring.data + offset, data, size);
+	//Does nothing when the memory is host coherent
+	VK_CHECK(vmaFlushAllocation(m_renderer->m_allocator, lane.ring.allocation, offset, size));
+
+	VkCommandBuffer cmd = BeginBatch(lane);
+	record(cmd, lane.ring.buffer, offset);
+	lane.batches[lane.currentBatch].ringEnd = lane.ringHead;
+	UpdateStagingPeak();
+}
+
+void VulkanUploadManager::Record(UploadQueue queue, FunctionRef<void(VkCommandBuffer cmd)> record)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Lane& lane = GetLane(queue);
+
+	++m_stats.uploads;
+	record(BeginBatch(lane));
+}
+
+void VulkanUploadManager::Flush()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	FlushLocked();
+}
+
+void VulkanUploadManager::FlushForFrame(uint8_t frameIndex, std::vector<VkSemaphore>& waitSemaphores)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (Lane& lane : m_lanes)
+	{
+		CORE_ASSERT(frameIndex < lane.frameSemaphores.size(), "Invalid frame index");
+		VkSemaphore semaphore = lane.frameSemaphores[frameIndex];
+
+		if (lane.batches[lane.currentBatch].recording)
+		{
+			SubmitBatch(lane, semaphore);
+		}
+		else if (lane.needsFrameSync)
+		{
+			//Batches were submitted without a semaphore, an empty submission signals once they have finished
+			VkSubmitInfo submit = vkinit::SubmitInfo(nullptr);
+			submit.commandBufferCount = 0;
+			submit.signalSemaphoreCount = 1;
+			submit.pSignalSemaphores = &semaphore;
+			m_renderer->QueueSubmit(lane.queue, submit, VK_NULL_HANDLE);
+		}
+		else
+		{
+			continue;
+		}
+
+		lane.needsFrameSync = false;
+		waitSemaphores.push_back(semaphore);
+	}
+}
+
+void VulkanUploadManager::WaitIdle()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	FlushLocked();
+
+	for (Lane& lane : m_lanes)
+	{
+		while (!lane.submittedBatches.empty())
+			RetireOldestBatch(lane);
+	}
+}
+
+bool VulkanUploadManager::HasTransferQueue() const
+{
+	return m_lanes.size() > 1;
+}
+
+UploadStats VulkanUploadManager::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	UploadStats stats = m_stats;
+	stats.stagingInUse = m_pooledStagingInUse;
+	for (const Lane& lane : m_lanes)
+		stats.stagingInUse += static_cast<size_t>(lane.ringHead - lane.ringTail);
+	return stats;
+}
+
+VulkanUploadManager::Lane& VulkanUploadManager::GetLane(UploadQueue queue)
+{
+	return m_lanes[m_laneIndices[to_underlying(queue)]];
+}
+
+void VulkanUploadManager::CreateLane(Lane& lane, VkQueue queue, uint32_t queueFamily)
+{
+	const VkDevice device = m_renderer->m_device;
+
+	lane.queue = queue;
+	lane.queueFamily = queueFamily;
+	lane.ring = CreateStagingBuffer(STAGING_RING_CAPACITY);
+
+	VkCommandPoolCreateInfo commandPoolInfo = vkinit::CommandPoolCreateInfo(queueFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+	VkFenceCreateInfo fenceInfo = vkinit::FenceCreateInfo();
+	for (Batch& batch : lane.batches)
+	{
+		VK_CHECK(vkCreateCommandPool(device, &commandPoolInfo, nullptr, &batch.commandPool));
+		VkCommandBufferAllocateInfo cmdAllocInfo = vkinit::CommandBufferAllocateInfo(batch.commandPool, 1);
+		VK_CHECK(vkAllocateCommandBuffers(device, &cmdAllocInfo, &batch.commandBuffer));
+		VK_CHECK(vkCreateFence(device, &fenceInfo, nullptr, &batch.fence));
+	}
+
+	VkSemaphoreCreateInfo semaphoreInfo = vkinit::SemaphoreCreateInfo();
+	lane.frameSemaphores.resize(m_renderer->FrameDataIndexCount());
+	for (VkSemaphore& semaphore : lane.frameSemaphores)
+		VK_CHECK(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore));
+}
+
+void VulkanUploadManager::DestroyLane(Lane& lane)
+{
+	const VkDevice device = m_renderer->m_device;
+
+	for (Batch& batch : lane.batches)
+	{
+		for (StagingBuffer& stagingBuffer : batch.pooledStaging)
+			DestroyStagingBuffer(stagingBuffer);
+		batch.pooledStaging.clear();
+
+		vkDestroyFence(device, batch.fence, nullptr);
+		vkDestroyCommandPool(device, batch.commandPool, nullptr);
+	}
+
+	for (VkSemaphore semaphore : lane.frameSemaphores)
+		vkDestroySemaphore(device, semaphore, nullptr);
+	lane.frameSemaphores.clear();
+
+	for (auto& [size, stagingBuffers] : lane.freeStaging)
+	{
+		for (StagingBuffer& stagingBuffer : stagingBuffers)
+			DestroyStagingBuffer(stagingBuffer);
+	}
+	lane.freeStaging.clear();
+
+	DestroyStagingBuffer(lane.ring);
+}
+
+VulkanUploadManager::StagingBuffer VulkanUploadManager::CreateStagingBuffer(VkDeviceSize size)
+{
+	VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	bufferInfo.size = size;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+	VmaAllocationCreateInfo allocInfo = {};
+	allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+	allocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+	StagingBuffer stagingBuffer;
+	VmaAllocationInfo allocationInfo = {};
+	VK_CHECK(vmaCreateBuffer(m_renderer->m_allocator, &bufferInfo, &allocInfo, &stagingBuffer.buffer, &stagingBuffer.allocation, &allocationInfo));
+	stagingBuffer.data = static_cast<uint8_t*>(allocationInfo.pMappedData);
+	stagingBuffer.size = size;
+
+	m_stats.stagingAllocated += static_cast<size_t>(size);
+	return stagingBuffer;
+}
+
+void VulkanUploadManager::DestroyStagingBuffer(StagingBuffer& stagingBuffer)
+{
+	if (stagingBuffer.buffer == VK_NULL_HANDLE) return;
+
+	vmaDestroyBuffer(m_renderer->m_allocator, stagingBuffer.buffer, stagingBuffer.allocation);
+	m_stats.stagingAllocated -= static_cast<size_t>(stagingBuffer.size);
+	stagingBuffer = StagingBuffer();
+}
+
+VulkanUploadManager::StagingBuffer VulkanUploadManager::AcquirePooledStaging(Lane& lane, VkDeviceSize size)
+{
+	//Rounding up lets uploads of similar sizes reuse each other's buffers
+	const VkDeviceSize bucketSize = NextPowerOfTwo(size);
+
+	StagingBuffer stagingBuffer;
+	auto it = lane.freeStaging.find(bucketSize);
+	if (it != lane.freeStaging.end() && !it->second.empty())
+	{
+		stagingBuffer = it->second.back();
+		it->second.pop_back();
+	}
+	else
+	{
+		stagingBuffer = CreateStagingBuffer(bucketSize);
+	}
+
+	m_pooledStagingInUse += static_cast<size_t>(stagingBuffer.size);
+	return stagingBuffer;
+}
+
+void VulkanUploadManager::ReleasePooledStaging(Lane& lane, StagingBuffer& stagingBuffer)
+{
+	m_pooledStagingInUse -= static_cast<size_t>(stagingBuffer.size);
+
+	std::vector<StagingBuffer>& freeStaging = lane.freeStaging[stagingBuffer.size];
+	if (freeStaging.size() < MAX_FREE_STAGING_PER_SIZE)
+	{
+		freeStaging.push_back(stagingBuffer);
+		stagingBuffer = StagingBuffer();
+	}
+	else
+	{
+		DestroyStagingBuffer(stagingBuffer);
+	}
+}
+
+void VulkanUploadManager::UpdateStagingPeak()
+{
+	size_t inUse = m_pooledStagingInUse;
+	for (const Lane& lane : m_lanes)
+		inUse += static_cast<size_t>(lane.ringHead - lane.ringTail);
+
+	m_stats.stagingPeak = std::max(m_stats.stagingPeak, inUse);
+}
+
+bool VulkanUploadManager::TryAllocateStaging(Lane& lane, VkDeviceSize size, VkDeviceSize alignment, uint64_t& position) const
+{
+	uint64_t begin = AlignUp(lane.ringHead, alignment);
+
+	//Allocations don't wrap, skip to the start of the ring when it doesn't fit before the end
+	const uint64_t offset = begin % STAGING_RING_CAPACITY;
+	if (offset + size > STAGING_RING_CAPACITY)
+		begin += STAGING_RING_CAPACITY - offset;
+
+	if (begin + size - lane.ringTail > STAGING_RING_CAPACITY)
+		return false;
+
+	lane.ringHead = begin + size;
+	position = begin;
+	return true;
+}
+
+VkCommandBuffer VulkanUploadManager::BeginBatch(Lane& lane)
+{
+	Batch& batch = lane.batches[lane.currentBatch];
+	if (batch.recording)
+		return batch.commandBuffer;
+
+	//Batches are reused in order so the oldest in flight is this one
+	while (batch.submitted)
+	{
+		++m_stats.stalls;
+		RetireOldestBatch(lane);
+	}
+
+	VK_CHECK(vkResetCommandPool(m_renderer->m_device, batch.commandPool, 0));
+
+	VkCommandBufferBeginInfo cmdBeginInfo = vkinit::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	VK_CHECK(vkBeginCommandBuffer(batch.commandBuffer, &cmdBeginInfo));
+
+	batch.ringEnd = lane.ringHead;
+	batch.recording = true;
+	return batch.commandBuffer;
+}
+
+void VulkanUploadManager::SubmitBatch(Lane& lane, VkSemaphore signalSemaphore)
+{
+	Batch& batch = lane.batches[lane.currentBatch];
+	CORE_ASSERT(batch.recording, "Batch isn't being recorded");
+
+	VK_CHECK(vkEndCommandBuffer(batch.commandBuffer));
+
+	VkSubmitInfo submit = vkinit::SubmitInfo(&batch.commandBuffer);
+	if (signalSemaphore != VK_NULL_HANDLE)
+	{
+		submit.signalSemaphoreCount = 1;
+		submit.pSignalSemaphores = &signalSemaphore;
+	}
+	m_renderer->QueueSubmit(lane.queue, submit, batch.fence);
+
+	batch.recording = false;
+	batch.submitted = true;
+	lane.submittedBatches.push_back(lane.currentBatch);
+	lane.currentBatch = (lane.currentBatch + 1) % BATCHES_PER_QUEUE;
+	lane.needsFrameSync = signalSemaphore == VK_NULL_HANDLE;
+	++m_stats.batches;
+}
+
+void VulkanUploadManager::RetireOldestBatch(Lane& lane)
+{
+	CORE_ASSERT(!lane.submittedBatches.empty(), "No batch to retire");
+
+	Batch& batch = lane.batches[lane.submittedBatches.front()];
+	lane.submittedBatches.pop_front();
+
+	VK_CHECK(vkWaitForFences(m_renderer->m_device, 1, &batch.fence, true, UINT64_MAX));
+	VK_CHECK(vkResetFences(m_renderer->m_device, 1, &batch.fence));
+
+	for (StagingBuffer& stagingBuffer : batch.pooledStaging)
+		ReleasePooledStaging(lane, stagingBuffer);
+	batch.pooledStaging.clear();
+
+	lane.ringTail = batch.ringEnd;
+	batch.submitted = false;
+}
+
+void VulkanUploadManager::FlushLocked()
+{
+	for (Lane& lane : m_lanes)
+	{
+		if (lane.batches[lane.currentBatch].recording)
+			SubmitBatch(lane, VK_NULL_HANDLE);
+	}
+}
@@ -30,6 +30,20 @@ VkFormat vkutils::ConvertFormat(Format format)
 		return VK_FORMAT_R32G32B32_SFLOAT;
 	case SC::Format::R32G32B32A32_SFLOAT:
 		return VK_FORMAT_R32G32B32A32_SFLOAT;
+	case SC::Format::BC1_RGB_UNORM:
+		return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	case SC::Format::BC1_RGB_SRGB:
+		return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+	case SC::Format::BC3_UNORM:
+		return VK_FORMAT_BC3_UNORM_BLOCK;
+	case SC::Format::BC3_SRGB:
+		return VK_FORMAT_BC3_SRGB_BLOCK;
+	case SC::Format::BC5_UNORM:
+		return VK_FORMAT_BC5_UNORM_BLOCK;
+	case SC::Format::BC7_UNORM:
+		return VK_FORMAT_BC7_UNORM_BLOCK;
+	case SC::Format::BC7_SRGB:
+		return VK_FORMAT_BC7_SRGB_BLOCK;
 	default:
 		CORE_ASSERT(false, "format not valid");
 			return VK_FORMAT_UNDEFINED;
@@ -95,3 +109,15 @@ VkImageLayout vkutils::ConvertImageLayout(SC::ImageLayout layout)
 		return VK_IMAGE_LAYOUT_UNDEFINED;
 	}
 }
+
+VkShaderStageFlags vkutils::ConvertShaderStages(const SC::ShaderModuleFlags& stages)
+{
+	VkShaderStageFlags flags = 0;
+	if (stages.test(ShaderStage::VERTEX))
+		flags |= VK_SHADER_STAGE_VERTEX_BIT;
+	if (stages.test(ShaderStage::FRAGMENT))
+		flags |= VK_SHADER_STAGE_FRAGMENT_BIT;
+	if (stages.test(ShaderStage::COMPUTE))
+		flags |= VK_SHADER_STAGE_COMPUTE_BIT;
+	return flags;
+}
@@ -0,0 +1,36 @@
+#version 450
+
+layout (location = 0) in vec3 vPosition;
+layout (location = 1) in vec3 vNormal;
+layout (location = 2) in vec2 vTexCoord;
+
+layout (location = 0) out vec2 outTexCoord;
+layout (location = 1) out vec3 outNormal;
+layout (location = 2) out vec3 outFragPos;
+
+struct Light
+{
+	vec4 position;	//w == 0 pointlight
+	vec4 intensities;  //w is intensity
+};
+
+layout(set = 1, binding = 0) uniform  SceneBuffer{
+	mat4 view;
+	vec4 eyePos;
+	int lightCount;
+	Light lightData[8];
+} sceneBuffer;
+
+//Model matrices of every object drawn this frame, gl_InstanceIndex starts at the draw's first instance
+layout(std430, set = 2, binding = 0) readonly buffer InstanceBuffer{
+	mat4 modelMatrices[];
+} instanceBuffer;
+
+void main()
+{
+	mat4 modelMatrix = instanceBuffer.modelMatrices[gl_InstanceIndex];
+	gl_Position = sceneBuffer.view * modelMatrix * vec4(vPosition, 1.0f);
+	outTexCoord = vTexCoord;
+	outNormal = mat3(transpose(inverse(modelMatrix))) * vNormal;  
+	outFragPos = vec3(modelMatrix * vec4(vPosition, 1.0));
+}
@@ -0,0 +1,929 @@
+#include "benchmarkLayer.h"
+#include <cstring>
+
+namespace
+{
+	constexpr uint32_t TRANSFORM_NODE_COUNT = 200000;
+	constexpr uint32_t TRANSFORM_WARMUP_ITERATIONS = 5;
+	constexpr uint32_t TRANSFORM_ITERATIONS = 50;
+
+	constexpr uint32_t KERNEL_MATRIX_COUNT = 100000;
+	constexpr uint32_t KERNEL_ITERATIONS = 50;
+
+	constexpr uint32_t CULLING_BOX_COUNT = 100000;
+	constexpr uint32_t CULLING_ITERATIONS = 50;
+
+	constexpr uint32_t BVH_BOX_COUNT = 200000;
+	constexpr uint32_t BVH_ITERATIONS = 10;
+	constexpr uint32_t BVH_MOVED_BOXES = BVH_BOX_COUNT / 100;
+
+	//Sphere tessellated into about Sponza's triangle count
+	constexpr uint32_t RAYCAST_SPHERE_SEGMENTS = 384;
+	constexpr uint32_t RAYCAST_RAY_COUNT = 1000;
+	constexpr uint32_t RAYCAST_BRUTE_FORCE_RAY_COUNT = 20;
+
+	constexpr uint32_t QUEUE_ITEM_COUNT = 100000;
+	constexpr uint32_t QUEUE_ITERATIONS = 20;
+	constexpr uint32_t QUEUE_PIPELINE_COUNT = 8;
+	constexpr uint32_t QUEUE_MATERIAL_COUNT = 300;
+	constexpr uint32_t QUEUE_MESH_COUNT = 2000;
+
+	constexpr std::array<uint32_t, 3> GPU_CULLING_OBJECT_COUNTS = { 10000, 100000, 1000000 };
+	constexpr uint32_t GPU_CULLING_ITERATIONS = 10;
+	constexpr uint32_t GPU_CULLING_BATCH_COUNT = 256;
+
+	//Draws are split evenly across the threads, each records into its own secondary command buffer and pool
+	constexpr uint32_t RECORDING_DRAW_COUNT = 100000;
+	//Two pipelines sharing a layout alternate, materials change every few draws within a pipeline run
+	constexpr uint32_t RECORDING_DRAWS_PER_PIPELINE = 64;
+	constexpr uint32_t RECORDING_DRAWS_PER_MATERIAL = 4;
+	constexpr uint32_t RECORDING_MATERIAL_COUNT = 32;
+	constexpr uint32_t RECORDING_ITERATIONS = 20;
+
+	//Every block blends two colours along a row or column, the shape the block formats are built to store
+	constexpr uint32_t COMPRESSION_TEXTURE_SIZE = 64;
+
+	constexpr uint32_t GRAPH_ITERATIONS = 20;
+	//Roughly the shape of Sponza, a model root with a flat list of mesh nodes
+	constexpr uint32_t GRAPH_MODEL_COUNT = 4;
+	constexpr uint32_t GRAPH_MESHES_PER_MODEL = 400;
+
+	void BuildRandomHierarchy(SC::SceneNode& root, std::vector<SC::SceneNode*>& nodes, uint32_t nodeCount)
+	{
+		//Fixed seed so every run benchmarks the same tree
+		std::srand(1337);
+		nodes.reserve(nodeCount);
+		for (uint32_t i = 0; i < nodeCount; ++i)
+		{
+			SC::SceneNode& parent = nodes.empty() || std::rand() % 16 == 0 ? root : *nodes[std::rand() % nodes.size()];
+
+			SC::SceneNode& node = parent.AddChild();
+			node.GetTransform().SetPosition(glm::vec3(std::rand() % 10, std::rand() % 10, std::rand() % 10));
+			node.GetTransform().SetRotation(glm::vec3(0, 1, 0), static_cast<float>(std::rand() % 360));
+			nodes.push_back(&node);
+		}
+	}
+
+	template<typename Func>
+	double TimeIterations(uint32_t iterations, Func&& func)
+	{
+		func(); //Warm up
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < iterations; ++i)
+		{
+			func();
+		}
+		const auto end = std::chrono::high_resolution_clock::now();
+
+		return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+	}
+
+	//Boxes scattered around the origin, about one in seven ends up inside BenchmarkFrustum
+	std::vector<SC::AABB> RandomBoxes(uint32_t count)
+	{
+		std::srand(1337);
+		std::vector<SC::AABB> boxes(count);
+		for (SC::AABB& box : boxes)
+		{
+			const glm::vec3 center = glm::vec3(std::rand() % 2000, std::rand() % 2000, std::rand() % 2000) * 0.1f - glm::vec3(100.0f);
+			const glm::vec3 extents = glm::vec3(std::rand() % 10 + 1, std::rand() % 10 + 1, std::rand() % 10 + 1) * 0.1f;
+			box = SC::AABB(center - extents, center + extents);
+		}
+		return boxes;
+	}
+
+	//Camera at the origin looking down -z
+	SC::Frustum BenchmarkFrustum()
+	{
+		const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		const glm::mat4 projection = glm::perspective(glm::radians(70.f), 16.0f / 9.0f, 0.1f, 1500.0f);
+		return SC::Frustum(projection * view);
+	}
+
+	float MaxDifference(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+	{
+		float difference = 0.0f;
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			for (int column = 0; column < 4; ++column)
+			{
+				const glm::vec4 delta = glm::abs(a[i][column] - b[i][column]);
+				difference = std::max({ difference, delta.x, delta.y, delta.z, delta.w });
+			}
+		}
+		return difference;
+	}
+
+	//Reference decoders for the blocks CompressMipChain writes, texels come out in row order as 8 bit RGBA
+	using DecodedBlock = std::array<std::array<uint8_t, 4>, 16>;
+
+	void DecodeBc1Colour(const uint8_t* block, DecodedBlock& texels)
+	{
+		const uint16_t colour0 = static_cast<uint16_t>(block[0] | block[1] << 8);
+		const uint16_t colour1 = static_cast<uint16_t>(block[2] | block[3] << 8);
+
+		std::array<std::array<int, 3>, 4> palette{};
+		for (int endpoint = 0; endpoint < 2; ++endpoint)
+		{
+			const uint16_t colour = endpoint == 0 ? colour0 : colour1;
+			const int red = colour >> 11 & 31, green = colour >> 5 & 63, blue = colour & 31;
+			palette[endpoint] = { red << 3 | red >> 2, green << 2 | green >> 4, blue << 3 | blue >> 2 };
+		}
+		for (int channel = 0; channel < 3; ++channel)
+		{
+			const int a = palette[0][channel], b = palette[1][channel];
+			palette[2][channel] = colour0 > colour1 ? (2 * a + b) / 3 : (a + b) / 2;
+			palette[3][channel] = colour0 > colour1 ? (a + 2 * b) / 3 : 0;
+		}
+
+		const uint32_t indices = block[4] | block[5] << 8 | block[6] << 16 | static_cast<uint32_t>(block[7]) << 24;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			const auto& colour = palette[indices >> (2 * i) & 3];
+			texels[i][0] = static_cast<uint8_t>(colour[0]);
+			texels[i][1] = static_cast<uint8_t>(colour[1]);
+			texels[i][2] = static_cast<uint8_t>(colour[2]);
+		}
+	}
+
+	//BC4 block, used for BC3 alpha and each BC5 channel
+	void DecodeBc4Channel(const uint8_t* block, DecodedBlock& texels, uint32_t channel)
+	{
+		const int value0 = block[0], value1 = block[1];
+		std::array<int, 8> palette = { value0, value1 };
+		if (value0 > value1)
+		{
+			for (int i = 1; i < 7; ++i)
+				palette[i + 1] = ((7 - i) * value0 + i * value1) / 7;
+		}
+		else
+		{
+			for (int i = 1; i < 5; ++i)
+				palette[i + 1] = ((5 - i) * value0 + i * value1) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		uint64_t indices = 0;
+		for (int i = 0; i < 6; ++i)
+			indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+		for (uint32_t i = 0; i < 16; ++i)
+			texels[i][channel] = static_cast<uint8_t>(palette[indices >> (3 * i) & 7]);
+	}
+
+	//Only mode 6, returns false for any other mode
+	bool DecodeBc7Mode6(const uint8_t* block, DecodedBlock& texels)
+	{
+		uint32_t position = 0;
+		auto read = [&](uint32_t bitCount)
+		{
+			uint32_t value = 0;
+			for (uint32_t i = 0; i < bitCount; ++i, ++position)
+				value |= (block[position / 8] >> (position % 8) & 1u) << i;
+			return value;
+		};
+
+		if (read(7) != 1u << 6)
+			return false;
+
+		std::array<std::array<uint32_t, 4>, 2> endpoints{};
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			endpoints[0][channel] = read(7);
+			endpoints[1][channel] = read(7);
+		}
+		const uint32_t pBit0 = read(1), pBit1 = read(1);
+		for (uint32_t channel = 0; channel < 4; ++channel)
+		{
+			endpoints[0][channel] = endpoints[0][channel] << 1 | pBit0;
+			endpoints[1][channel] = endpoints[1][channel] << 1 | pBit1;
+		}
+
+		constexpr std::array<uint32_t, 16> weights = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			//The anchor texel drops the top bit of its index
+			const uint32_t weight = weights[read(i == 0 ? 3 : 4)];
+			for (uint32_t channel = 0; channel < 4; ++channel)
+				texels[i][channel] = static_cast<uint8_t>(((64 - weight) * endpoints[0][channel] + weight * endpoints[1][channel] + 32) >> 6);
+		}
+		return true;
+	}
+
+	bool DecodeBlock(SC::Format format, const uint8_t* block, DecodedBlock& texels)
+	{
+		switch (format)
+		{
+		case SC::Format::BC1_RGB_UNORM:
+			DecodeBc1Colour(block, texels);
+			return true;
+		case SC::Format::BC3_UNORM:
+			DecodeBc4Channel(block, texels, 3);
+			DecodeBc1Colour(block + 8, texels);
+			return true;
+		case SC::Format::BC5_UNORM:
+			DecodeBc4Channel(block, texels, 0);
+			DecodeBc4Channel(block + 8, texels, 1);
+			return true;
+		case SC::Format::BC7_UNORM:
+			return DecodeBc7Mode6(block, texels);
+		default:
+			return false;
+		}
+	}
+
+	std::vector<uint8_t> KnownBlockPixels(uint32_t size)
+	{
+		std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4);
+		for (uint32_t y = 0; y < size; ++y)
+		{
+			for (uint32_t x = 0; x < size; ++x)
+			{
+				const uint32_t block = (y / 4) * (size / 4) + x / 4;
+				//Endpoints change per block, odd blocks blend down the columns and even ones along the rows
+				const uint32_t step = block % 2 ? y % 4 : x % 4;
+				for (uint32_t channel = 0; channel < 4; ++channel)
+				{
+					const uint32_t from = (block * 37 + channel * 71) % 256;
+					const uint32_t to = (block * 91 + channel * 53 + 128) % 256;
+					pixels[(static_cast<size_t>(y) * size + x) * 4 + channel] = static_cast<uint8_t>((from * (3 - step) + to * step + 1) / 3);
+				}
+			}
+		}
+		return pixels;
+	}
+}
+
+void BenchmarkLayer::OnAttach()
+{
+	TransformUpdateScaling();
+	TransformKernels();
+	SceneGraphBuildTeardown();
+	FrustumCulling();
+	BvhBuildQuery();
+	MeshRaycast();
+	RenderQueueSort();
+	CpuGpuCulling();
+	CommandRecordingScaling();
+	BlockCompressionRoundTrip();
+}
+
+void BenchmarkLayer::TransformUpdateScaling()
+{
+	SC::SceneGraph graph;
+	SC::SceneNode& root = graph.Root();
+	std::vector<SC::SceneNode*> nodes;
+	BuildRandomHierarchy(root, nodes, TRANSFORM_NODE_COUNT);
+
+	//Serial results are used as reference for the parallel runs
+	root.UpdateSelfAndChildren();
+	std::vector<glm::mat4> reference;
+	reference.reserve(nodes.size());
+	for (const auto& node : nodes)
+	{
+		reference.push_back(node->ModelMatrix());
+	}
+
+	SC::Log::Print(string_format("Transform update benchmark: {} nodes, {} iterations", nodes.size(), TRANSFORM_ITERATIONS));
+
+	const uint32_t maxThreads = SC::ThreadPool::DefaultWorkerCount() + 1;
+	double serialTime = 0.0;
+	for (uint32_t threads = 1; threads <= maxThreads; threads = threads < maxThreads ? std::min(threads * 2, maxThreads) : threads + 1)
+	{
+		SC::ThreadPool threadPool(threads - 1);
+		SC::ThreadPool* pool = threads > 1 ? &threadPool : nullptr;
+
+		for (uint32_t i = 0; i < TRANSFORM_WARMUP_ITERATIONS; ++i)
+		{
+			root.GetTransform().SetPosition(glm::vec3(0.0f));
+			root.UpdateSelfAndChildren(pool);
+		}
+
+		//Touching the root dirties every node so each iteration recomputes the whole hierarchy
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < TRANSFORM_ITERATIONS; ++i)
+		{
+			root.GetTransform().SetPosition(glm::vec3(0.0f));
+			root.UpdateSelfAndChildren(pool);
+		}
+		const auto end = std::chrono::high_resolution_clock::now();
+
+		const double time = std::chrono::duration<double, std::milli>(end - start).count() / TRANSFORM_ITERATIONS;
+		if (threads == 1)
+			serialTime = time;
+
+		bool identical = true;
+		for (size_t i = 0; i < nodes.size() && identical; ++i)
+		{
+			identical = std::memcmp(&reference[i], &nodes[i]->ModelMatrix(), sizeof(glm::mat4)) == 0;
+		}
+
+		SC::Log::Print(string_format("  {:2} threads: {:8.3f} ms  speedup {:5.2f}x  {}", threads, time, serialTime / time,
+			identical ? "matches serial" : "MISMATCH"), identical ? SC::LogSeverity::LogInfo : SC::LogSeverity::LogError);
+	}
+}
+
+void BenchmarkLayer::TransformKernels()
+{
+	std::srand(1337);
+	std::vector<glm::vec3> positions(KERNEL_MATRIX_COUNT);
+	std::vector<glm::quat> rotations(KERNEL_MATRIX_COUNT);
+	std::vector<glm::vec3> scales(KERNEL_MATRIX_COUNT);
+	std::vector<uint32_t> parents(KERNEL_MATRIX_COUNT);
+	for (uint32_t i = 0; i < KERNEL_MATRIX_COUNT; ++i)
+	{
+		positions[i] = glm::vec3(std::rand() % 100, std::rand() % 100, std::rand() % 100) * 0.1f;
+		rotations[i] = glm::angleAxis(static_cast<float>(std::rand() % 360), glm::normalize(glm::vec3(std::rand() % 10 + 1, std::rand() % 10, std::rand() % 10)));
+		scales[i] = glm::vec3(std::rand() % 4 + 1) * 0.5f;
+		parents[i] = i == 0 ? SC::TransformKernels::INVALID_PARENT : static_cast<uint32_t>(std::rand()) % i;
+	}
+
+	//Reference is the glm path the hierarchy used before the kernels
+	std::vector<glm::mat4> glmLocal(KERNEL_MATRIX_COUNT);
+	std::vector<glm::mat4> glmWorld(KERNEL_MATRIX_COUNT);
+	const double glmComposeTime = TimeIterations(KERNEL_ITERATIONS, [&]()
+		{
+			for (uint32_t i = 0; i < KERNEL_MATRIX_COUNT; ++i)
+			{
+				glm::mat4 transform = glm::translate(glm::mat4(1.0f), positions[i]);
+				transform *= glm::toMat4(rotations[i]);
+				glmLocal[i] = glm::scale(transform, scales[i]);
+			}
+		});
+	const double glmMultiplyTime = TimeIterations(KERNEL_ITERATIONS, [&]()
+		{
+			glmWorld[0] = glmLocal[0];
+			for (uint32_t i = 1; i < KERNEL_MATRIX_COUNT; ++i)
+			{
+				glmWorld[i] = glmWorld[parents[i]] * glmLocal[i];
+			}
+		});
+
+	SC::Log::Print(string_format("Transform kernel benchmark: {} matrices, {} iterations", KERNEL_MATRIX_COUNT, KERNEL_ITERATIONS));
+	SC::Log::Print(string_format("  {:>6}: compose {:7.3f} ms  multiply {:7.3f} ms", "glm", glmComposeTime, glmMultiplyTime));
+
+	std::vector<glm::mat4> local(KERNEL_MATRIX_COUNT);
+	std::vector<glm::mat4> world(KERNEL_MATRIX_COUNT);
+	const SC::SimdLevel supportedLevel = SC::Cpu::SupportedSimdLevel();
+	for (SC::SimdLevel level = SC::SimdLevel::SCALAR; level <= supportedLevel; level = static_cast<SC::SimdLevel>(to_underlying(level) + 1))
+	{
+		const double composeTime = TimeIterations(KERNEL_ITERATIONS, [&]()
+			{
+				SC::TransformKernels::ComposeMatrices(positions.data(), rotations.data(), scales.data(), local.data(), KERNEL_MATRIX_COUNT, level);
+			});
+		const double multiplyTime = TimeIterations(KERNEL_ITERATIONS, [&]()
+			{
+				SC::TransformKernels::MultiplyParents(parents.data(), local.data(), world.data(), 0, KERNEL_MATRIX_COUNT, level);
+			});
+
+		SC::Log::Print(string_format("  {:>6}: compose {:7.3f} ms ({:5.2f}x)  multiply {:7.3f} ms ({:5.2f}x)  max error {}",
+			SC::SimdLevelToString(level), composeTime, glmComposeTime / composeTime, multiplyTime, glmMultiplyTime / multiplyTime,
+			std::max(MaxDifference(glmLocal, local), MaxDifference(glmWorld, world))));
+	}
+}
+
+void BenchmarkLayer::SceneGraphBuildTeardown()
+{
+	SC::Log::Print(string_format("Scene graph benchmark: {} iterations", GRAPH_ITERATIONS));
+
+	//The graph is reused between iterations like a Scene is between Reset and LoadModel
+	SC::SceneGraph graph;
+	std::vector<SC::SceneNode*> nodes;
+
+	auto run = [&](const char* name, const std::function<void()>& build)
+	{
+		double buildTime = 0.0;
+		double teardownTime = 0.0;
+		for (uint32_t i = 0; i < GRAPH_ITERATIONS; ++i)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+			build();
+			graph.Root().UpdateSelfAndChildren();
+			const auto built = std::chrono::high_resolution_clock::now();
+			graph.Root().Remove();
+			const auto end = std::chrono::high_resolution_clock::now();
+
+			buildTime += std::chrono::duration<double, std::milli>(built - start).count();
+			teardownTime += std::chrono::duration<double, std::milli>(end - built).count();
+		}
+
+		SC::Log::Print(string_format("  {:>8}: build {:8.3f} ms  teardown {:8.3f} ms", name, buildTime / GRAPH_ITERATIONS, teardownTime / GRAPH_ITERATIONS));
+	};
+
+	run("Sponza", [&]()
+		{
+			for (uint32_t model = 0; model < GRAPH_MODEL_COUNT; ++model)
+			{
+				SC::SceneNode& modelRoot = graph.Root().AddChild();
+				for (uint32_t mesh = 0; mesh < GRAPH_MESHES_PER_MODEL; ++mesh)
+				{
+					modelRoot.AddChild();
+				}
+			}
+		});
+
+	run("Random", [&]()
+		{
+			nodes.clear();
+			BuildRandomHierarchy(graph.Root(), nodes, TRANSFORM_NODE_COUNT);
+		});
+}
+
+void BenchmarkLayer::FrustumCulling()
+{
+	SC::AABBArray bounds;
+	for (const SC::AABB& box : RandomBoxes(CULLING_BOX_COUNT))
+	{
+		bounds.Add(box);
+	}
+	const SC::Frustum frustum = BenchmarkFrustum();
+
+	SC::Log::Print(string_format("Frustum culling benchmark: {} boxes, {} iterations", CULLING_BOX_COUNT, CULLING_ITERATIONS));
+
+	std::vector<uint32_t> reference(CULLING_BOX_COUNT);
+	std::vector<uint32_t> visible(CULLING_BOX_COUNT);
+	uint32_t referenceCount = 0;
+	double scalarTime = 0.0;
+	const SC::SimdLevel supportedLevel = SC::Cpu::SupportedSimdLevel();
+	for (SC::SimdLevel level = SC::SimdLevel::SCALAR; level <= supportedLevel; level = static_cast<SC::SimdLevel>(to_underlying(level) + 1))
+	{
+		uint32_t visibleCount = 0;
+		const double time = TimeIterations(CULLING_ITERATIONS, [&]()
+			{
+				visibleCount = frustum.Cull(bounds, visible.data(), level);
+			});
+
+		if (level == SC::SimdLevel::SCALAR)
+		{
+			scalarTime = time;
+			referenceCount = visibleCount;
+			reference = visible;
+		}
+
+		const bool matches = visibleCount == referenceCount && std::equal(visible.begin(), visible.begin() + visibleCount, reference.begin());
+		SC::Log::Print(string_format("  {:>6}: {:7.3f} ms ({:5.2f}x)  visible {} / {}  {}",
+			SC::SimdLevelToString(level), time, scalarTime / time, visibleCount, CULLING_BOX_COUNT, matches ? "matches scalar" : "MISMATCH"));
+	}
+}
+
+void BenchmarkLayer::BvhBuildQuery()
+{
+	std::vector<SC::AABB> boxes = RandomBoxes(BVH_BOX_COUNT);
+	SC::AABBArray boxArrays;
+	for (const SC::AABB& box : boxes)
+	{
+		boxArrays.Add(box);
+	}
+
+	SC::Log::Print(string_format("BVH benchmark: {} boxes, {} iterations", BVH_BOX_COUNT, BVH_ITERATIONS));
+
+	SC::BVH bvh;
+	const double buildTime = TimeIterations(BVH_ITERATIONS, [&]() { bvh.Build(boxes.data(), BVH_BOX_COUNT); });
+	SC::ThreadPool threadPool;
+	const double parallelBuildTime = TimeIterations(BVH_ITERATIONS, [&]() { bvh.Build(boxes.data(), BVH_BOX_COUNT, &threadPool); });
+	SC::Log::Print(string_format("  build {:8.3f} ms  parallel build ({} threads) {:8.3f} ms  {} nodes",
+		buildTime, threadPool.ThreadCount(), parallelBuildTime, bvh.Nodes().size()));
+
+	//The BVH result is compared against the linear cull of every box
+	const SC::Frustum frustum = BenchmarkFrustum();
+	std::vector<uint32_t> linearVisible(BVH_BOX_COUNT);
+	uint32_t linearCount = 0;
+	const double linearTime = TimeIterations(BVH_ITERATIONS, [&]() { linearCount = frustum.Cull(boxArrays, linearVisible.data()); });
+
+	std::vector<uint32_t> bvhVisible;
+	uint32_t tested = 0;
+	const double queryTime = TimeIterations(BVH_ITERATIONS, [&]()
+		{
+			bvhVisible.clear();
+			tested = bvh.Query(frustum, bvhVisible);
+		});
+	std::sort(bvhVisible.begin(), bvhVisible.end());
+	const bool matches = bvhVisible.size() == linearCount && std::equal(bvhVisible.begin(), bvhVisible.end(), linearVisible.begin());
+
+	SC::Log::Print(string_format("  frustum: linear {} {:7.3f} ms  bvh {:7.3f} ms ({} boxes tested)  visible {}  {}",
+		SC::SimdLevelToString(SC::Cpu::ActiveSimdLevel()), linearTime, queryTime, tested, linearCount, matches ? "matches linear" : "MISMATCH"));
+
+	//Move a percent of the boxes and refit just those, then everything
+	std::vector<uint32_t> moved(BVH_MOVED_BOXES);
+	for (uint32_t& primitive : moved)
+	{
+		primitive = static_cast<uint32_t>(std::rand()) % BVH_BOX_COUNT;
+		boxes[primitive].min += glm::vec3(1.0f);
+		boxes[primitive].max += glm::vec3(1.0f);
+	}
+
+	const double refitTime = TimeIterations(BVH_ITERATIONS, [&]() { bvh.Refit(boxes.data(), moved.data(), BVH_MOVED_BOXES); });
+	const double fullRefitTime = TimeIterations(BVH_ITERATIONS, [&]() { bvh.Refit(boxes.data()); });
+	SC::Log::Print(string_format("  refit {} boxes {:7.3f} ms  full refit {:7.3f} ms", BVH_MOVED_BOXES, refitTime, fullRefitTime));
+}
+
+void BenchmarkLayer::MeshRaycast()
+{
+	//Unit sphere made of latitude/longitude quads
+	SC::Mesh mesh;
+	for (uint32_t ring = 0; ring <= RAYCAST_SPHERE_SEGMENTS; ++ring)
+	{
+		const float latitude = glm::pi<float>() * ring / RAYCAST_SPHERE_SEGMENTS;
+		for (uint32_t segment = 0; segment <= RAYCAST_SPHERE_SEGMENTS; ++segment)
+		{
+			const float longitude = glm::two_pi<float>() * segment / RAYCAST_SPHERE_SEGMENTS;
+			const glm::vec3 position(std::sin(latitude) * std::cos(longitude), std::cos(latitude), std::sin(latitude) * std::sin(longitude));
+			mesh.vertices.push_back({ position, position, glm::vec2(0.0f) });
+		}
+	}
+
+	for (uint32_t ring = 0; ring < RAYCAST_SPHERE_SEGMENTS; ++ring)
+	{
+		for (uint32_t segment = 0; segment < RAYCAST_SPHERE_SEGMENTS; ++segment)
+		{
+			const uint32_t a = ring * (RAYCAST_SPHERE_SEGMENTS + 1) + segment;
+			const uint32_t b = a + RAYCAST_SPHERE_SEGMENTS + 1;
+			mesh.indices.insert(mesh.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+		}
+	}
+
+	const uint32_t triangleCount = mesh.IndexCount() / 3;
+	const auto buildStart = std::chrono::high_resolution_clock::now();
+	mesh.BuildTriangleBvh();
+	const auto buildEnd = std::chrono::high_resolution_clock::now();
+
+	SC::Log::Print(string_format("Mesh raycast benchmark: {} triangles, triangle BVH built in {:.3f} ms",
+		triangleCount, std::chrono::duration<double, std::milli>(buildEnd - buildStart).count()));
+
+	//Rays from outside the sphere aimed near its center
+	std::srand(1337);
+	std::vector<SC::Ray> rays(RAYCAST_RAY_COUNT);
+	for (SC::Ray& ray : rays)
+	{
+		const glm::vec3 origin = glm::normalize(glm::vec3(std::rand() % 2001 - 1000, std::rand() % 2001 - 1000, std::rand() % 2001 - 1000) + glm::vec3(0.5f)) * 3.0f;
+		const glm::vec3 target = glm::vec3(std::rand() % 101 - 50, std::rand() % 101 - 50, std::rand() % 101 - 50) * 0.01f;
+		ray = SC::Ray(origin, glm::normalize(target - origin));
+	}
+
+	std::vector<float> bvhDistances(RAYCAST_RAY_COUNT, -1.0f);
+	const double bvhTime = TimeIterations(1, [&]()
+		{
+			for (uint32_t i = 0; i < RAYCAST_RAY_COUNT; ++i)
+			{
+				uint32_t triangle;
+				mesh.Raycast(rays[i], std::numeric_limits<float>::max(), bvhDistances[i], triangle);
+			}
+		});
+
+	//Without the BVH Raycast tests every triangle
+	std::unique_ptr<SC::BVH> triangleBvh = std::move(mesh.triangleBvh);
+	std::vector<float> bruteForceDistances(RAYCAST_BRUTE_FORCE_RAY_COUNT, -1.0f);
+	const double bruteForceTime = TimeIterations(1, [&]()
+		{
+			for (uint32_t i = 0; i < RAYCAST_BRUTE_FORCE_RAY_COUNT; ++i)
+			{
+				uint32_t triangle;
+				mesh.Raycast(rays[i], std::numeric_limits<float>::max(), bruteForceDistances[i], triangle);
+			}
+		});
+	mesh.triangleBvh = std::move(triangleBvh);
+
+	const bool matches = std::equal(bruteForceDistances.begin(), bruteForceDistances.end(), bvhDistances.begin());
+	SC::Log::Print(string_format("  closest hit per ray: brute force {:9.3f} us  bvh {:7.3f} us  {}",
+		bruteForceTime * 1000.0 / RAYCAST_BRUTE_FORCE_RAY_COUNT, bvhTime * 1000.0 / RAYCAST_RAY_COUNT, matches ? "matches brute force" : "MISMATCH"));
+}
+
+void BenchmarkLayer::RenderQueueSort()
+{
+	std::srand(1337);
+	std::vector<SC::RenderQueue::Item> items(QUEUE_ITEM_COUNT);
+	for (uint32_t i = 0; i < QUEUE_ITEM_COUNT; ++i)
+	{
+		const uint64_t key = SC::RenderQueue::MakeKey(SC::MeshpassType::Forward, std::rand() % QUEUE_PIPELINE_COUNT,
+			std::rand() % QUEUE_MATERIAL_COUNT, std::rand() % QUEUE_MESH_COUNT, static_cast<float>(std::rand() % 100000) * 0.01f);
+		items[i] = { key, i };
+	}
+
+	SC::RenderQueue queue;
+	const double radixTime = TimeIterations(QUEUE_ITERATIONS, [&]()
+		{
+			queue.Clear();
+			for (const SC::RenderQueue::Item& item : items)
+			{
+				queue.Add(item.key, item.object);
+			}
+			queue.Sort();
+		});
+
+	std::vector<SC::RenderQueue::Item> sorted;
+	const double stdSortTime = TimeIterations(QUEUE_ITERATIONS, [&]()
+		{
+			sorted = items;
+			std::stable_sort(sorted.begin(), sorted.end(), [](const SC::RenderQueue::Item& a, const SC::RenderQueue::Item& b) { return a.key < b.key; });
+		});
+
+	const bool matches = std::equal(sorted.begin(), sorted.end(), queue.Items().begin(),
+		[](const SC::RenderQueue::Item& a, const SC::RenderQueue::Item& b) { return a.key == b.key && a.object == b.object; });
+
+	SC::Log::Print(string_format("Render queue benchmark: {} draws, {} iterations", QUEUE_ITEM_COUNT, QUEUE_ITERATIONS));
+	SC::Log::Print(string_format("  radix sort {:7.3f} ms  std::stable_sort {:7.3f} ms  {}", radixTime, stdSortTime, matches ? "matches" : "MISMATCH"));
+}
+
+void BenchmarkLayer::CpuGpuCulling()
+{
+	SC::Renderer* renderer = SC::App::Instance() ? SC::App::Instance()->GetRenderer() : nullptr;
+	if (!renderer)
+	{
+		SC::Log::Print("Gpu culling benchmark: skipped, needs a renderer");
+		return;
+	}
+
+	SC::GpuCulling culling;
+	if (!culling.Init("data/shaders/cull.comp.spv"))
+	{
+		SC::Log::Print("Gpu culling benchmark: skipped, failed to load the culling shader", SC::LogSeverity::LogError);
+		return;
+	}
+
+	std::unique_ptr<SC::CommandPool> commandPool = SC::CommandPool::Create();
+	std::unique_ptr<SC::CommandBuffer> commandBuffer = commandPool->CreateCommandBuffer();
+	std::unique_ptr<SC::DescriptorSet> descriptorSet = SC::DescriptorSet::Create(culling.SetLayout());
+	const SC::Frustum frustum = BenchmarkFrustum();
+
+	SC::BufferUsageSet storageUsage;
+	storageUsage.set(SC::BufferUsage::STORAGE_BUFFER);
+	storageUsage.set(SC::BufferUsage::MAP);
+	SC::BufferUsageSet commandUsage = storageUsage;
+	commandUsage.set(SC::BufferUsage::INDIRECT_BUFFER);
+
+	SC::Log::Print(string_format("Gpu culling benchmark: {} draws, {} iterations, cpu is culling and compacting the transforms on one thread",
+		GPU_CULLING_BATCH_COUNT, GPU_CULLING_ITERATIONS));
+
+	for (uint32_t objectCount : GPU_CULLING_OBJECT_COUNTS)
+	{
+		//Objects are split into contiguous batches, like a sorted render queue
+		const std::vector<SC::AABB> boxes = RandomBoxes(objectCount);
+		SC::AABBArray boxArrays;
+		std::vector<glm::mat4> transforms(objectCount);
+		std::vector<uint32_t> objectBatches(objectCount);
+		std::array<uint32_t, GPU_CULLING_BATCH_COUNT> batchFirst{};
+		for (uint32_t i = 0; i < objectCount; ++i)
+		{
+			boxArrays.Add(boxes[i]);
+			transforms[i] = glm::translate(glm::mat4(1.0f), boxes[i].Center());
+			objectBatches[i] = static_cast<uint32_t>(static_cast<uint64_t>(i) * GPU_CULLING_BATCH_COUNT / objectCount);
+			if (i == 0 || objectBatches[i] != objectBatches[i - 1])
+				batchFirst[objectBatches[i]] = i;
+		}
+
+		std::vector<uint32_t> visible(objectCount);
+		std::vector<glm::mat4> instances(objectCount);
+		std::array<uint32_t, GPU_CULLING_BATCH_COUNT> batchCounts{};
+		uint32_t cpuVisibleCount = 0;
+		const double cpuTime = TimeIterations(GPU_CULLING_ITERATIONS, [&]()
+			{
+				batchCounts.fill(0);
+				cpuVisibleCount = frustum.Cull(boxArrays, visible.data());
+				for (uint32_t v = 0; v < cpuVisibleCount; ++v)
+				{
+					const uint32_t object = visible[v];
+					const uint32_t batch = objectBatches[object];
+					instances[batchFirst[batch] + batchCounts[batch]++] = transforms[object];
+				}
+			});
+
+		std::unique_ptr<SC::Buffer> objectBuffer = SC::Buffer::Create(sizeof(SC::GpuCulling::Object) * objectCount, storageUsage, SC::AllocationUsage::HOST);
+		std::unique_ptr<SC::Buffer> transformBuffer = SC::Buffer::Create(sizeof(glm::mat4) * objectCount, storageUsage, SC::AllocationUsage::HOST, transforms.data());
+		std::unique_ptr<SC::Buffer> instanceBuffer = SC::Buffer::Create(sizeof(glm::mat4) * objectCount, storageUsage, SC::AllocationUsage::HOST);
+		std::unique_ptr<SC::Buffer> drawBuffer = SC::Buffer::Create(sizeof(SC::DrawIndexedIndirectCommand) * GPU_CULLING_BATCH_COUNT, commandUsage, SC::AllocationUsage::HOST);
+		{
+			SC::ScopedMapData mappedObjects = objectBuffer->Map();
+			SC::GpuCulling::Object* objects = static_cast<SC::GpuCulling::Object*>(mappedObjects.Data());
+			for (uint32_t i = 0; i < objectCount; ++i)
+			{
+				objects[i] = SC::GpuCulling::Object{ boxes[i].min, objectBatches[i], boxes[i].max, 0 };
+			}
+		}
+
+		descriptorSet->SetBuffer(objectBuffer.get(), SC::GpuCulling::OBJECTS);
+		descriptorSet->SetBuffer(transformBuffer.get(), SC::GpuCulling::TRANSFORMS);
+		descriptorSet->SetBuffer(instanceBuffer.get(), SC::GpuCulling::INSTANCES);
+		descriptorSet->SetBuffer(drawBuffer.get(), SC::GpuCulling::COMMANDS);
+
+		//Includes resetting the draws, recording and waiting for the GPU, which is what a frame would pay
+		const double gpuTime = TimeIterations(GPU_CULLING_ITERATIONS, [&]()
+			{
+				{
+					SC::ScopedMapData mappedDraws = drawBuffer->Map();
+					SC::DrawIndexedIndirectCommand* draws = static_cast<SC::DrawIndexedIndirectCommand*>(mappedDraws.Data());
+					for (uint32_t batch = 0; batch < GPU_CULLING_BATCH_COUNT; ++batch)
+					{
+						draws[batch] = SC::DrawIndexedIndirectCommand{ 36, 0, 0, 0, batchFirst[batch] };
+					}
+				}
+
+				commandBuffer->ResetCommands();
+				commandBuffer->BeginRecording();
+				culling.Dispatch(*commandBuffer, descriptorSet.get(), frustum, objectCount);
+				commandBuffer->EndRecording();
+				renderer->SubmitAndWait(*commandBuffer);
+			});
+
+		bool matches = true;
+		uint32_t gpuVisibleCount = 0;
+		{
+			SC::ScopedMapData mappedDraws = drawBuffer->Map();
+			const SC::DrawIndexedIndirectCommand* draws = static_cast<const SC::DrawIndexedIndirectCommand*>(mappedDraws.Data());
+			for (uint32_t batch = 0; batch < GPU_CULLING_BATCH_COUNT; ++batch)
+			{
+				gpuVisibleCount += draws[batch].instanceCount;
+				matches &= draws[batch].instanceCount == batchCounts[batch];
+			}
+		}
+
+		SC::Log::Print(string_format("  {:8} objects: cpu {:8.3f} ms  gpu {:8.3f} ms  visible cpu {} gpu {}  {}", objectCount, cpuTime, gpuTime,
+			cpuVisibleCount, gpuVisibleCount, matches ? "matches" : "MISMATCH"), matches ? SC::LogSeverity::LogInfo : SC::LogSeverity::LogError);
+	}
+}
+
+void BenchmarkLayer::CommandRecordingScaling()
+{
+	SC::Renderer* renderer = SC::App::Instance() ? SC::App::Instance()->GetRenderer() : nullptr;
+	if (!renderer)
+	{
+		SC::Log::Print("Command recording benchmark: skipped, needs a renderer");
+		return;
+	}
+
+	SC::ShaderEffect effect = SC::ShaderEffect::Builder("data/shaders/coloured_triangle.vert.spv", "data/shaders/coloured_triangle.frag.spv")
+		.AddSet("material",
+			{
+				{ SC::DescriptorBindingType::UNIFORM, {SC::ShaderStage::FRAGMENT}},
+			})
+		.Build();
+
+	//Same layout, only the culling differs, so material sets stay valid across a pipeline change
+	std::array<std::unique_ptr<SC::Pipeline>, 2> pipelines;
+	const std::array<SC::FaceCulling, 2> pipelineCulling = { SC::FaceCulling::BACK, SC::FaceCulling::FRONT };
+	for (size_t i = 0; i < pipelines.size(); ++i)
+	{
+		pipelines[i] = SC::Pipeline::Create(*effect.GetShaderModule());
+		pipelines[i]->pipelineLayout = effect.GetPipelineLayout();
+		pipelines[i]->faceCulling = pipelineCulling[i];
+		if (!pipelines[i]->Build())
+		{
+			SC::Log::Print("Command recording benchmark: skipped, failed to build the pipeline", SC::LogSeverity::LogError);
+			return;
+		}
+	}
+
+	SC::BufferUsageSet uniformUsage;
+	uniformUsage.set(SC::BufferUsage::UNIFORM_BUFFER);
+	uniformUsage.set(SC::BufferUsage::MAP);
+	std::vector<std::unique_ptr<SC::Buffer>> materialBuffers;
+	std::vector<std::unique_ptr<SC::DescriptorSet>> materials;
+	for (uint32_t i = 0; i < RECORDING_MATERIAL_COUNT; ++i)
+	{
+		const glm::vec4 colour(static_cast<float>(i) / RECORDING_MATERIAL_COUNT, 0.0f, 0.0f, 1.0f);
+		materialBuffers.push_back(SC::Buffer::Create(sizeof(glm::vec4), uniformUsage, SC::AllocationUsage::HOST, &colour));
+		materials.push_back(SC::DescriptorSet::Create(effect.GetDescriptorSetLayout(0)));
+		materials.back()->SetBuffer(materialBuffers.back().get(), 0);
+	}
+
+	const SC::Renderpass* renderPass = renderer->DefaultRenderPass();
+	const SC::RenderTarget* renderTarget = renderer->DefaultRenderTarget();
+	const SC::Viewport viewport(0, 0, static_cast<float>(renderTarget->GetWidth()), static_cast<float>(renderTarget->GetHeight()));
+	const SC::Scissor scissor(renderTarget->GetWidth(), renderTarget->GetHeight());
+
+	const uint32_t maxThreadCount = SC::ThreadPool::DefaultWorkerCount() + 1;
+	std::vector<std::unique_ptr<SC::CommandPool>> commandPools;
+	std::vector<std::unique_ptr<SC::CommandBuffer>> commandBuffers;
+	for (uint32_t i = 0; i < maxThreadCount; ++i)
+	{
+		commandPools.push_back(SC::CommandPool::Create());
+		commandBuffers.push_back(commandPools.back()->CreateCommandBuffer(SC::CommandBufferLevel::SECONDARY));
+	}
+
+	SC::Log::Print(string_format("Command recording benchmark: {} draws, pipeline and material bound every draw, pipeline changes every {} draws,"
+		" material every {}, {} iterations, never submitted", RECORDING_DRAW_COUNT, RECORDING_DRAWS_PER_PIPELINE, RECORDING_DRAWS_PER_MATERIAL,
+		RECORDING_ITERATIONS));
+
+	double singleThreadTime = 0.0;
+	for (uint32_t threadCount = 1; threadCount <= maxThreadCount; threadCount *= 2)
+	{
+		SC::ThreadPool threadPool(threadCount - 1);
+
+		//Resetting the pools is part of what a frame pays
+		const double time = TimeIterations(RECORDING_ITERATIONS, [&]()
+			{
+				for (uint32_t i = 0; i < threadCount; ++i)
+				{
+					commandPools[i]->Reset();
+				}
+
+				threadPool.ParallelFor(threadCount, [&](uint32_t chunk)
+					{
+						const uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(RECORDING_DRAW_COUNT) * chunk / threadCount);
+						const uint32_t end = static_cast<uint32_t>(static_cast<uint64_t>(RECORDING_DRAW_COUNT) * (chunk + 1) / threadCount);
+
+						SC::CommandBuffer& commandBuffer = *commandBuffers[chunk];
+						commandBuffer.BeginRecording(renderPass, renderTarget);
+						commandBuffer.SetViewport(viewport);
+						commandBuffer.SetScissor(scissor);
+						for (uint32_t draw = begin; draw < end; ++draw)
+						{
+							//Binds like a naive caller would, repeats are left for the command buffer to filter
+							const SC::Pipeline* pipeline = pipelines[(draw / RECORDING_DRAWS_PER_PIPELINE) % pipelines.size()].get();
+							const SC::DescriptorSet* material = materials[(draw / RECORDING_DRAWS_PER_MATERIAL) % RECORDING_MATERIAL_COUNT].get();
+							commandBuffer.BindPipeline(pipeline);
+							commandBuffer.BindDescriptorSet(effect.GetPipelineLayout(), material, 0);
+							commandBuffer.Draw(3, 1, 0, draw);
+						}
+						commandBuffer.EndRecording();
+					});
+			});
+
+		if (threadCount == 1)
+			singleThreadTime = time;
+
+		//Stats are from the last iteration, they are reset when recording begins
+		SC::CommandBufferStats stats;
+		for (uint32_t i = 0; i < threadCount; ++i)
+		{
+			stats.recorded += commandBuffers[i]->GetStats().recorded;
+			stats.filtered += commandBuffers[i]->GetStats().filtered;
+		}
+
+		SC::Log::Print(string_format("  {:2} threads: {:8.3f} ms  {:5.2f}x  recorded {}  filtered {}", threadCount, time, singleThreadTime / time,
+			stats.recorded, stats.filtered));
+	}
+}
+
+void BenchmarkLayer::BlockCompressionRoundTrip()
+{
+	const std::vector<uint8_t> pixels = KnownBlockPixels(COMPRESSION_TEXTURE_SIZE);
+	SC::MipChain chain;
+	chain.pixels = pixels;
+	chain.levels.push_back({ 0, pixels.size(), COMPRESSION_TEXTURE_SIZE, COMPRESSION_TEXTURE_SIZE });
+
+	SC::Log::Print(string_format("Block compression round trip: {0}x{0} texels, encoded and decoded on the cpu", COMPRESSION_TEXTURE_SIZE));
+
+	struct Check
+	{
+		const char* name;
+		SC::Format format;
+		uint32_t channelCount; //Channels the format keeps, from red
+		float maxError; //Root mean square over the kept channels, in 8 bit steps
+	};
+	//The encoder moves endpoints in by 1/16 of a block's range, which costs about 5 steps on these blocks. A wrong bit layout
+	//or palette is off by tens of steps
+
+	constexpr std::array<Check, 4> checks = { {
+		{ "BC1", SC::Format::BC1_RGB_UNORM, 3, 8.0f },
+		{ "BC3", SC::Format::BC3_UNORM, 4, 8.0f },
+		{ "BC5", SC::Format::BC5_UNORM, 2, 6.0f },
+		{ "BC7 mode 6", SC::Format::BC7_UNORM, 4, 7.0f },
+	} };
+
+	for (const Check& check : checks)
+	{
+		const SC::CompressedTexture compressed = SC::CompressMipChain(chain, check.format);
+		const uint32_t blocksPerRow = COMPRESSION_TEXTURE_SIZE / 4;
+		const uint32_t blockSize = SC::FormatBlockSize(check.format);
+
+		bool decoded = compressed.data.size() == static_cast<size_t>(blocksPerRow) * blocksPerRow * blockSize;
+		double squaredError = 0.0;
+		for (uint32_t block = 0; decoded && block < blocksPerRow * blocksPerRow; ++block)
+		{
+			DecodedBlock texels{};
+			decoded = DecodeBlock(check.format, compressed.data.data() + static_cast<size_t>(block) * blockSize, texels);
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				const uint32_t x = (block % blocksPerRow) * 4 + i % 4;
+				const uint32_t y = (block / blocksPerRow) * 4 + i / 4;
+				for (uint32_t channel = 0; channel < check.channelCount; ++channel)
+				{
+					const double difference = static_cast<double>(texels[i][channel]) - pixels[(static_cast<size_t>(y) * COMPRESSION_TEXTURE_SIZE + x) * 4 + channel];
+					squaredError += difference * difference;
+				}
+			}
+		}
+
+		const double error = std::sqrt(squaredError / (static_cast<double>(COMPRESSION_TEXTURE_SIZE) * COMPRESSION_TEXTURE_SIZE * check.channelCount));
+		const bool passed = decoded && error <= check.maxError;
+		SC::Log::Print(string_format("  {:10}: rms error {:6.3f}  bound {:4.1f}  {}", check.name, error, check.maxError,
+			!decoded ? "UNDECODABLE" : passed ? "ok" : "FAILED"), passed ? SC::LogSeverity::LogInfo : SC::LogSeverity::LogError);
+	}
+
+	SC::Renderer* renderer = SC::App::Instance() ? SC::App::Instance()->GetRenderer() : nullptr;
+	if (!renderer || !renderer->SupportsBlockCompression())
+	{
+		SC::Log::Print("  BC7 upload: skipped, needs a renderer with block compression");
+		return;
+	}
+
+	//Full chain so every level goes through the compressed copy path
+	const SC::MipChain fullChain = SC::GenerateMipChain(pixels.data(), COMPRESSION_TEXTURE_SIZE, COMPRESSION_TEXTURE_SIZE, false);
+	const SC::CompressedTexture compressed = SC::CompressMipChain(fullChain, SC::Format::BC7_UNORM);
+	std::unique_ptr<SC::Texture> texture = SC::Texture::Create(SC::TextureType::TEXTURE2D, SC::TextureUsage::COLOUR, compressed.format);
+	const bool uploaded = texture->Build(compressed.width, compressed.height, true) &&
+		texture->CopyData(compressed.data.data(), compressed.data.size(), static_cast<uint32_t>(compressed.levels.size()));
+	SC::Log::Print(string_format("  BC7 upload: {} levels {}", compressed.levels.size(), uploaded ? "ok" : "FAILED"),
+		uploaded ? SC::LogSeverity::LogInfo : SC::LogSeverity::LogError);
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "scorch/engine.h"
+
+//Runs the engine's benchmarks once on attach and logs the results, the GPU ones need the app's renderer
+class BenchmarkLayer : public SC::Layer
+{
+public:
+	BenchmarkLayer() : Layer("BenchmarkLayer") {}
+
+	void OnAttach() override;
+private:
+	void TransformUpdateScaling();
+	void TransformKernels();
+	void SceneGraphBuildTeardown();
+	void FrustumCulling();
+	void BvhBuildQuery();
+	void MeshRaycast();
+	void RenderQueueSort();
+	void CpuGpuCulling();
+	void CommandRecordingScaling();
+	void BlockCompressionRoundTrip();
+};
@@ -4,6 +4,7 @@
 #include "modelLayer.h"
 #include "sceneLayer.h"
 #include "offscreenLayer.h"
+#include "benchmarkLayer.h"
 
 int main()
 {
@@ -16,6 +17,7 @@ int main()
 		//std::shared_ptr<SC::Layer> modelLayer = std::make_shared<ModelLayer>();
 		std::shared_ptr<SC::Layer> modelLayer = std::make_shared<SceneLayer>();
 		//std::shared_ptr<SC::Layer> deferredLayer = std::make_shared<OffscreenLayer>();
+		//std::shared_ptr<SC::Layer> benchmarkLayer = std::make_shared<BenchmarkLayer>();
 
 
 		app->PushLayer(modelLayer);
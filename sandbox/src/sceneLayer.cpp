@@ -13,12 +13,6 @@ namespace
 	float gTime;
 }
 
-struct MeshPushConstants
-{
-	glm::vec4 data;
-	glm::mat4 render_matrix;
-};
-
 struct GPUCameraData
 {
 	glm::mat4 view;
@@ -31,7 +25,11 @@ SceneLayer::SceneLayer() : Layer("SceneLayer"),
 m_lightDir(glm::vec4(0.44f, 0.89f, 0.22f, 0)),
 m_globalShiniess(1.0f),
 m_globalSpecStrength(0.5f),
-m_zoom(10.0f)
+m_zoom(10.0f),
+m_parallelTransforms(true),
+m_parallelRecording(false),
+m_gpuCullingAvailable(false),
+m_instanceBufferVersion(0)
 {
 
 }
@@ -41,39 +39,47 @@ void SceneLayer::OnAttach()
 	const SC::App* app = SC::App::Instance();
 	m_gui = SC::GUI::Create(app->GetRenderer(), app->GetWindowHandle());
 
-	m_shaderEffect = SC::ShaderEffect::Builder("data/shaders/diffuse.vert.spv", "data/shaders/diffuse.frag.spv")
-		.AddPushConstant("modelPush", { {SC::ShaderStage::VERTEX}, sizeof(MeshPushConstants) })
+	//Object transforms come from the scene's instance buffer so objects sharing a mesh and material are drawn together
+	m_shaderEffect = SC::ShaderEffect::Builder("data/shaders/diffuseInstanced.vert.spv", "data/shaders/diffuse.frag.spv")
 		.AddSet("textureData",
 			{
 				{ SC::DescriptorBindingType::SAMPLER, {SC::ShaderStage::FRAGMENT}}, //Diffuse
 				{ SC::DescriptorBindingType::SAMPLER, {SC::ShaderStage::FRAGMENT}}, //Spec
 				{ SC::DescriptorBindingType::SAMPLER, {SC::ShaderStage::FRAGMENT}}, //Alpha
-				{ SC::DescriptorBindingType::UNIFORM, {SC::ShaderStage::FRAGMENT}}, //Shader Data
+				{ SC::DescriptorBindingType::UNIFORM_DYNAMIC, {SC::ShaderStage::FRAGMENT}}, //Shader Data
 			})
 			.SetTextureSetIndex(0)
-		.AddSet("sceneData", { { SC::DescriptorBindingType::UNIFORM, {SC::ShaderStage::VERTEX, SC::ShaderStage::FRAGMENT} } })
+		.AddSet("sceneData", { { SC::DescriptorBindingType::UNIFORM_DYNAMIC, {SC::ShaderStage::VERTEX, SC::ShaderStage::FRAGMENT} } })
+		.AddSet("instanceData", { { SC::DescriptorBindingType::STORAGE_DYNAMIC, {SC::ShaderStage::VERTEX} } })
 		.Build();
 
 	m_shaderPass.Build(m_shaderEffect, SC::FaceCulling::FRONT);
 
-	m_sceneDescriptorSet = SC::FrameData<SC::DescriptorSet>::Create(m_shaderEffect.GetDescriptorSetLayout(1));
-	for (uint8_t i = 0; i < m_sceneDescriptorSet.FrameCount(); ++i)
-	{
-		SC::Buffer* buffer = m_scene.GetSceneUniformBuffer(i);
-		SC::DescriptorSet* descriptorSet = m_sceneDescriptorSet.GetFrameData(i);
+	//One set each, the frame's data is picked with a dynamic offset when binding. The scene uniforms are allocated from the
+	//frame allocator every frame so their set points at the start of its buffer and the allocation's offset is passed instead
+	m_sceneDescriptorSet = SC::DescriptorSet::Create(m_shaderEffect.GetDescriptorSetLayout(1));
+	m_sceneDescriptorSet->SetBuffer(app->GetRenderer()->GetFrameAllocator().GetBuffer(), 0, 0, sizeof(SC::SceneUbo));
 
-		descriptorSet->SetBuffer(buffer, 0);
-	}
+	CreateInstanceDescriptorSet();
+
+	//One secondary command buffer per thread for the scene and one more for the GUI when recording in parallel
+	app->GetRenderer()->ReserveSecondaryCommandBuffers(m_threadPool.ThreadCount() + 1);
+
+	m_gpuCullingAvailable = m_scene.InitGpuCulling("data/shaders/cull.comp.spv");
+	if (!m_gpuCullingAvailable)
+		SC::Log::Print("Gpu culling is unavailable", SC::LogSeverity::LogWarning);
 
 	SC::EffectTemplate effectTemplate;
 	effectTemplate.passShaders[SC::MeshpassType::Forward] = &m_shaderPass;
 	m_materialSystem.AddEffectTemplate("default", effectTemplate);
 
-	helmetRoot = m_scene.LoadModel("data/models/helmet/DamagedHelmet.modl", &m_materialSystem);
+	//The helmet keeps its geometry so mouse picking hits its triangles, Sponza is only picked by the bounds of its meshes
+	//which saves keeping its vertices and building a triangle BVH for every one of them
+	helmetRoot = m_scene.LoadModel("data/models/helmet/DamagedHelmet.modl", &m_materialSystem, true, &m_threadPool);
 	helmetRoot->GetTransform().SetRotation(glm::vec3(1, 0, 0), glm::radians(90.0f));
 	helmetRoot->GetTransform().SetScale(glm::vec3(3.0f));
 
-	sponzaRoot = m_scene.LoadModel("data/models/sponza/sponza.modl", &m_materialSystem);
+	sponzaRoot = m_scene.LoadModel("data/models/sponza/sponza.modl", &m_materialSystem, false, &m_threadPool);
 
 	m_scene.GetSceneData().Lights[0].position = glm::normalize(m_lightDir);
 	m_scene.GetSceneData().Lights[0].intensities = glm::vec4(0.9f, 0.6f, 0.4f, 1.0f);
@@ -92,6 +98,14 @@ void SceneLayer::OnAttach()
 	m_scene.GetSceneData().LightCount = 4;
 }
 
+void SceneLayer::CreateInstanceDescriptorSet()
+{
+	const SC::PerFrameBuffer& instanceBuffer = m_scene.GetInstanceBuffer();
+	m_instanceDescriptorSet = SC::DescriptorSet::Create(m_shaderEffect.GetDescriptorSetLayout(2));
+	m_instanceDescriptorSet->SetBuffer(instanceBuffer.GetBuffer(), 0, 0, instanceBuffer.Size());
+	m_instanceBufferVersion = m_scene.GetInstanceBufferVersion();
+}
+
 void SceneLayer::OnDetach()
 {
 	m_scene.Reset();
@@ -126,35 +140,68 @@ void SceneLayer::OnUpdate(float deltaTime)
 	commandBuffer.ResetCommands();
 	commandBuffer.BeginRecording();
 
-	commandBuffer.BeginRenderPass(renderer->DefaultRenderPass(), renderer->DefaultRenderTarget(), .4f, .4f, .4f);
+	m_scene.Update(m_parallelTransforms ? &m_threadPool : nullptr);
+
+	//Mip levels are streamed before the materials are bound so draws use the new images
+	m_scene.UpdateTextureStreaming(static_cast<uint32_t>(windowWidth), static_cast<uint32_t>(windowHeight));
+	m_materialSystem.UpdateTextureSets();
+
+	//Compute work can't be recorded inside a render pass
+	m_scene.DispatchCulling(renderer);
+
+	//The instance buffer is recreated when the scene outgrows it, the set bound by earlier frames still points at the old one
+	if (m_scene.GetInstanceBufferVersion() != m_instanceBufferVersion)
+		CreateInstanceDescriptorSet();
+
+	//Material parameters are updated up front so the draw callback doesn't write to them, it can run on several threads
+	for (const auto& mat : m_materialSystem.Materials())
+		mat.second->parameters.Update(renderer->FrameDataIndex());
 
-	//Not optimal as we create a viewport object each frame but will do for demo
-	commandBuffer.SetViewport(SC::Viewport(0, 0, static_cast<float>(windowWidth), static_cast<float>(windowHeight)));
-	commandBuffer.SetScissor(SC::Scissor(windowWidth, windowHeight));
+	//Secondary command buffers are the only thing recorded inside the render pass when recording in parallel
+	const bool parallelRecording = m_parallelRecording;
+	commandBuffer.BeginRenderPass(renderer->DefaultRenderPass(), renderer->DefaultRenderTarget(), .4f, .4f, .4f, 1.0f,
+		parallelRecording ? SC::SubpassContents::SECONDARY_COMMAND_BUFFERS : SC::SubpassContents::INLINE);
 
-	commandBuffer.BindPipeline(m_shaderPass.GetPipeline());
+	//Pick whatever is under the mouse
+	float mouseX{ 0 }, mouseY{ 0 };
+	SC::Input::GetMousePos(mouseX, mouseY);
+	const SC::Ray mouseRay = SC::Ray::FromScreenPoint(mouseX, mouseY, static_cast<float>(windowWidth), static_cast<float>(windowHeight), m_scene.GetSceneData().ViewMatrix);
 
-	m_scene.Root().UpdateSelfAndChildren();
+	const auto pickStart = std::chrono::high_resolution_clock::now();
+	SC::RaycastHit pickHit;
+	const bool picked = m_scene.Raycast(mouseRay, pickHit);
+	const auto pickEnd = std::chrono::high_resolution_clock::now();
 
-	m_scene.DrawObjects(renderer, [=, &commandBuffer](const SC::RenderObject& renderObject, bool pipelineChanged)
+	const auto PerRenderObject = [=](SC::CommandBuffer& objectCommandBuffer, const SC::RenderObject& renderObject, bool pipelineChanged, bool materialChanged)
 		{	//Per object func gets called on each render object
 
 			auto shaderEffect = renderObject.material->original->passShaders[SC::MeshpassType::Forward]->GetShaderEffect();
-			auto textureDescriptorSet = renderObject.material->passSets[SC::MeshpassType::Forward].GetFrameData(renderer->FrameDataIndex());
-
-			//Update matieral paramter buffers
-			renderObject.material->parameters.Update(renderer->FrameDataIndex());
+			const uint8_t frameIndex = renderer->FrameDataIndex();
 
-			commandBuffer.BindDescriptorSet(shaderEffect->GetPipelineLayout(), textureDescriptorSet, 0);
+			if (materialChanged) { //objects are sorted by material so its descriptors only need binding at the start of each run
+				auto textureDescriptorSet = renderObject.material->passSets[SC::MeshpassType::Forward].get();
+				const uint32_t parameterOffset = renderObject.material->parameters.GetBuffer().FrameOffset(frameIndex);
+				objectCommandBuffer.BindDescriptorSet(shaderEffect->GetPipelineLayout(), textureDescriptorSet, 0, &parameterOffset, 1);
+			}
 
-			MeshPushConstants constants;
-			constants.render_matrix = (*renderObject.transform);
-			commandBuffer.PushConstants(m_shaderEffect.GetPipelineLayout(), 0, 0, sizeof(MeshPushConstants), &constants);
+			if (pipelineChanged) { //only bind camera and instance descriptors and set dynamic state if pipeline changed
+				//Not optimal as we create a viewport object each time but will do for demo
+				objectCommandBuffer.SetViewport(SC::Viewport(0, 0, static_cast<float>(windowWidth), static_cast<float>(windowHeight)));
+				objectCommandBuffer.SetScissor(SC::Scissor(windowWidth, windowHeight));
 
-			if (pipelineChanged) { //only bind camera descriptors if pipeline changed
-				commandBuffer.BindDescriptorSet(shaderEffect->GetPipelineLayout(), m_sceneDescriptorSet.GetFrameData(renderer->FrameDataIndex()), 1);
+				const uint32_t sceneOffset = static_cast<uint32_t>(m_scene.GetSceneUniforms().offset);
+				const uint32_t instanceOffset = m_scene.GetInstanceBuffer().FrameOffset(frameIndex);
+				objectCommandBuffer.BindDescriptorSet(shaderEffect->GetPipelineLayout(), m_sceneDescriptorSet.get(), 1, &sceneOffset, 1);
+				objectCommandBuffer.BindDescriptorSet(shaderEffect->GetPipelineLayout(), m_instanceDescriptorSet.get(), 2, &instanceOffset, 1);
 			}
-		});
+		};
+
+	const auto recordStart = std::chrono::high_resolution_clock::now();
+	if (parallelRecording)
+		m_scene.DrawObjectsParallel(renderer, renderer->DefaultRenderPass(), renderer->DefaultRenderTarget(), m_threadPool, PerRenderObject);
+	else
+		m_scene.DrawObjects(renderer, PerRenderObject);
+	const auto recordEnd = std::chrono::high_resolution_clock::now();
 
 
 	m_gui->BeginFrame();
@@ -189,6 +236,63 @@ void SceneLayer::OnUpdate(float deltaTime)
 
 	ImGui::SliderFloat("Zoom", &m_zoom, 1.0f, 100.0f);
 
+	const SC::TransformHierarchy& hierarchy = m_scene.Root().Hierarchy();
+	ImGui::Text("Transforms updated: %u / %u", hierarchy.UpdatedMatrixCount(), hierarchy.NodeCount());
+	ImGui::Checkbox("Parallel transform update", &m_parallelTransforms);
+	ImGui::Checkbox("Parallel recording", &m_parallelRecording);
+	ImGui::Text("Draws recorded in %.3f ms", std::chrono::duration<double, std::milli>(recordEnd - recordStart).count());
+
+	bool frustumCulling = m_scene.FrustumCullingEnabled();
+	if (ImGui::Checkbox("Frustum culling", &frustumCulling))
+		m_scene.SetFrustumCulling(frustumCulling);
+	bool gpuCulling = m_scene.GpuCullingEnabled();
+	if (m_gpuCullingAvailable && ImGui::Checkbox("GPU culling", &gpuCulling))
+		m_scene.SetGpuCulling(gpuCulling);
+	const SC::CullingStats& cullingStats = m_scene.GetCullingStats();
+	ImGui::Text("Objects culled: %u / %u (%u bounds tested)", cullingStats.culled, cullingStats.objects, cullingStats.tested);
+	bool indirectDraws = m_scene.IndirectDrawsEnabled();
+	if (renderer->SupportsMultiDrawIndirect() && ImGui::Checkbox("Indirect draws", &indirectDraws))
+		m_scene.SetIndirectDraws(indirectDraws);
+	const SC::DrawStats& drawStats = m_scene.GetDrawStats();
+	ImGui::Text("Draws: %u (%u instances, %u draw calls)  Binds: %u pipeline, %u material, %u mesh", drawStats.draws, drawStats.instances, drawStats.drawCalls, drawStats.pipelineBinds, drawStats.materialBinds, drawStats.meshBinds);
+	ImGui::Text("Commands: %u recorded, %u redundant filtered", drawStats.commandsRecorded, drawStats.commandsFiltered);
+	const SC::FrameAllocator& frameAllocator = renderer->GetFrameAllocator();
+	ImGui::Text("Frame allocator: %.1f / %.1f KB", frameAllocator.FrameUsed() / 1024.0f, frameAllocator.FrameCapacity() / 1024.0f);
+	const SC::GeometryPool* geometryPool = renderer->GetGeometryPool();
+	ImGui::Text("Geometry pool: %u / %u vertices, %u / %u indices", geometryPool->VerticesUsed(), geometryPool->VertexCapacity(), geometryPool->IndicesUsed(), geometryPool->IndexCapacity());
+	const SC::UploadStats uploadStats = renderer->GetUploadStats();
+	ImGui::Text("Uploads: %llu (%.1f MB) in %llu batches, %llu stalls", static_cast<unsigned long long>(uploadStats.uploads), uploadStats.bytes / (1024.0f * 1024.0f),
+		static_cast<unsigned long long>(uploadStats.batches), static_cast<unsigned long long>(uploadStats.stalls));
+	ImGui::Text("Staging: %.1f MB in use, %.1f MB peak, %.1f MB allocated", uploadStats.stagingInUse / (1024.0f * 1024.0f), uploadStats.stagingPeak / (1024.0f * 1024.0f),
+		uploadStats.stagingAllocated / (1024.0f * 1024.0f));
+
+	SC::TextureStreamer& textureStreamer = m_scene.GetTextureStreamer();
+	const SC::TextureStreamingStats& streamingStats = textureStreamer.GetStats();
+	int streamingBudget = static_cast<int>(textureStreamer.GetMemoryBudget() / (1024 * 1024));
+	if (ImGui::SliderInt("Texture budget (MB)", &streamingBudget, 16, 2048))
+		textureStreamer.SetMemoryBudget(static_cast<size_t>(streamingBudget) * 1024 * 1024);
+	int mipBias = textureStreamer.GetMipBias();
+	if (ImGui::SliderInt("Texture mip bias", &mipBias, -4, 4))
+		textureStreamer.SetMipBias(mipBias);
+	ImGui::Text("Streamed textures: %u, mips %u resident / %u requested, %.1f MB resident / %.1f MB requested", streamingStats.textures,
+		streamingStats.residentMips, streamingStats.requestedMips, streamingStats.residentBytes / (1024.0f * 1024.0f), streamingStats.requestedBytes / (1024.0f * 1024.0f));
+	ImGui::Text("Streaming this frame: %u in, %u evicted, %.1f MB uploaded", streamingStats.streamedIn, streamingStats.evicted, streamingStats.uploadedBytes / (1024.0f * 1024.0f));
+	if (ImGui::CollapsingHeader("Streamed textures", ImGuiTreeNodeFlags_None))
+	{
+		textureStreamer.GetTextureStates(m_streamedTextures);
+		for (const SC::StreamedTextureState& state : m_streamedTextures)
+		{
+			ImGui::Text("%ux%u: %u / %u mips resident, %u requested", state.texture->GetWidth(), state.texture->GetHeight(),
+				state.mipLevels - state.residentMip, state.mipLevels, state.mipLevels - state.requestedMip);
+		}
+	}
+
+	const double pickTime = std::chrono::duration<double, std::micro>(pickEnd - pickStart).count();
+	if (picked)
+		ImGui::Text("Picked node %u triangle %u at %.2f (%.1f us)", pickHit.node->Id(), pickHit.triangle, pickHit.distance, pickTime);
+	else
+		ImGui::Text("Picked nothing (%.1f us)", pickTime);
+
 	ImGui::SliderFloat3("Light Dir", (float*)&m_lightDir.x, -1, 1);
 	ImGui::SliderFloat4("Light Colour", (float*)&m_scene.GetSceneData().Lights[0].intensities, 0, 5);
 
@@ -202,7 +306,21 @@ void SceneLayer::OnUpdate(float deltaTime)
 	ImGui::SliderFloat4("Point Light3 Colour", (float*)&m_scene.GetSceneData().Lights[3].intensities.x, 0, 5);
 	ImGui::End();
 
-	m_gui->EndFrame();
+	if (parallelRecording)
+	{
+		//The last reserved secondary command buffer is left for the GUI
+		SC::CommandBuffer& guiCommandBuffer = renderer->GetFrameSecondaryCommandBuffer(m_threadPool.ThreadCount());
+		guiCommandBuffer.BeginRecording(renderer->DefaultRenderPass(), renderer->DefaultRenderTarget());
+		m_gui->EndFrame(guiCommandBuffer);
+		guiCommandBuffer.EndRecording();
+
+		const SC::CommandBuffer* guiCommandBuffers[] = { &guiCommandBuffer };
+		commandBuffer.ExecuteCommands(guiCommandBuffers, 1);
+	}
+	else
+	{
+		m_gui->EndFrame();
+	}
 
 	commandBuffer.EndRenderPass();
 
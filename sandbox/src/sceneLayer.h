@@ -10,14 +10,18 @@ public:
 	void OnDetach() override;
 	void OnUpdate(float deltaTime) override;
 private:
+	void CreateInstanceDescriptorSet();
+
 	SC::MaterialSystem m_materialSystem;
 	SC::ShaderEffect m_shaderEffect;
 	SC::ShaderPass m_shaderPass;
 	SC::Scene m_scene;
+	SC::ThreadPool m_threadPool;
 
 	std::unique_ptr<SC::GUI> m_gui;
 
-	SC::FrameData<SC::DescriptorSet> m_sceneDescriptorSet;
+	std::unique_ptr<SC::DescriptorSet> m_sceneDescriptorSet;
+	std::unique_ptr<SC::DescriptorSet> m_instanceDescriptorSet;
 
 	SC::SceneNode* helmetRoot;
 	SC::SceneNode* sponzaRoot;
@@ -25,6 +29,11 @@ private:
 	float m_globalShiniess;
 	float m_globalSpecStrength;
 	float m_zoom;
+	bool m_parallelTransforms;
+	bool m_parallelRecording;
+	bool m_gpuCullingAvailable;
+	uint32_t m_instanceBufferVersion;
 	glm::vec4 m_lightDir;
+	std::vector<SC::StreamedTextureState> m_streamedTextures;
 };
 